@@ -9,9 +9,14 @@
 */
 
 #include "GpioBackend.h"
+#include "HardwareTrace.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstring>
 #include <fstream>
+#include <thread>
 
 namespace
 {
@@ -156,14 +161,62 @@ namespace
  #include <fcntl.h>
  #include <unistd.h>
  #if __has_include(<linux/i2c-dev.h>)
+  #include <linux/i2c.h>
   #include <linux/i2c-dev.h>
   #include <sys/ioctl.h>
   #define GPIO_BACKEND_HAS_I2C 1
  #else
   #define GPIO_BACKEND_HAS_I2C 0
  #endif
+ #if __has_include(<linux/gpio.h>)
+  #include <linux/gpio.h>
+ #endif
+ #if defined (GPIO_V2_GET_LINE_IOCTL)
+  #include <poll.h>
+  #include <sys/ioctl.h>
+  #define GPIO_BACKEND_HAS_CHARDEV 1
+ #else
+  #define GPIO_BACKEND_HAS_CHARDEV 0
+ #endif
 #endif
 
+namespace
+{
+   #if JUCE_LINUX && GPIO_BACKEND_HAS_I2C
+    // ADS1115 registers and config bits
+    constexpr uint8_t adsConversionRegister = 0x00;
+    constexpr uint8_t adsConfigRegister = 0x01;
+    constexpr uint8_t adsLoThreshRegister = 0x02;
+    constexpr uint8_t adsHiThreshRegister = 0x03;
+
+    static float normaliseAdcSample (const uint8_t* data)
+    {
+        const int16_t raw = static_cast<int16_t> ((data[0] << 8) | data[1]);
+        const float normalised = static_cast<float> (raw + 32768) / 65535.0f;
+        return juce::jlimit (0.0f, 1.0f, normalised);
+    }
+
+    static uint8_t adcDataRateBits (int samplesPerSecond)
+    {
+        constexpr int rates[] = { 8, 16, 32, 64, 128, 250, 475, 860 };
+
+        for (uint8_t i = 0; i < 8; ++i)
+            if (rates[i] >= samplesPerSecond)
+                return i;
+
+        return 7;
+    }
+
+    // continuous mode, +-2.048 V, ALERT/RDY pulses low after every conversion
+    static void makeContinuousConfig (uint8_t* reg, int channel, int dataRate)
+    {
+        reg[0] = adsConfigRegister;
+        reg[1] = static_cast<uint8_t> (0x84 | (((0x04 + channel) & 0x07) << 4));
+        reg[2] = static_cast<uint8_t> (adcDataRateBits (dataRate) << 5);
+    }
+   #endif
+}
+
 GpioBackend::GpioBackend()
     : GpioBackend (Config {})
 {
@@ -184,27 +237,68 @@ bool GpioBackend::initialise()
     if (initialised)
         return true;
 
+    if (config.replayTraceFile != juce::File())
+    {
+        replay = std::make_unique<HardwareTrace::Reader> (config.replayTraceFile);
+
+        if (! replay->loadedOk())
+        {
+            DBG ("GpioBackend: can't read the trace " << config.replayTraceFile.getFullPathName());
+            replay.reset();
+            return false;
+        }
+
+        replayPosition = 0;
+        replayState = {};
+        replayStartSeconds = juce::Time::getMillisecondCounterHiRes() * 0.001;
+        writtenLedBits = 0;
+        ledStatesKnown = true;
+        initialised = true;
+        return true;
+    }
+
 #if JUCE_LINUX
-    gpioLed1Resolved = resolveGpioPin (config.gpioLed1, config.useBoardPinNumbers);
-    gpioLed2Resolved = resolveGpioPin (config.gpioLed2, config.useBoardPinNumbers);
-    gpioLed3Resolved = resolveGpioPin (config.gpioLed3, config.useBoardPinNumbers);
-
-    gpioFootswitch1Resolved = resolveGpioPin (config.gpioFootswitch1, config.useBoardPinNumbers);
-    gpioFootswitch2Resolved = resolveGpioPin (config.gpioFootswitch2, config.useBoardPinNumbers);
-    gpioFootswitch3Resolved = resolveGpioPin (config.gpioFootswitch3, config.useBoardPinNumbers);
-
-    const auto gpioReady = configureGpioDirection (gpioFootswitch1Resolved, "in")
-                        && configureGpioDirection (gpioFootswitch2Resolved, "in")
-                        && configureGpioDirection (gpioFootswitch3Resolved, "in")
-                        && configureGpioActiveLow (gpioFootswitch1Resolved, true)
-                        && configureGpioActiveLow (gpioFootswitch2Resolved, true)
-                        && configureGpioActiveLow (gpioFootswitch3Resolved, true)
-                        && configureGpioDirection (gpioLed1Resolved, "out")
-                        && configureGpioDirection (gpioLed2Resolved, "out")
-                        && configureGpioDirection (gpioLed3Resolved, "out")
-                        && writeGpioValue (gpioLed1Resolved, false)
-                        && writeGpioValue (gpioLed2Resolved, false)
-                        && writeGpioValue (gpioLed3Resolved, false);
+    ledPins.clear();
+    footswitchPins.clear();
+
+    for (int i = 0; i < getNumLeds(); ++i)
+        ledPins.push_back (resolveGpioPin (config.gpioLeds[(size_t) i], config.useBoardPinNumbers));
+
+    for (int i = 0; i < getNumSwitches(); ++i)
+        footswitchPins.push_back (resolveGpioPin (config.gpioFootswitches[(size_t) i], config.useBoardPinNumbers));
+
+    adcReadyResolved = resolveGpioPin (config.adcReadyPin, config.useBoardPinNumbers);
+
+    usingCharacterDevice = config.gpioInterface == Config::GpioInterface::characterDevice
+                            && initialiseCharacterDevice();
+
+    if (config.gpioInterface == Config::GpioInterface::characterDevice && ! usingCharacterDevice)
+        DBG ("GpioBackend: " << config.gpioChip << " not usable, falling back to sysfs");
+
+    auto gpioReady = usingCharacterDevice;
+
+    if (! usingCharacterDevice)
+    {
+        gpioReady = true;
+
+        for (auto pin : footswitchPins)
+            gpioReady = gpioReady && configureGpioDirection (pin, "in") && configureGpioActiveLow (pin, true);
+
+        for (auto pin : ledPins)
+            gpioReady = gpioReady && configureGpioDirection (pin, "out") && writeGpioValue (pin, false);
+
+        for (auto pin : ledPins)
+            ledValueFds.push_back (::open ((juce::String ("/sys/class/gpio/gpio") + juce::String (pin) + "/value").toRawUTF8(),
+                                           O_WRONLY | O_CLOEXEC));
+
+        for (auto pin : footswitchPins)
+            footswitchValueFds.push_back (::open ((juce::String ("/sys/class/gpio/gpio") + juce::String (pin) + "/value").toRawUTF8(),
+                                                  O_RDONLY | O_CLOEXEC));
+    }
+
+    // the LEDs start off, either way
+    writtenLedBits = 0;
+    ledStatesKnown = true;
 
    #if GPIO_BACKEND_HAS_I2C
     i2cFd = ::open (config.i2cDevice.toRawUTF8(), O_RDWR);
@@ -223,6 +317,8 @@ bool GpioBackend::initialise()
     {
         initialised = gpioReady;
     }
+
+    adcContinuous = initialised && startAdcContinuous();
    #else
     initialised = gpioReady;
    #endif
@@ -230,48 +326,60 @@ bool GpioBackend::initialise()
     initialised = true;
 #endif
 
+    if (initialised && config.recordTraceFile != juce::File())
+    {
+        traceWriter = std::make_unique<HardwareTrace::Writer> (config.recordTraceFile, getNumAnalogInputs(), getNumSwitches(), getNumLeds());
+
+        if (! traceWriter->openedOk())
+        {
+            DBG ("GpioBackend: can't record to " << config.recordTraceFile.getFullPathName());
+            traceWriter.reset();
+        }
+    }
+
     return initialised;
 }
 
 void GpioBackend::shutdown()
 {
+    traceWriter.reset();
+    replay.reset();
+
 #if JUCE_LINUX
-    if (gpioLed1Resolved >= 0)
-    {
-        if (juce::File (juce::String ("/sys/class/gpio/gpio") + juce::String (gpioLed1Resolved)).exists())
-            writeTextFile ("/sys/class/gpio/unexport", juce::String (gpioLed1Resolved));
-    }
+    stopAdcContinuous();
 
-    if (gpioLed2Resolved >= 0)
+    if (usingCharacterDevice)
     {
-        if (juce::File (juce::String ("/sys/class/gpio/gpio") + juce::String (gpioLed2Resolved)).exists())
-            writeTextFile ("/sys/class/gpio/unexport", juce::String (gpioLed2Resolved));
+        // the kernel releases the lines together with the request fds, nothing to unexport
+        shutdownCharacterDevice();
+        ledPins.clear();
+        footswitchPins.clear();
     }
 
-    if (gpioLed3Resolved >= 0)
+    for (auto* fds : { &ledValueFds, &footswitchValueFds })
     {
-        if (juce::File (juce::String ("/sys/class/gpio/gpio") + juce::String (gpioLed3Resolved)).exists())
-            writeTextFile ("/sys/class/gpio/unexport", juce::String (gpioLed3Resolved));
-    }
+        for (auto fd : *fds)
+            if (fd >= 0)
+                ::close (fd);
 
-    if (gpioFootswitch1Resolved >= 0)
-    {
-        if (juce::File (juce::String ("/sys/class/gpio/gpio") + juce::String (gpioFootswitch1Resolved)).exists())
-            writeTextFile ("/sys/class/gpio/unexport", juce::String (gpioFootswitch1Resolved));
+        fds->clear();
     }
 
-    if (gpioFootswitch2Resolved >= 0)
+    for (const auto* pins : { &ledPins, &footswitchPins })
     {
-        if (juce::File (juce::String ("/sys/class/gpio/gpio") + juce::String (gpioFootswitch2Resolved)).exists())
-            writeTextFile ("/sys/class/gpio/unexport", juce::String (gpioFootswitch2Resolved));
-    }
+        for (auto pin : *pins)
+        {
+            if (std::find (keptSysfsPins.begin(), keptSysfsPins.end(), pin) != keptSysfsPins.end())
+                continue;
 
-    if (gpioFootswitch3Resolved >= 0)
-    {
-        if (juce::File (juce::String ("/sys/class/gpio/gpio") + juce::String (gpioFootswitch3Resolved)).exists())
-            writeTextFile ("/sys/class/gpio/unexport", juce::String (gpioFootswitch3Resolved));
+            if (pin >= 0 && juce::File (juce::String ("/sys/class/gpio/gpio") + juce::String (pin)).exists())
+                writeTextFile ("/sys/class/gpio/unexport", juce::String (pin));
+        }
     }
 
+    ledPins.clear();
+    footswitchPins.clear();
+
    #if GPIO_BACKEND_HAS_I2C
     if (i2cFd >= 0)
     {
@@ -282,6 +390,37 @@ void GpioBackend::shutdown()
 #endif
 
     initialised = false;
+    ledStatesKnown = false;
+}
+
+bool GpioBackend::reconfigure (Config newConfig)
+{
+    if (! initialised)
+    {
+        config = std::move (newConfig);
+        return true;
+    }
+
+   #if JUCE_LINUX
+    // exporting a sysfs line takes a while (udev has to set its permissions first). Only worth
+    // it if sysfs stays in use: a line that is still exported can't be requested as a character device.
+    const auto staysOnSysfs = ! usingCharacterDevice
+                               && newConfig.gpioInterface == Config::GpioInterface::sysfs;
+
+    if (staysOnSysfs && newConfig.replayTraceFile == juce::File())
+        for (const auto* pins : { &newConfig.gpioLeds, &newConfig.gpioFootswitches })
+            for (auto pin : *pins)
+                keptSysfsPins.push_back (resolveGpioPin (pin, newConfig.useBoardPinNumbers));
+   #endif
+
+    shutdown();
+
+   #if JUCE_LINUX
+    keptSysfsPins.clear();
+   #endif
+
+    config = std::move (newConfig);
+    return initialise();
 }
 
 bool GpioBackend::isInitialised() const
@@ -289,24 +428,217 @@ bool GpioBackend::isInitialised() const
     return initialised;
 }
 
-bool GpioBackend::pollInputs (InputState& state)
+bool GpioBackend::pollInputs (InputState& state, bool includeAnalog)
 {
     if (! initialised)
         return false;
 
     state.timestampSeconds = juce::Time::getMillisecondCounterHiRes() * 0.001;
-    return pollInputsImpl (state);
+
+    if (replay != nullptr)
+    {
+        const auto ok = pollReplay (state, includeAnalog);
+        state.switchEdgeSeconds = switchEdgeSeconds;
+        return ok;
+    }
+
+    if (! pollInputsImpl (state, includeAnalog))
+        return false;
+
+    // edge events carry their own time (see readFootswitchEvents)
+    if (state.switchBits != lastPolledSwitchBits && ! hasInputEvents())
+        switchEdgeSeconds = state.timestampSeconds;
+
+    lastPolledSwitchBits = state.switchBits;
+    state.switchEdgeSeconds = switchEdgeSeconds;
+
+    if (traceWriter != nullptr)
+        traceWriter->writeInput (state, includeAnalog);
+
+    return true;
+}
+
+bool GpioBackend::pollReplay (InputState& state, bool includeAnalog)
+{
+    const auto& records = replay->getRecords();
+    uint32_t pressedSincePoll = 0;
+
+    if (config.replaySpeed <= 0.0)
+    {
+        // stepped: one input record per poll, with the recorded time
+        while (replayPosition < records.size() && records[replayPosition].type != HardwareTrace::Record::Type::input)
+            ++replayPosition;
+
+        if (replayPosition < records.size())
+        {
+            const auto& input = records[replayPosition++].input;
+
+            if (input.switchBits != replayState.switchBits)
+                switchEdgeSeconds = input.timestampSeconds;
+
+            replayState = input;
+        }
+
+        state.timestampSeconds = replayState.timestampSeconds;
+    }
+    else
+    {
+        const auto traceTime = getReplayTimeSeconds();
+
+        for (; replayPosition < records.size() && records[replayPosition].timeSeconds <= traceTime; ++replayPosition)
+        {
+            if (records[replayPosition].type != HardwareTrace::Record::Type::input)
+                continue;
+
+            const auto& record = records[replayPosition];
+
+            // the recorded time, on this run's clock
+            if (record.input.switchBits != replayState.switchBits)
+                switchEdgeSeconds = replayStartSeconds + record.timeSeconds / config.replaySpeed;
+
+            // like the edge events: a tap that was over before this poll still counts as one press
+            replayState = record.input;
+            pressedSincePoll |= replayState.switchBits;
+        }
+    }
+
+    if (includeAnalog)
+        state.analog = replayState.analog;
+
+    state.switchBits = replayState.switchBits | pressedSincePoll;
+    return true;
+}
+
+void GpioBackend::flushTrace()
+{
+    if (traceWriter != nullptr)
+        traceWriter->flush();
 }
 
-bool GpioBackend::setLedStates (bool led1On, bool led2On, bool led3On)
+double GpioBackend::getReplayTimeSeconds() const
+{
+    return (juce::Time::getMillisecondCounterHiRes() * 0.001 - replayStartSeconds) * config.replaySpeed;
+}
+
+bool GpioBackend::hasReplayFinished() const
+{
+    return replay != nullptr && replayPosition >= replay->getRecords().size();
+}
+
+int GpioBackend::getNumAnalogInputs() const
+{
+    if (replay != nullptr)
+        return replay->getNumAnalogInputs();
+
+    return juce::jlimit (0, maxAnalogInputs, config.numAnalogInputs);
+}
+
+int GpioBackend::getNumSwitches() const
+{
+    if (replay != nullptr)
+        return replay->getNumSwitches();
+
+    return juce::jmin (maxSwitches, static_cast<int> (config.gpioFootswitches.size()));
+}
+
+int GpioBackend::getNumLeds() const
+{
+    if (replay != nullptr)
+        return replay->getNumLeds();
+
+    return juce::jmin (maxLeds, static_cast<int> (config.gpioLeds.size()));
+}
+
+bool GpioBackend::setLedStates (uint32_t ledBits)
 {
     if (! initialised)
         return false;
 
-    return setLedStatesImpl (led1On, led2On, led3On);
+    ledBits &= getNumLeds() < 32 ? (1u << getNumLeds()) - 1u : ~0u;
+
+    const auto changedBits = ledStatesKnown ? ledBits ^ writtenLedBits : ~0u;
+
+    if (changedBits == 0)
+        return true;
+
+    // after a failed write the state on the pins is unknown, so the next call writes them all
+    ledStatesKnown = setLedStatesImpl (ledBits, changedBits);
+    writtenLedBits = ledBits;
+
+    if (traceWriter != nullptr)
+        traceWriter->writeLeds (ledBits, juce::Time::getMillisecondCounterHiRes() * 0.001);
+
+    return ledStatesKnown;
 }
 
-bool GpioBackend::pollInputsImpl (InputState& state)
+GpioBackend::InputEvent GpioBackend::waitForInputEvent (double timeoutMs)
+{
+    timeoutMs = juce::jmax (0.0, timeoutMs);
+
+    if (replay != nullptr && config.replaySpeed > 0.0)
+    {
+        // wake up for the next recorded switch change, as an edge event would
+        const auto& records = replay->getRecords();
+        const auto horizon = getReplayTimeSeconds() + timeoutMs * 0.001 * config.replaySpeed;
+
+        for (auto i = replayPosition; i < records.size() && records[i].timeSeconds <= horizon; ++i)
+        {
+            const auto& r = records[i];
+
+            if (r.type == HardwareTrace::Record::Type::input && r.input.switchBits != replayState.switchBits)
+            {
+                const auto waitMs = (r.timeSeconds - getReplayTimeSeconds()) * 1000.0 / config.replaySpeed;
+                std::this_thread::sleep_for (std::chrono::duration<double, std::milli> (juce::jmax (0.0, waitMs)));
+                return InputEvent::footswitch;
+            }
+        }
+    }
+
+   #if JUCE_LINUX && GPIO_BACKEND_HAS_CHARDEV
+    if (initialised && usingCharacterDevice && (footswitchLinesFd >= 0 || adcContinuous))
+    {
+        using Clock = std::chrono::steady_clock;
+        const auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration> (std::chrono::duration<double, std::milli> (timeoutMs));
+
+        pollfd fds[2] = { { footswitchLinesFd, POLLIN, 0 }, { adcContinuous ? adcReadyLineFd : -1, POLLIN, 0 } };
+
+        for (;;)
+        {
+            const auto ns = juce::jmax<long long> (0, std::chrono::duration_cast<std::chrono::nanoseconds> (deadline - Clock::now()).count());
+            const timespec timeout { static_cast<time_t> (ns / 1000000000), static_cast<long> (ns % 1000000000) };
+
+            if (::ppoll (fds, 2, &timeout, nullptr) <= 0)
+                return InputEvent::none;
+
+            if ((fds[0].revents & POLLIN) != 0)
+                return InputEvent::footswitch;
+
+            // ADC samples are taken here, one I2C transaction each; only a completed round wakes the caller
+            if ((fds[1].revents & POLLIN) != 0)
+            {
+                gpio_v2_line_event events[16];
+
+                if (::read (adcReadyLineFd, events, sizeof (events)) > 0 && serviceAdc())
+                    return InputEvent::analog;
+            }
+        }
+    }
+   #endif
+
+    std::this_thread::sleep_for (std::chrono::duration<double, std::milli> (timeoutMs));
+    return InputEvent::none;
+}
+
+bool GpioBackend::hasInputEvents() const
+{
+   #if JUCE_LINUX
+    return usingCharacterDevice;
+   #else
+    return false;
+   #endif
+}
+
+bool GpioBackend::pollInputsImpl (InputState& state, bool includeAnalog)
 {
    #if JUCE_LINUX && GPIO_BACKEND_HAS_I2C
     auto readAdcChannel = [this] (int muxBits, float fallback)
@@ -334,39 +666,334 @@ bool GpioBackend::pollInputsImpl (InputState& state)
         if (::read (i2cFd, data, 2) != 2)
             return fallback;
 
-        const int16_t raw = static_cast<int16_t> ((data[0] << 8) | data[1]);
-        const float normalised = static_cast<float> (raw + 32768) / 65535.0f;
-        return juce::jlimit (0.0f, 1.0f, normalised);
+        return normaliseAdcSample (data);
     };
 
-    state.poti1 = readAdcChannel (0x04, state.poti1);
-    state.poti2 = readAdcChannel (0x05, state.poti2);
+    if (includeAnalog && adcContinuous)
+    {
+        state.analog = adcValues;
+    }
+    else if (includeAnalog)
+    {
+        for (int i = 0; i < getNumAnalogInputs(); ++i)
+            state.analog[(size_t) i] = readAdcChannel (0x04 + i, state.analog[(size_t) i]);
+    }
+
+    if (usingCharacterDevice)
+    {
+        readFootswitchEvents();
+
+        // a tap that was over before this poll still counts as one press
+        state.switchBits = switchDownBits | switchPressedSincePollBits;
+        switchPressedSincePollBits = 0;
+        return true;
+    }
+
+    state.switchBits = 0;
 
-    state.footswitch1 = readGpioValue (gpioFootswitch1Resolved, false);
-    state.footswitch2 = readGpioValue (gpioFootswitch2Resolved, false);
-    state.footswitch3 = readGpioValue (gpioFootswitch3Resolved, false);
+    for (size_t i = 0; i < footswitchPins.size(); ++i)
+    {
+        char value = '0';
+        const auto isDown = i < footswitchValueFds.size() && footswitchValueFds[i] >= 0
+                              ? ::pread (footswitchValueFds[i], &value, 1, 0) == 1 && value == '1'
+                              : readGpioValue (footswitchPins[i], false);
+
+        if (isDown)
+            state.switchBits |= 1u << i;
+    }
 
     return true;
    #else
     const auto t = static_cast<float> (state.timestampSeconds);
-    state.poti1 = 0.5f + 0.5f * std::sin (t * 0.25f);
-    state.poti2 = 0.5f + 0.5f * std::sin (t * 0.17f + 1.1f);
 
-    state.footswitch1 = (static_cast<int> (t) % 8) == 0;
-    state.footswitch2 = (static_cast<int> (t) % 13) == 0;
-    state.footswitch3 = (static_cast<int> (t) % 21) == 0;
+    if (includeAnalog)
+        for (int i = 0; i < getNumAnalogInputs(); ++i)
+            state.analog[(size_t) i] = 0.5f + 0.5f * std::sin (t * (0.25f - 0.08f * (float) i) + 1.1f * (float) i);
+
+    static constexpr int pressPeriods[] { 8, 13, 21, 34, 55 };
+    state.switchBits = 0;
+
+    for (int i = 0; i < getNumSwitches(); ++i)
+        if ((static_cast<int> (t) % pressPeriods[i % 5]) == 0)
+            state.switchBits |= 1u << i;
+
     return true;
    #endif
 }
 
-bool GpioBackend::setLedStatesImpl (bool led1On, bool led2On, bool led3On)
+bool GpioBackend::setLedStatesImpl (uint32_t ledBits, uint32_t changedBits)
 {
 #if JUCE_LINUX
-    const auto ok1 = writeGpioValue (gpioLed1Resolved, led1On);
-    const auto ok2 = writeGpioValue (gpioLed2Resolved, led2On);
-    const auto ok3 = writeGpioValue (gpioLed3Resolved, led3On);
-    return ok1 && ok2 && ok3;
+   #if GPIO_BACKEND_HAS_CHARDEV
+    if (usingCharacterDevice)
+    {
+        gpio_v2_line_values values {};
+        values.mask = ((1ull << ledPins.size()) - 1) & changedBits;
+        values.bits = ledBits & values.mask;
+        return ledLinesFd >= 0 && ::ioctl (ledLinesFd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) >= 0;
+    }
+   #endif
+
+    auto ok = true;
+
+    for (size_t i = 0; i < ledPins.size(); ++i)
+    {
+        if (((changedBits >> i) & 1u) == 0)
+            continue;
+
+        const auto on = ((ledBits >> i) & 1u) != 0;
+
+        if (i < ledValueFds.size() && ledValueFds[i] >= 0)
+            ok = ::pwrite (ledValueFds[i], on ? "1" : "0", 1, 0) == 1 && ok;
+        else
+            ok = writeGpioValue (ledPins[i], on) && ok;
+    }
+
+    return ok;
 #else
+    juce::ignoreUnused (ledBits, changedBits);
+    return true;
+#endif
+}
+
+#if JUCE_LINUX
+bool GpioBackend::initialiseCharacterDevice()
+{
+   #if GPIO_BACKEND_HAS_CHARDEV
+    for (auto pin : footswitchPins)
+        if (pin < 0)
+            return false;
+
+    for (auto pin : ledPins)
+        if (pin < 0)
+            return false;
+
+    gpioChipFd = ::open (config.gpioChip.toRawUTF8(), O_RDWR | O_CLOEXEC);
+
+    if (gpioChipFd < 0)
+        return false;
+
+    // line i of a request is bit i of its values
+    auto requestLines = [this] (const std::vector<int>& pins, const char* consumer, uint64_t flags, int debounceMicros)
+    {
+        gpio_v2_line_request request {};
+
+        if (pins.empty())
+            return -1;
+
+        for (auto pin : pins)
+            request.offsets[request.num_lines++] = static_cast<uint32_t> (pin);
+
+        std::strncpy (request.consumer, consumer, sizeof (request.consumer) - 1);
+        request.config.flags = flags;
+
+        if (debounceMicros > 0)
+        {
+            request.config.num_attrs = 1;
+            request.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_DEBOUNCE;
+            request.config.attrs[0].attr.debounce_period_us = static_cast<uint32_t> (debounceMicros);
+            request.config.attrs[0].mask = (1ull << request.num_lines) - 1;
+        }
+
+        return ::ioctl (gpioChipFd, GPIO_V2_GET_LINE_IOCTL, &request) >= 0 ? request.fd : -1;
+    };
+
+    // active low like the sysfs setup, so a pressed switch reads 1 and its press is a rising edge
+    footswitchLinesFd = requestLines (footswitchPins, "pfx-footswitch",
+                                      GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_ACTIVE_LOW
+                                        | GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING,
+                                      config.footswitchDebounceMicros);
+
+    ledLinesFd = requestLines (ledPins, "pfx-led", GPIO_V2_LINE_FLAG_OUTPUT, 0);
+
+    if ((footswitchLinesFd < 0 && ! footswitchPins.empty()) || (ledLinesFd < 0 && ! ledPins.empty()))
+    {
+        shutdownCharacterDevice();
+        return false;
+    }
+
+    // optional: without it the ADC is read single-shot from every poll
+    if (adcReadyResolved >= 0)
+    {
+        gpio_v2_line_request request {};
+        request.offsets[0] = static_cast<uint32_t> (adcReadyResolved);
+        request.num_lines = 1;
+        std::strncpy (request.consumer, "pfx-adc-ready", sizeof (request.consumer) - 1);
+        request.config.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_FALLING;
+
+        if (::ioctl (gpioChipFd, GPIO_V2_GET_LINE_IOCTL, &request) >= 0)
+            adcReadyLineFd = request.fd;
+    }
+
+    gpio_v2_line_values values {};
+    values.mask = (1ull << footswitchPins.size()) - 1;
+    switchDownBits = 0;
+
+    if (footswitchLinesFd >= 0 && ::ioctl (footswitchLinesFd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) >= 0)
+        switchDownBits = static_cast<uint32_t> (values.bits);
+
+    switchPressedSincePollBits = 0;
     return true;
+   #else
+    return false;
+   #endif
+}
+
+void GpioBackend::shutdownCharacterDevice()
+{
+    for (auto* fd : { &footswitchLinesFd, &ledLinesFd, &adcReadyLineFd, &gpioChipFd })
+    {
+        if (*fd >= 0)
+        {
+            ::close (*fd);
+            *fd = -1;
+        }
+    }
+
+    usingCharacterDevice = false;
+}
+
+void GpioBackend::readFootswitchEvents()
+{
+   #if GPIO_BACKEND_HAS_CHARDEV
+    if (footswitchLinesFd < 0)
+        return;
+
+    pollfd pfd { footswitchLinesFd, POLLIN, 0 };
+
+    while (::poll (&pfd, 1, 0) > 0 && (pfd.revents & POLLIN) != 0)
+    {
+        gpio_v2_line_event events[16];
+        const auto numBytes = ::read (footswitchLinesFd, events, sizeof (events));
+
+        if (numBytes <= 0)
+            break;
+
+        for (size_t e = 0; e < static_cast<size_t> (numBytes) / sizeof (gpio_v2_line_event); ++e)
+        {
+            for (size_t i = 0; i < footswitchPins.size(); ++i)
+            {
+                if (static_cast<int> (events[e].offset) != footswitchPins[i])
+                    continue;
+
+                const auto bit = 1u << i;
+
+                // CLOCK_MONOTONIC, the clock behind Time::getMillisecondCounterHiRes()
+                switchEdgeSeconds = static_cast<double> (events[e].timestamp_ns) * 1.0e-9;
+
+                if (events[e].id == GPIO_V2_LINE_EVENT_RISING_EDGE)
+                {
+                    switchDownBits |= bit;
+                    switchPressedSincePollBits |= bit;
+                }
+                else
+                {
+                    switchDownBits &= ~bit;
+                }
+            }
+        }
+    }
+   #endif
+}
 #endif
+
+#if JUCE_LINUX
+bool GpioBackend::startAdcContinuous()
+{
+   #if GPIO_BACKEND_HAS_I2C && GPIO_BACKEND_HAS_CHARDEV
+    adcSchedule = config.adcChannelSchedule;
+
+    if (adcSchedule.empty())
+        for (int i = 0; i < getNumAnalogInputs(); ++i)
+            adcSchedule.push_back (i);
+
+    if (i2cFd < 0 || adcReadyLineFd < 0 || adcSchedule.empty())
+        return false;
+
+    for (auto channel : adcSchedule)
+    {
+        if (channel < 0 || channel >= getNumAnalogInputs())
+        {
+            DBG ("GpioBackend: ADC channel " << channel << " isn't one of the inputs, falling back to single-shot reads");
+            return false;
+        }
+    }
+
+    // thresholds with the MSBs 0 and 1 turn the comparator into a conversion-ready signal
+    const uint8_t loThresh[3] = { adsLoThreshRegister, 0x00, 0x00 };
+    const uint8_t hiThresh[3] = { adsHiThreshRegister, 0x80, 0x00 };
+
+    uint8_t configReg[3];
+    makeContinuousConfig (configReg, adcSchedule.front(), config.adcDataRate);
+
+    if (::write (i2cFd, loThresh, 3) != 3 || ::write (i2cFd, hiThresh, 3) != 3 || ::write (i2cFd, configReg, 3) != 3)
+        return false;
+
+    adcScheduleIndex = 0;
+    adcDiscardNext = true;
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+void GpioBackend::stopAdcContinuous()
+{
+   #if GPIO_BACKEND_HAS_I2C
+    if (adcContinuous && i2cFd >= 0)
+    {
+        // back to the power-on default: single-shot and powered down
+        const uint8_t defaultConfig[3] = { adsConfigRegister, 0x85, 0x83 };
+        ::write (i2cFd, defaultConfig, 3);
+    }
+   #endif
+
+    adcContinuous = false;
+}
+
+bool GpioBackend::serviceAdc()
+{
+   #if GPIO_BACKEND_HAS_I2C
+    const auto& schedule = adcSchedule;
+    const auto nextIndex = (adcScheduleIndex + 1) % schedule.size();
+
+    // the sample that just finished, and if the next conversion is on another channel the
+    // config switch, go out as one combined I2C transaction
+    const auto switchChannel = ! adcDiscardNext && schedule[nextIndex] != schedule[adcScheduleIndex];
+
+    uint8_t pointer = adsConversionRegister;
+    uint8_t data[2] = { 0, 0 };
+    uint8_t configReg[3];
+    makeContinuousConfig (configReg, schedule[nextIndex], config.adcDataRate);
+
+    const auto address = static_cast<uint16_t> (config.i2cAddress);
+
+    i2c_msg messages[3] =
+    {
+        { address, 0,        1, &pointer },
+        { address, I2C_M_RD, 2, data },
+        { address, 0,        3, configReg }
+    };
+
+    i2c_rdwr_ioctl_data transaction { messages, switchChannel ? 3u : 2u };
+
+    if (::ioctl (i2cFd, I2C_RDWR, &transaction) < 0)
+        return false;
+
+    // the conversion running while the channel was switched still belongs to the old one
+    if (adcDiscardNext)
+    {
+        adcDiscardNext = false;
+        return false;
+    }
+
+    adcValues[static_cast<size_t> (schedule[adcScheduleIndex])] = normaliseAdcSample (data);
+    adcScheduleIndex = nextIndex;
+    adcDiscardNext = switchChannel;
+
+    return adcScheduleIndex == 0;
+   #else
+    return false;
+   #endif
 }
+#endif
@@ -11,33 +11,77 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace HardwareTrace
+{
+    class Writer;
+    class Reader;
+}
 
 class GpioBackend
 {
 public:
+    static constexpr int maxAnalogInputs = 4;   // ADS1115 AIN0-AIN3
+    static constexpr int maxSwitches = 32;
+    static constexpr int maxLeds = 32;
+
     struct Config
     {
+        // characterDevice: /dev/gpiochipN line requests with kernel debounce and edge events.
+        // sysfs: the deprecated /sys/class/gpio interface, also used if the character device can't be opened.
+        enum class GpioInterface
+        {
+            characterDevice,
+            sysfs
+        };
+
+        GpioInterface gpioInterface = GpioInterface::characterDevice;
+        juce::String gpioChip = "/dev/gpiochip0";
+        int footswitchDebounceMicros = 5000;
+
         juce::String i2cDevice = "/dev/i2c-1";
         int i2cAddress = 0x48;
         bool useBoardPinNumbers = true;
 
-        int gpioLed1 = 7;
-        int gpioLed2 = 11;
-        int gpioLed3 = 17;
-
-        int gpioFootswitch1 = 9;
-        int gpioFootswitch2 = 13;
-        int gpioFootswitch3 = 15;
+        // one pin per control, in board order; the LED next to a footswitch has the same index
+        std::vector<int> gpioLeds { 7, 11, 17 };
+        std::vector<int> gpioFootswitches { 9, 13, 15 };
+
+        // pots on ADS1115 AIN0 upwards
+        int numAnalogInputs = 2;
+
+        // ADS1115: with its ALERT/RDY pin wired to a GPIO (character device only) the ADC converts
+        // continuously and every sample is read when it is ready; otherwise single-shot reads per poll.
+        // The schedule lists the AIN channel of each conversion and may repeat a channel to sample it
+        // more often; empty means each input once, in order. Rates: 8, 16, 32, 64, 128, 250, 475 or 860 SPS.
+        int adcReadyPin = -1;
+        int adcDataRate = 860;
+        std::vector<int> adcChannelSchedule;
+
+        // Record: every input change and LED write goes to this trace (see HardwareTrace).
+        // Replay: the inputs come from this trace instead of the hardware, on any platform;
+        // the board layout is the recorded one. A speed of 1 replays in real time, 2 twice
+        // as fast, and 0 steps one record per poll, independent of timing.
+        juce::File recordTraceFile;
+        juce::File replayTraceFile;
+        double replaySpeed = 1.0;
     };
 
+    // fixed size so that polling never allocates; only the first getNumAnalogInputs() values are used
     struct InputState
     {
-        float poti1 = 0.0f;
-        float poti2 = 0.0f;
-        bool footswitch1 = false;
-        bool footswitch2 = false;
-        bool footswitch3 = false;
+        std::array<float, maxAnalogInputs> analog {};
+        uint32_t switchBits = 0;    // bit i set while footswitch i is down
         double timestampSeconds = 0.0;
+
+        // when switchBits last changed: the kernel's edge time with edge events,
+        // otherwise the poll that saw the change (same clock as timestampSeconds)
+        double switchEdgeSeconds = 0.0;
+
+        bool isSwitchDown (int index) const { return ((switchBits >> index) & 1u) != 0; }
     };
 
     GpioBackend();
@@ -46,27 +90,105 @@ public:
 
     bool initialise();
     void shutdown();
+
+    // Swaps the configuration, re-initialising a running backend. If the old and the new
+    // configuration both use sysfs, pins that are still used stay exported, so only the lines
+    // that changed are touched.
+    bool reconfigure (Config newConfig);
+    const Config& getConfig() const { return config; }
     bool isInitialised() const;
 
-    bool pollInputs (InputState& state);
-    bool setLedStates (bool led1On, bool led2On, bool led3On);
+    // the board as configured, clamped to what the backend supports
+    int getNumAnalogInputs() const;
+    int getNumSwitches() const;
+    int getNumLeds() const;
+
+    // includeAnalog = false only refreshes the footswitches, e.g. right after an edge event
+    bool pollInputs (InputState& state, bool includeAnalog = true);
+    // bit i: LED i on; only the LEDs that changed since the last call are written
+    bool setLedStates (uint32_t ledBits);
+
+    enum class InputEvent
+    {
+        none,           // timed out
+        footswitch,     // a footswitch edge
+        analog          // the ADC has been through its channel schedule once more
+    };
+
+    // blocks until a footswitch edge or a new round of ADC samples arrives, or the timeout has passed.
+    // Without edge events (sysfs) this just sleeps for the timeout.
+    InputEvent waitForInputEvent (double timeoutMs);
+
+    bool hasInputEvents() const;
+
+    bool isReplaying() const { return replay != nullptr; }
+    bool hasReplayFinished() const;
+
+    // writes the records of a trace being recorded through to the file
+    void flushTrace();
+
+    // what the LEDs were last set to, e.g. to compare a replay with its recording
+    uint32_t getLedStates() const { return writtenLedBits; }
 
 private:
     Config config;
     bool initialised = false;
 
+    std::unique_ptr<HardwareTrace::Writer> traceWriter;
+    std::unique_ptr<HardwareTrace::Reader> replay;
+    size_t replayPosition = 0;
+    double replayStartSeconds = 0.0;
+    InputState replayState;
+
+    bool pollReplay (InputState& state, bool includeAnalog);
+    double getReplayTimeSeconds() const;
+
+    uint32_t writtenLedBits = 0;
+    bool ledStatesKnown = false;
+
+    uint32_t lastPolledSwitchBits = 0;
+    double switchEdgeSeconds = 0.0;
+
    #if JUCE_LINUX
     int i2cFd = -1;
 
-    int gpioLed1Resolved = -1;
-    int gpioLed2Resolved = -1;
-    int gpioLed3Resolved = -1;
-
-    int gpioFootswitch1Resolved = -1;
-    int gpioFootswitch2Resolved = -1;
-    int gpioFootswitch3Resolved = -1;
+    std::vector<int> ledPins;
+    std::vector<int> footswitchPins;
+
+    // sysfs: the value files stay open, one fd per LED and footswitch
+    std::vector<int> ledValueFds;
+    std::vector<int> footswitchValueFds;
+
+    // sysfs pins that shutdown() leaves exported, because a reconfigure is about to use them again
+    std::vector<int> keptSysfsPins;
+    int adcReadyResolved = -1;
+
+    // character device: one line request for the footswitches (edges + debounce), one for the LEDs
+    bool usingCharacterDevice = false;
+    int gpioChipFd = -1;
+    int footswitchLinesFd = -1;
+    int ledLinesFd = -1;
+
+    uint32_t switchDownBits = 0;
+    uint32_t switchPressedSincePollBits = 0;
+
+    // continuous ADC conversion, serviced from waitForInputEvent() on every ALERT/RDY edge
+    int adcReadyLineFd = -1;
+    bool adcContinuous = false;
+    bool adcDiscardNext = true;
+    std::vector<int> adcSchedule;
+    size_t adcScheduleIndex = 0;
+    std::array<float, maxAnalogInputs> adcValues {};
+
+    bool initialiseCharacterDevice();
+    void shutdownCharacterDevice();
+    void readFootswitchEvents();
+
+    bool startAdcContinuous();
+    void stopAdcContinuous();
+    bool serviceAdc();
    #endif
 
-    bool pollInputsImpl (InputState& state);
-    bool setLedStatesImpl (bool led1On, bool led2On, bool led3On);
+    bool pollInputsImpl (InputState& state, bool includeAnalog);
+    bool setLedStatesImpl (uint32_t ledBits, uint32_t changedBits);
 };
@@ -10,6 +10,8 @@
 
 #include "HardwareCalibration.h"
 
+#include <cmath>
+
 namespace Hardware
 {
     float applyCalibration (float raw, const AnalogCalibration& calibration)
@@ -33,4 +35,64 @@ namespace Hardware
 
         return juce::jlimit (0.0f, 1.0f, normalised);
     }
+
+    void AnalogInputFilter::reset()
+    {
+        initialised = false;
+    }
+
+    bool AnalogInputFilter::process (float input, double timestampSeconds, const AnalogCalibration& calibration)
+    {
+        input = juce::jlimit (0.0f, 1.0f, input);
+
+        auto smoothingFactor = [] (float cutoffHz, float dt)
+        {
+            const auto tau = 1.0f / (juce::MathConstants<float>::twoPi * juce::jmax (0.001f, cutoffHz));
+            return 1.0f / (1.0f + tau / dt);
+        };
+
+        if (! initialised)
+        {
+            initialised = true;
+            filtered = input;
+            filteredSpeed = 0.0f;
+        }
+        else
+        {
+            // samples without a usable time step (a replayed trace, a clock hiccup) count as one poll at 100 Hz
+            const auto elapsed = static_cast<float> (timestampSeconds - lastTimestamp);
+            const auto dt = elapsed > 0.0f && elapsed < 1.0f ? elapsed : 0.01f;
+
+            const auto speed = (input - previousInput) / dt;
+            filteredSpeed += smoothingFactor (calibration.derivativeCutoffHz, dt) * (speed - filteredSpeed);
+
+            const auto cutoff = calibration.minCutoffHz + calibration.speedCoefficient * std::abs (filteredSpeed);
+            filtered += smoothingFactor (cutoff, dt) * (input - filtered);
+        }
+
+        lastTimestamp = timestampSeconds;
+        previousInput = input;
+
+        auto candidate = filtered;
+
+        if (calibration.quantisationSteps > 0)
+        {
+            const auto steps = static_cast<float> (calibration.quantisationSteps);
+            candidate = std::round (filtered * steps) / steps;
+        }
+
+        candidate = juce::jlimit (0.0f, 1.0f, candidate);
+
+        // the ends are always reachable, even from within the hysteresis band
+        const auto isEnd = candidate == 0.0f || candidate == 1.0f;
+        const auto threshold = juce::jmax (calibration.hysteresis,
+                                           calibration.quantisationSteps > 0 ? 1.0f / static_cast<float> (calibration.quantisationSteps) : 0.0f);
+
+        if (candidate == published || (! isEnd && std::abs (filtered - published) < threshold && changeCount > 0))
+            return false;
+
+        published = candidate;
+        ++changeCount;
+        return true;
+    }
 }
@@ -20,38 +20,43 @@ namespace Hardware
         float maxRaw = 1.0f;
         float deadZone = 0.0f;
         bool invert = false;
+
+        // 1-euro filter: a still pot is smoothed down to minCutoffHz, a moving one follows
+        // faster the quicker it turns (speedCoefficient, in Hz per full turn per second)
+        float minCutoffHz = 1.0f;
+        float speedCoefficient = 5.0f;
+        float derivativeCutoffHz = 1.0f;
+
+        // the published value only moves once the filtered one is this far away from it,
+        // and then in steps of 1 / quantisationSteps (0: not quantised)
+        float hysteresis = 0.002f;
+        int quantisationSteps = 1024;
     };
 
-    class SmoothedAnalogValue
+    // Filters one analog input and decides when its value has changed enough to be passed on,
+    // so that a noisy pot at rest doesn't keep nudging parameters, editors and DSP.
+    class AnalogInputFilter
     {
     public:
-        void reset (float initialValue = 0.0f)
-        {
-            current = juce::jlimit (0.0f, 1.0f, initialValue);
-            initialised = true;
-        }
-
-        float process (float input, float alpha)
-        {
-            input = juce::jlimit (0.0f, 1.0f, input);
-            alpha = juce::jlimit (0.0f, 1.0f, alpha);
-
-            if (! initialised)
-            {
-                reset (input);
-                return current;
-            }
-
-            current += alpha * (input - current);
-            current = juce::jlimit (0.0f, 1.0f, current);
-            return current;
-        }
-
-        float getCurrent() const { return current; }
+        void reset();
+
+        // returns true if getValue() changed
+        bool process (float input, double timestampSeconds, const AnalogCalibration& calibration);
+
+        float getValue() const { return published; }
+        float getFiltered() const { return filtered; }
+
+        // counts the changes of getValue(), so a consumer can tell whether anything moved
+        uint32_t getChangeCount() const { return changeCount; }
 
     private:
-        float current = 0.0f;
         bool initialised = false;
+        double lastTimestamp = 0.0;
+        float previousInput = 0.0f;
+        float filtered = 0.0f;
+        float filteredSpeed = 0.0f;
+        float published = 0.0f;
+        uint32_t changeCount = 0;
     };
 
     float applyCalibration (float raw, const AnalogCalibration& calibration);
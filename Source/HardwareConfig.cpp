@@ -0,0 +1,268 @@
+/*
+  ==============================================================================
+
+    HardwareConfig.cpp
+    Created: 17 Oct 2026 1:47:32pm
+    Author:  motzi
+
+  ==============================================================================
+*/
+
+#include "HardwareConfig.h"
+
+namespace
+{
+    static void readInt (const juce::var& object, const char* key, int& value)
+    {
+        const auto& v = object[key];
+
+        if (v.isString())
+        {
+            const auto text = v.toString().trim();
+            value = text.startsWithIgnoreCase ("0x") ? text.substring (2).getHexValue32() : text.getIntValue();
+        }
+        else if (! v.isVoid())
+        {
+            value = static_cast<int> (v);
+        }
+    }
+
+    template <typename FloatType>
+    static void readFloat (const juce::var& object, const char* key, FloatType& value)
+    {
+        if (const auto& v = object[key]; ! v.isVoid())
+            value = static_cast<FloatType> (static_cast<double> (v));
+    }
+
+    static void readBool (const juce::var& object, const char* key, bool& value)
+    {
+        if (const auto& v = object[key]; ! v.isVoid())
+            value = static_cast<bool> (v);
+    }
+
+    static void readString (const juce::var& object, const char* key, juce::String& value)
+    {
+        if (const auto& v = object[key]; ! v.isVoid())
+            value = v.toString();
+    }
+
+    static juce::Result readIntList (const juce::var& object, const char* key, std::vector<int>& values)
+    {
+        const auto& v = object[key];
+
+        if (v.isVoid())
+            return juce::Result::ok();
+
+        const auto* array = v.getArray();
+
+        if (array == nullptr)
+            return juce::Result::fail (juce::String ("\"") + key + "\" must be a list of numbers");
+
+        values.clear();
+
+        for (const auto& item : *array)
+            values.push_back (static_cast<int> (item));
+
+        return juce::Result::ok();
+    }
+
+    // every LED is a pin number, or an object with its pin and how it looks while it is on
+    static juce::Result readLeds (const juce::var& object, std::vector<int>& pins, std::vector<LedScheduler::Pattern>& patterns)
+    {
+        const auto& v = object["leds"];
+
+        if (v.isVoid())
+            return juce::Result::ok();
+
+        const auto* array = v.getArray();
+
+        if (array == nullptr)
+            return juce::Result::fail ("\"leds\" must be a list");
+
+        pins.clear();
+        patterns.clear();
+
+        for (const auto& item : *array)
+        {
+            if (! item.isObject())
+            {
+                pins.push_back (static_cast<int> (item));
+                patterns.push_back (LedScheduler::Pattern::steady());
+                continue;
+            }
+
+            if (item["pin"].isVoid())
+                return juce::Result::fail ("Every LED in \"leds\" needs a \"pin\"");
+
+            int pin = -1;
+            float brightness = 1.0f;
+            double blinkMs = 0.0;
+            readInt (item, "pin", pin);
+            readFloat (item, "brightness", brightness);
+            readFloat (item, "blinkMs", blinkMs);
+
+            auto pattern = LedScheduler::Pattern::blink (blinkMs * 0.001);
+            pattern.brightness = juce::jlimit (0.0f, 1.0f, brightness);
+
+            pins.push_back (pin);
+            patterns.push_back (pattern);
+        }
+
+        return juce::Result::ok();
+    }
+
+    static void readFile (const juce::var& object, const char* key, const juce::File& baseDirectory, juce::File& file)
+    {
+        if (const auto& v = object[key]; ! v.isVoid())
+            file = v.toString().isEmpty() ? juce::File() : baseDirectory.getChildFile (v.toString());
+    }
+}
+
+namespace HardwareConfig
+{
+    juce::Result parse (const juce::String& json, const juce::File& baseDirectory, HardwareInputService::Settings& settings)
+    {
+        juce::var root;
+        const auto parsed = juce::JSON::parse (json, root);
+
+        if (parsed.failed())
+            return parsed;
+
+        if (! root.isObject())
+            return juce::Result::fail ("The hardware config must be a JSON object");
+
+        readInt (root, "pollIntervalMs", settings.pollIntervalMs);
+
+        auto& config = settings.backendConfig;
+
+        if (const auto& gpio = root["gpio"]; gpio.isObject())
+        {
+            if (const auto& gpioInterface = gpio["interface"]; ! gpioInterface.isVoid())
+            {
+                if (gpioInterface.toString() == "characterDevice")
+                    config.gpioInterface = GpioBackend::Config::GpioInterface::characterDevice;
+                else if (gpioInterface.toString() == "sysfs")
+                    config.gpioInterface = GpioBackend::Config::GpioInterface::sysfs;
+                else
+                    return juce::Result::fail ("Unknown GPIO interface \"" + gpioInterface.toString() + "\"");
+            }
+
+            if (const auto& numbering = gpio["pinNumbering"]; ! numbering.isVoid())
+            {
+                if (numbering.toString() != "board" && numbering.toString() != "bcm")
+                    return juce::Result::fail ("Unknown pin numbering \"" + numbering.toString() + "\"");
+
+                config.useBoardPinNumbers = numbering.toString() == "board";
+            }
+
+            readString (gpio, "chip", config.gpioChip);
+            readInt (gpio, "debounceMicros", config.footswitchDebounceMicros);
+
+            if (auto r = readIntList (gpio, "footswitches", config.gpioFootswitches); r.failed())
+                return r;
+
+            if (auto r = readLeds (gpio, config.gpioLeds, settings.ledPatterns); r.failed())
+                return r;
+        }
+
+        if (const auto& adc = root["adc"]; adc.isObject())
+        {
+            readString (adc, "device", config.i2cDevice);
+            readInt (adc, "address", config.i2cAddress);
+            readInt (adc, "inputs", config.numAnalogInputs);
+            readInt (adc, "readyPin", config.adcReadyPin);
+            readInt (adc, "dataRate", config.adcDataRate);
+
+            if (auto r = readIntList (adc, "schedule", config.adcChannelSchedule); r.failed())
+                return r;
+
+            // the inputs are the first channels; the schedule can only repeat or reorder them
+            const auto numInputs = juce::jlimit (0, GpioBackend::maxAnalogInputs, config.numAnalogInputs);
+
+            for (auto channel : config.adcChannelSchedule)
+                if (! juce::isPositiveAndBelow (channel, numInputs))
+                    return juce::Result::fail ("ADC channel " + juce::String (channel) + " isn't one of the "
+                                               + juce::String (numInputs) + " inputs");
+        }
+
+        if (const auto& trace = root["trace"]; trace.isObject())
+        {
+            readFile (trace, "record", baseDirectory, config.recordTraceFile);
+            readFile (trace, "replay", baseDirectory, config.replayTraceFile);
+            readFloat (trace, "replaySpeed", config.replaySpeed);
+        }
+
+        if (const auto& pots = root["pots"]; ! pots.isVoid())
+        {
+            const auto* array = pots.getArray();
+
+            if (array == nullptr)
+                return juce::Result::fail ("\"pots\" must be a list");
+
+            settings.analogCalibrations.clear();
+
+            for (const auto& pot : *array)
+            {
+                Hardware::AnalogCalibration c;
+                readFloat (pot, "min", c.minRaw);
+                readFloat (pot, "max", c.maxRaw);
+                readFloat (pot, "deadZone", c.deadZone);
+                readBool (pot, "invert", c.invert);
+                readFloat (pot, "minCutoffHz", c.minCutoffHz);
+                readFloat (pot, "speedCoefficient", c.speedCoefficient);
+                readFloat (pot, "derivativeCutoffHz", c.derivativeCutoffHz);
+                readFloat (pot, "hysteresis", c.hysteresis);
+                readInt (pot, "steps", c.quantisationSteps);
+                settings.analogCalibrations.push_back (c);
+            }
+        }
+
+        return juce::Result::ok();
+    }
+
+    juce::Result load (const juce::File& file, HardwareInputService::Settings& settings)
+    {
+        if (! file.existsAsFile())
+            return juce::Result::fail ("Can't find " + file.getFullPathName());
+
+        return parse (file.loadFileAsString(), file.getParentDirectory(), settings);
+    }
+
+    FileWatcher::FileWatcher (HardwareInputService& s, const juce::File& f)
+        : service (s),
+          file (f),
+          lastModified (f.getLastModificationTime()),
+          lastSize (f.getSize())
+    {
+        startTimer (1000);
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+        stopTimer();
+    }
+
+    juce::Result FileWatcher::reload()
+    {
+        lastModified = file.getLastModificationTime();
+        lastSize = file.getSize();
+
+        // keys that were removed from the file go back to their defaults
+        HardwareInputService::Settings settings;
+        const auto result = load (file, settings);
+
+        if (result.wasOk())
+            service.reconfigure (std::move (settings));
+        else
+            DBG ("HardwareConfig: " << result.getErrorMessage());
+
+        return result;
+    }
+
+    void FileWatcher::timerCallback()
+    {
+        // a file that was saved half-way looks changed again once the editor has finished
+        if (file.getLastModificationTime() != lastModified || file.getSize() != lastSize)
+            reload();
+    }
+}
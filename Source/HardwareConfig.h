@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    HardwareConfig.h
+    Created: 17 Oct 2026 1:47:32pm
+    Author:  motzi
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "HardwareInputService.h"
+
+// The pedal hardware as described by a JSON file, so that a different board or wiring
+// doesn't need a rebuild. Every key is optional and keeps its default when left out:
+//
+//  {
+//    "pollIntervalMs": 10,
+//    "gpio":  { "interface": "characterDevice", "chip": "/dev/gpiochip0", "pinNumbering": "board",
+//               "debounceMicros": 5000, "footswitches": [ 9, 13, 15 ],
+//               "leds": [ 7, { "pin": 11, "brightness": 0.3 }, { "pin": 17, "blinkMs": 500 } ] },
+//    "adc":   { "device": "/dev/i2c-1", "address": "0x48", "inputs": 2,
+//               "readyPin": -1, "dataRate": 860, "schedule": [] },
+//    "trace": { "record": "", "replay": "", "replaySpeed": 1.0 },
+//    "pots":  [ { "min": 0.0, "max": 1.0, "deadZone": 0.0, "invert": false, "minCutoffHz": 1.0,
+//                 "speedCoefficient": 5.0, "derivativeCutoffHz": 1.0, "hysteresis": 0.002, "steps": 1024 } ]
+//  }
+//
+// "interface" is "characterDevice" or "sysfs", "pinNumbering" is "board" or "bcm".
+// An LED is either just its pin, or an object that also sets how it looks while it is on:
+// "brightness" (0..1, dimmed by software PWM) and "blinkMs" (the blink period, 0 for steady).
+// Trace paths are relative to the config file.
+namespace HardwareConfig
+{
+    // on failure the settings may be partly filled in and should not be used
+    juce::Result parse (const juce::String& json, const juce::File& baseDirectory, HardwareInputService::Settings& settings);
+    juce::Result load (const juce::File& file, HardwareInputService::Settings& settings);
+
+    // Checks the file once a second on the message thread and hands every version that
+    // parses to the service, which swaps the backend on its own thread. A broken file is
+    // ignored, so the pedal keeps working while the file is being edited.
+    class FileWatcher final : private juce::Timer
+    {
+    public:
+        FileWatcher (HardwareInputService& service, const juce::File& file);
+        ~FileWatcher() override;
+
+        const juce::File& getFile() const { return file; }
+
+        // applies the file now, whether it changed or not
+        juce::Result reload();
+
+    private:
+        void timerCallback() override;
+
+        HardwareInputService& service;
+        juce::File file;
+        juce::Time lastModified;
+        int64_t lastSize = -1;
+    };
+}
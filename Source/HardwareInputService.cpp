@@ -11,17 +11,22 @@
 #include "HardwareInputService.h"
 #include "Plugins/Fx/FxCommon.h"
 
+#include <chrono>
+#include <thread>
+
 HardwareInputService::HardwareInputService()
     : HardwareInputService (Settings {})
 {
 }
 
 HardwareInputService::HardwareInputService (Settings s)
-    : settings (std::move (s)),
-      backend (settings.backendConfig),
-      poti1Calibration (settings.poti1Calibration),
-      poti2Calibration (settings.poti2Calibration)
+    : juce::Thread ("Hardware I/O"),
+      settings (std::move (s)),
+      backend (settings.backendConfig)
 {
+    applyCalibrations();
+    applyLedPatterns();
+    publishLayout();
 }
 
 HardwareInputService::~HardwareInputService()
@@ -34,78 +39,310 @@ bool HardwareInputService::start()
     if (running.load())
         return true;
 
+    applyPendingSettings();
+
     if (! backend.initialise())
         return false;
 
+    publishLayout();
+
     running.store (true);
-    startTimer (juce::jmax (1, settings.pollIntervalMs));
+
+    // above the message thread, below the audio callback
+    startThread (juce::Thread::Priority::highest);
     return true;
 }
 
 void HardwareInputService::stop()
 {
-    stopTimer();
+    // a poll in progress finishes first; the longest one is a couple of I2C transfers
+    stopThread (1000);
     running.store (false);
     backend.shutdown();
 }
 
-void HardwareInputService::setLedStates (bool led1On, bool led2On, bool led3On)
+void HardwareInputService::reconfigure (Settings newSettings)
 {
-    backend.setLedStates (led1On, led2On, led3On);
+    auto s = std::make_unique<Settings> (std::move (newSettings));
+
+    const juce::SpinLock::ScopedLockType lock (settingsLock);
+    pendingSettings = std::move (s);
+    hasPendingSettings.store (true);
 }
 
-void HardwareInputService::setPoti1Calibration (const Hardware::AnalogCalibration& calibration)
+void HardwareInputService::applyPendingSettings()
 {
-    const juce::ScopedLock lock (calibrationLock);
-    poti1Calibration = calibration;
+    std::unique_ptr<Settings> s;
+
+    {
+        // settings being handed over right now are picked up on the next pass
+        const juce::SpinLock::ScopedTryLockType lock (settingsLock);
+
+        if (! lock.isLocked())
+            return;
+
+        s = std::move (pendingSettings);
+        hasPendingSettings.store (false);
+    }
+
+    if (s == nullptr)
+        return;
+
+    settings = std::move (*s);
+    applyCalibrations();
+    applyLedPatterns();
+
+    for (auto& filter : filters)
+        filter.reset();
+
+    if (! running.load())
+    {
+        backend.reconfigure (settings.backendConfig);
+        return;
+    }
+
+    // the new pins start with all LEDs off, which the backend knows, so the next updateLeds() relights them.
+    // A backend that couldn't be set up keeps failing its polls until a config works; it gets another go here.
+    const auto ok = backend.isInitialised() ? backend.reconfigure (settings.backendConfig)
+                                            : backend.reconfigure (settings.backendConfig) && backend.initialise();
+
+    if (! ok)
+        DBG ("HardwareInputService: the new hardware configuration can't be used");
+
+    publishLayout();
 }
 
-void HardwareInputService::setPoti2Calibration (const Hardware::AnalogCalibration& calibration)
+void HardwareInputService::applyCalibrations()
 {
-    const juce::ScopedLock lock (calibrationLock);
-    poti2Calibration = calibration;
+    const juce::SpinLock::ScopedLockType lock (calibrationLock);
+
+    for (size_t i = 0; i < calibrations.size(); ++i)
+        calibrations[i] = i < settings.analogCalibrations.size() ? settings.analogCalibrations[i]
+                                                                 : Hardware::AnalogCalibration {};
 }
 
-void HardwareInputService::timerCallback()
+void HardwareInputService::applyLedPatterns()
 {
-    if (! running.load())
+    for (int i = 0; i < GpioBackend::maxLeds; ++i)
+        setLedPattern (i, (size_t) i < settings.ledPatterns.size() ? settings.ledPatterns[(size_t) i]
+                                                                   : LedScheduler::Pattern {});
+}
+
+void HardwareInputService::publishLayout()
+{
+    numAnalogInputs.store (backend.getNumAnalogInputs());
+    numSwitches.store (backend.getNumSwitches());
+    numLeds.store (backend.getNumLeds());
+
+    FxCommon::setHardwareLayout ({ numAnalogInputs.load(), numSwitches.load(), numLeds.load() });
+    ledScheduler.setNumLeds (numLeds.load());
+}
+
+HardwareInputService::Snapshot HardwareInputService::getSnapshot() const
+{
+    Snapshot s;
+
+    for (;;)
+    {
+        const auto before = published.sequence.load (std::memory_order_acquire);
+
+        if ((before & 1u) != 0)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        for (size_t i = 0; i < s.analog.size(); ++i)
+            s.analog[i] = published.analog[i].load (std::memory_order_relaxed);
+
+        s.switchBits = published.switchBits.load (std::memory_order_relaxed);
+        s.timestampSeconds = published.timestamp.load (std::memory_order_relaxed);
+        s.changeCounter = published.changeCounter.load (std::memory_order_relaxed);
+
+        std::atomic_thread_fence (std::memory_order_acquire);
+
+        if (published.sequence.load (std::memory_order_relaxed) == before)
+            return s;
+    }
+}
+
+void HardwareInputService::publish (const Snapshot& s)
+{
+    const auto sequence = published.sequence.load (std::memory_order_relaxed);
+    published.sequence.store (sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+
+    for (size_t i = 0; i < s.analog.size(); ++i)
+        published.analog[i].store (s.analog[i], std::memory_order_relaxed);
+
+    published.switchBits.store (s.switchBits, std::memory_order_relaxed);
+    published.timestamp.store (s.timestampSeconds, std::memory_order_relaxed);
+    published.changeCounter.store (s.changeCounter, std::memory_order_relaxed);
+
+    published.sequence.store (sequence + 2, std::memory_order_release);
+}
+
+float HardwareInputService::getAnalogInput (int index) const
+{
+    if (! juce::isPositiveAndBelow (index, GpioBackend::maxAnalogInputs))
+        return 0.0f;
+
+    return getSnapshot().analog[(size_t) index];
+}
+
+void HardwareInputService::setLedStates (uint32_t ledBits)
+{
+    pendingLedStates.store (static_cast<int64_t> (ledBits));
+}
+
+void HardwareInputService::setLedPattern (int ledIndex, const LedScheduler::Pattern& pattern)
+{
+    if (! juce::isPositiveAndBelow (ledIndex, GpioBackend::maxLeds))
+        return;
+
+    const juce::SpinLock::ScopedLockType lock (ledPatternLock);
+    pendingLedPatterns[(size_t) ledIndex] = pattern;
+    pendingLedPatternBits.fetch_or (1u << ledIndex);
+}
+
+void HardwareInputService::setAnalogCalibration (int index, const Hardware::AnalogCalibration& calibration)
+{
+    if (! juce::isPositiveAndBelow (index, GpioBackend::maxAnalogInputs))
         return;
 
+    const juce::SpinLock::ScopedLockType lock (calibrationLock);
+    calibrations[(size_t) index] = calibration;
+}
+
+void HardwareInputService::run()
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr auto traceFlushInterval = std::chrono::seconds (1);
+
+    auto interval = std::chrono::milliseconds (juce::jmax (1, settings.pollIntervalMs));
+    auto nextTick = Clock::now();
+    auto nextTraceFlush = nextTick + traceFlushInterval;
+    auto event = GpioBackend::InputEvent::none;
+
+    while (! threadShouldExit())
+    {
+        if (hasPendingSettings.load())
+        {
+            applyPendingSettings();
+            interval = std::chrono::milliseconds (juce::jmax (1, settings.pollIntervalMs));
+            event = GpioBackend::InputEvent::none;
+            nextTick = Clock::now();
+        }
+
+        // a timeout before the next tick was only for the LEDs
+        const auto isFullPoll = event == GpioBackend::InputEvent::none && Clock::now() >= nextTick;
+
+        if (isFullPoll || event != GpioBackend::InputEvent::none)
+            poll (event != GpioBackend::InputEvent::footswitch);
+
+        // fixed grid instead of sleeping a fixed time after each poll, so the rate doesn't
+        // drift with the poll duration; after an overrun (slow I2C) start a new grid rather than catching up
+        if (isFullPoll)
+        {
+            nextTick += interval;
+
+            if (nextTick < Clock::now())
+                nextTick = Clock::now();
+        }
+
+        const auto ledChangeMs = updateLeds();
+
+        // a trace is wanted most after a crash or a power cut, so it can't wait in the stream's
+        // buffer until shutdown; once a second keeps the sync to the SD card off most polls
+        if (Clock::now() >= nextTraceFlush)
+        {
+            backend.flushTrace();
+            nextTraceFlush = Clock::now() + traceFlushInterval;
+        }
+
+        // with edge events a footswitch wakes the thread at once and only the switches are read;
+        // a continuously converting ADC wakes it whenever every pot has a fresh sample
+        const auto remainingMs = std::chrono::duration<double, std::milli> (nextTick - Clock::now()).count();
+        event = backend.waitForInputEvent (juce::jmin (remainingMs, ledChangeMs));
+    }
+}
+
+void HardwareInputService::poll (bool includeAnalog)
+{
     GpioBackend::InputState raw;
-    if (! backend.pollInputs (raw))
+    if (! backend.pollInputs (raw, includeAnalog))
         return;
 
-    Hardware::AnalogCalibration c1;
-    Hardware::AnalogCalibration c2;
+    std::array<Hardware::AnalogCalibration, GpioBackend::maxAnalogInputs> c;
     {
-        const juce::ScopedLock lock (calibrationLock);
-        c1 = poti1Calibration;
-        c2 = poti2Calibration;
+        const juce::SpinLock::ScopedLockType lock (calibrationLock);
+        c = calibrations;
     }
 
-    const auto p1Cal = Hardware::applyCalibration (raw.poti1, c1);
-    const auto p2Cal = Hardware::applyCalibration (raw.poti2, c2);
+    Snapshot s = lastPublished;
+    uint32_t changedAnalog = 0;
+
+    if (includeAnalog)
+    {
+        for (int i = 0; i < backend.getNumAnalogInputs(); ++i)
+        {
+            auto& filter = filters[(size_t) i];
+            const auto calibrated = Hardware::applyCalibration (raw.analog[(size_t) i], c[(size_t) i]);
+
+            if (filter.process (calibrated, raw.timestampSeconds, c[(size_t) i]))
+            {
+                s.analog[(size_t) i] = filter.getValue();
+                changedAnalog |= 1u << i;
+            }
+        }
+    }
+
+    // nothing worth passing on: readers keep seeing the same snapshot and change counter
+    if (changedAnalog == 0 && raw.switchBits == lastPublished.switchBits && lastPublished.changeCounter != 0)
+        return;
 
-    const auto alpha = juce::jlimit (0.0f, 1.0f, settings.analogSmoothingAlpha);
+    s.switchBits = raw.switchBits;
+    s.timestampSeconds = raw.timestampSeconds;
+    s.changeCounter = lastPublished.changeCounter + 1;
+
+    publish (s);
+    lastPublished = s;
+
+    for (int i = 0; i < backend.getNumAnalogInputs(); ++i)
+        if (((changedAnalog >> i) & 1u) != 0)
+            FxCommon::setHardwareAnalogInput (i, s.analog[(size_t) i], raw.timestampSeconds);
+
+    FxCommon::setHardwareSwitchBits (s.switchBits, raw.switchEdgeSeconds);
+}
+
+double HardwareInputService::updateLeds()
+{
+    const auto now = juce::Time::getMillisecondCounterHiRes() * 0.001;
+
+    if (pendingLedPatternBits.load() != 0)
+    {
+        // a pattern being set right now is picked up on the next pass
+        const juce::SpinLock::ScopedTryLockType lock (ledPatternLock);
+
+        if (lock.isLocked())
+        {
+            const auto bits = pendingLedPatternBits.exchange (0);
+
+            for (int i = 0; i < GpioBackend::maxLeds; ++i)
+                if (((bits >> i) & 1u) != 0)
+                    ledScheduler.setPattern (i, pendingLedPatterns[(size_t) i], now);
+        }
+    }
 
-    const auto p1 = poti1Smoother.process (p1Cal, alpha);
-    const auto p2 = poti2Smoother.process (p2Cal, alpha);
+    auto ledBits = FxCommon::getRequestedHardwareLedBits();
 
-    poti1.store (p1);
-    poti2.store (p2);
+    if (const auto pending = pendingLedStates.exchange (-1); pending >= 0)
+        ledBits = static_cast<uint32_t> (pending);
 
-    fs1.store (raw.footswitch1);
-    fs2.store (raw.footswitch2);
-    fs3.store (raw.footswitch3);
+    ledScheduler.setLitLeds (ledBits, now);
 
-    bool led1 = false;
-    bool led2 = false;
-    bool led3 = false;
-    FxCommon::getRequestedHardwareLedStates(led1, led2, led3);
-    backend.setLedStates (led1, led2, led3);
+    // the backend only writes the LEDs that changed
+    backend.setLedStates (ledScheduler.update (now));
 
-    FxCommon::setHardwareInputSnapshot (p1, p2,
-                                        raw.footswitch1,
-                                        raw.footswitch2,
-                                        raw.footswitch3);
+    return (ledScheduler.getNextChangeSeconds() - now) * 1000.0;
 }
@@ -11,21 +11,42 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <array>
 #include <atomic>
 
 #include "GpioBackend.h"
 #include "HardwareCalibration.h"
+#include "LedScheduler.h"
 
-class HardwareInputService final : private juce::Timer
+// Polls the pedal hardware on its own thread, so that neither a busy message
+// thread delays a footswitch nor a slow I2C transfer delays a repaint.
+// Results are published as a snapshot that any thread can read without locking.
+class HardwareInputService final : private juce::Thread
 {
 public:
     struct Settings
     {
         int pollIntervalMs = 10;
-        float analogSmoothingAlpha = 0.2f;
         GpioBackend::Config backendConfig;
-        Hardware::AnalogCalibration poti1Calibration;
-        Hardware::AnalogCalibration poti2Calibration;
+
+        // one per analog input, including its filtering; inputs without an entry use the defaults
+        std::vector<Hardware::AnalogCalibration> analogCalibrations;
+
+        // one per LED, how it looks while it is on; LEDs without an entry are steady
+        std::vector<LedScheduler::Pattern> ledPatterns;
+    };
+
+    struct Snapshot
+    {
+        std::array<float, GpioBackend::maxAnalogInputs> analog {};
+        uint32_t switchBits = 0;    // bit i set while footswitch i is down
+        double timestampSeconds = 0.0;
+
+        // goes up by one whenever a switch or a filtered pot changes; the snapshot is
+        // only republished then, so an unchanged counter means nothing moved
+        uint32_t changeCounter = 0;
+
+        bool isSwitchDown (int index) const { return ((switchBits >> index) & 1u) != 0; }
     };
 
     HardwareInputService();
@@ -37,37 +58,76 @@ public:
 
     bool isRunning() const { return running.load(); }
 
-    float getPoti1() const { return poti1.load(); }
-    float getPoti2() const { return poti2.load(); }
+    // Replaces the settings, e.g. after the hardware config file changed. The hardware thread
+    // swaps the backend between two polls, so nothing else waits for the GPIO and I2C setup;
+    // while stopped, the settings are used by the next start().
+    void reconfigure (Settings newSettings);
 
-    bool getFootswitch1() const { return fs1.load(); }
-    bool getFootswitch2() const { return fs2.load(); }
-    bool getFootswitch3() const { return fs3.load(); }
+    // consistent set of the last polled values, never blocks the caller
+    Snapshot getSnapshot() const;
 
-    void setLedStates (bool led1On, bool led2On, bool led3On);
+    int getNumAnalogInputs() const { return numAnalogInputs.load(); }
+    int getNumSwitches() const { return numSwitches.load(); }
+    int getNumLeds() const { return numLeds.load(); }
 
-    void setPoti1Calibration (const Hardware::AnalogCalibration& calibration);
-    void setPoti2Calibration (const Hardware::AnalogCalibration& calibration);
+    float getAnalogInput (int index) const;
+    bool getFootswitch (int index) const { return getSnapshot().isSwitchDown (index); }
 
-private:
-    void timerCallback() override;
+    // bit i: LED i on; applied by the hardware thread on its next tick
+    void setLedStates (uint32_t ledBits);
+
+    // how an LED looks while it is on (dimmed, blinking, flashing on a tempo); steady by default
+    void setLedPattern (int ledIndex, const LedScheduler::Pattern& pattern);
 
+    void setAnalogCalibration (int index, const Hardware::AnalogCalibration& calibration);
+
+private:
+    void run() override;
+    void poll (bool includeAnalog);
+    double updateLeds();    // returns the milliseconds until the LEDs next change
+    void publish (const Snapshot& snapshot);
+    void applyPendingSettings();
+    void applyCalibrations();
+    void applyLedPatterns();
+    void publishLayout();
+
+    // owned by the hardware thread while it runs
     Settings settings;
     GpioBackend backend;
 
     std::atomic<bool> running { false };
+    std::atomic<int> numAnalogInputs { 0 }, numSwitches { 0 }, numLeds { 0 };
+
+    juce::SpinLock settingsLock;
+    std::unique_ptr<Settings> pendingSettings;
+    std::atomic<bool> hasPendingSettings { false };
+
+    // seqlock: odd while the hardware thread is writing, readers retry until they see the same even count twice.
+    // Kept on its own cache lines, away from the state only the hardware thread touches.
+    struct alignas(64) PublishedSnapshot
+    {
+        std::atomic<uint32_t> sequence { 0 };
+        std::atomic<uint32_t> switchBits { 0 };
+        std::atomic<double> timestamp { 0.0 };
+        std::atomic<uint32_t> changeCounter { 0 };
+        std::array<std::atomic<float>, GpioBackend::maxAnalogInputs> analog {};
+    };
+
+    PublishedSnapshot published;
+
+    // LED states from setLedStates(), waiting for the hardware thread
+    alignas(64) std::atomic<int64_t> pendingLedStates { -1 };
 
-    std::atomic<float> poti1 { 0.0f };
-    std::atomic<float> poti2 { 0.0f };
+    juce::SpinLock ledPatternLock;
+    std::array<LedScheduler::Pattern, GpioBackend::maxLeds> pendingLedPatterns;
+    std::atomic<uint32_t> pendingLedPatternBits { 0 };
 
-    std::atomic<bool> fs1 { false };
-    std::atomic<bool> fs2 { false };
-    std::atomic<bool> fs3 { false };
+    // only touched by the hardware thread
+    LedScheduler ledScheduler;
 
-    Hardware::SmoothedAnalogValue poti1Smoother;
-    Hardware::SmoothedAnalogValue poti2Smoother;
+    std::array<Hardware::AnalogInputFilter, GpioBackend::maxAnalogInputs> filters;
+    Snapshot lastPublished;
 
-    juce::CriticalSection calibrationLock;
-    Hardware::AnalogCalibration poti1Calibration;
-    Hardware::AnalogCalibration poti2Calibration;
+    juce::SpinLock calibrationLock;
+    std::array<Hardware::AnalogCalibration, GpioBackend::maxAnalogInputs> calibrations;
 };
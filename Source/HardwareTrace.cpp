@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+    HardwareTrace.cpp
+    Created: 17 Oct 2026 11:02:15am
+    Author:  motzi
+
+  ==============================================================================
+*/
+
+#include "HardwareTrace.h"
+
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    constexpr int traceVersion = 1;
+
+    static uint16_t quantise (float value)
+    {
+        return static_cast<uint16_t> (juce::roundToInt (juce::jlimit (0.0f, 1.0f, value) * 65535.0f));
+    }
+}
+
+namespace HardwareTrace
+{
+    Writer::Writer (const juce::File& file, int analogInputs, int numSwitches, int numLeds)
+        : stream (file),
+          numAnalogInputs (juce::jlimit (0, GpioBackend::maxAnalogInputs, analogInputs))
+    {
+        if (! stream.openedOk())
+            return;
+
+        stream.setPosition (0);
+        stream.truncate();
+
+        stream.write ("PFXT", 4);
+        stream.writeInt (traceVersion);
+        stream.writeByte (static_cast<char> (numAnalogInputs));
+        stream.writeByte (static_cast<char> (juce::jlimit (0, GpioBackend::maxSwitches, numSwitches)));
+        stream.writeByte (static_cast<char> (juce::jlimit (0, GpioBackend::maxLeds, numLeds)));
+    }
+
+    void Writer::writeRecordStart (Record::Type type, double timestampSeconds)
+    {
+        if (! hasStarted)
+        {
+            hasStarted = true;
+            startSeconds = timestampSeconds;
+        }
+
+        const auto micros = juce::jmax (lastMicros, static_cast<int64_t> ((timestampSeconds - startSeconds) * 1.0e6));
+
+        hasUnflushedRecords = true;
+
+        stream.writeByte (static_cast<char> (type));
+        stream.writeCompressedInt (static_cast<int> (juce::jmin<int64_t> (micros - lastMicros, std::numeric_limits<int>::max())));
+        lastMicros = micros;
+    }
+
+    void Writer::writeInput (const GpioBackend::InputState& state, bool includesAnalog)
+    {
+        if (! openedOk())
+            return;
+
+        auto analog = lastAnalog;
+
+        if (includesAnalog)
+            for (int i = 0; i < numAnalogInputs; ++i)
+                analog[(size_t) i] = quantise (state.analog[(size_t) i]);
+
+        if (hasInput && state.switchBits == lastSwitchBits && analog == lastAnalog)
+            return;
+
+        hasInput = true;
+        lastSwitchBits = state.switchBits;
+        lastAnalog = analog;
+
+        writeRecordStart (Record::Type::input, state.timestampSeconds);
+        stream.writeInt (static_cast<int> (state.switchBits));
+
+        for (int i = 0; i < numAnalogInputs; ++i)
+            stream.writeShort (static_cast<short> (analog[(size_t) i]));
+    }
+
+    void Writer::writeLeds (uint32_t ledBits, double timestampSeconds)
+    {
+        if (! openedOk())
+            return;
+
+        writeRecordStart (Record::Type::leds, timestampSeconds);
+        stream.writeInt (static_cast<int> (ledBits));
+    }
+
+    void Writer::flush()
+    {
+        if (! openedOk() || ! hasUnflushedRecords)
+            return;
+
+        hasUnflushedRecords = false;
+        stream.flush();
+    }
+
+    Reader::Reader (const juce::File& file)
+    {
+        juce::MemoryBlock data;
+
+        if (! file.loadFileAsData (data))
+            return;
+
+        juce::MemoryInputStream in (data, false);
+
+        char magic[4] = {};
+
+        if (in.read (magic, 4) != 4 || std::memcmp (magic, "PFXT", 4) != 0 || in.readInt() != traceVersion)
+            return;
+
+        numAnalogInputs = juce::jlimit (0, GpioBackend::maxAnalogInputs, static_cast<int> (static_cast<uint8_t> (in.readByte())));
+        numSwitches = juce::jlimit (0, GpioBackend::maxSwitches, static_cast<int> (static_cast<uint8_t> (in.readByte())));
+        numLeds = juce::jlimit (0, GpioBackend::maxLeds, static_cast<int> (static_cast<uint8_t> (in.readByte())));
+
+        int64_t micros = 0;
+
+        // a trace cut off by a crash simply ends at its last complete record
+        while (! in.isExhausted())
+        {
+            Record r;
+            const auto type = static_cast<uint8_t> (in.readByte());
+            micros += juce::jmax (0, in.readCompressedInt());
+            r.timeSeconds = static_cast<double> (micros) * 1.0e-6;
+
+            if (type == static_cast<uint8_t> (Record::Type::input))
+            {
+                if (in.getNumBytesRemaining() < 4 + 2 * numAnalogInputs)
+                    break;
+
+                r.type = Record::Type::input;
+                r.input.switchBits = static_cast<uint32_t> (in.readInt());
+                r.input.timestampSeconds = r.timeSeconds;
+
+                for (int i = 0; i < numAnalogInputs; ++i)
+                    r.input.analog[(size_t) i] = static_cast<float> (static_cast<uint16_t> (in.readShort())) / 65535.0f;
+            }
+            else if (type == static_cast<uint8_t> (Record::Type::leds))
+            {
+                if (in.getNumBytesRemaining() < 4)
+                    break;
+
+                r.type = Record::Type::leds;
+                r.ledBits = static_cast<uint32_t> (in.readInt());
+            }
+            else
+            {
+                break;
+            }
+
+            records.push_back (r);
+        }
+
+        ok = true;
+    }
+}
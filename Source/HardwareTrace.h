@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    HardwareTrace.h
+    Created: 17 Oct 2026 11:02:15am
+    Author:  motzi
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+#include "GpioBackend.h"
+
+// A timestamped recording of what the pedal hardware did, so that a session on the
+// real pedal can be replayed by GpioBackend on any machine, without GPIO or I2C.
+//
+// The file is little endian: "PFXT", a version, the number of pots, switches and LEDs,
+// then one record per change. Each record starts with its type and the time since the
+// previous record in microseconds (JUCE's compressed int), followed by the switch bits
+// and one 16-bit value per pot for an input record, or the LED bits for an LED record.
+namespace HardwareTrace
+{
+    struct Record
+    {
+        enum class Type : uint8_t
+        {
+            input,
+            leds
+        };
+
+        Type type = Type::input;
+        double timeSeconds = 0.0;           // since the first record
+        GpioBackend::InputState input;      // input records; input.timestampSeconds == timeSeconds
+        uint32_t ledBits = 0;               // LED records
+    };
+
+    class Writer
+    {
+    public:
+        Writer (const juce::File& file, int numAnalogInputs, int numSwitches, int numLeds);
+
+        bool openedOk() const { return stream.openedOk(); }
+
+        // written only if the switches or the quantised pots differ from the last input record;
+        // without includesAnalog the pots are taken to be unchanged
+        void writeInput (const GpioBackend::InputState& state, bool includesAnalog = true);
+        void writeLeds (uint32_t ledBits, double timestampSeconds);
+
+        // the records are buffered until this is called; does nothing if none were added since
+        void flush();
+
+    private:
+        void writeRecordStart (Record::Type type, double timestampSeconds);
+
+        juce::FileOutputStream stream;
+        int numAnalogInputs = 0;
+
+        bool hasStarted = false;
+        double startSeconds = 0.0;
+        int64_t lastMicros = 0;
+        bool hasUnflushedRecords = false;
+
+        bool hasInput = false;
+        uint32_t lastSwitchBits = 0;
+        std::array<uint16_t, GpioBackend::maxAnalogInputs> lastAnalog {};
+    };
+
+    class Reader
+    {
+    public:
+        explicit Reader (const juce::File& file);
+
+        bool loadedOk() const { return ok; }
+
+        int getNumAnalogInputs() const { return numAnalogInputs; }
+        int getNumSwitches() const { return numSwitches; }
+        int getNumLeds() const { return numLeds; }
+
+        const std::vector<Record>& getRecords() const { return records; }
+
+    private:
+        bool ok = false;
+        int numAnalogInputs = 0;
+        int numSwitches = 0;
+        int numLeds = 0;
+        std::vector<Record> records;
+    };
+}
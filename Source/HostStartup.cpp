@@ -35,6 +35,7 @@
 #include <JuceHeader.h>
 #include "UI/MainHostWindow.h"
 #include "Plugins/InternalPlugins.h"
+#include "Plugins/GraphJournal.h"
 
 // External plugin formats are optional in this build configuration.
 
@@ -213,10 +214,15 @@ public:
                 fileToOpen = recentFiles.getFile (0);
         }
 
-        if (fileToOpen.existsAsFile())
-            if (auto* graph = mainWindow->graphHolder.get())
-                if (auto* ioGraph = graph->graph.get())
+        if (auto* graph = mainWindow->graphHolder.get())
+        {
+            if (auto* ioGraph = graph->graph.get())
+            {
+                // a journal left behind by a crash or power cut takes precedence
+                if (! ioGraph->startJournal (GraphJournal::getDefaultFile()) && fileToOpen.existsAsFile())
                     ioGraph->loadFrom (fileToOpen, true);
+            }
+        }
     }
 
     void shutdown() override
@@ -0,0 +1,166 @@
+/*
+  ==============================================================================
+
+    LedScheduler.cpp
+    Created: 17 Oct 2026 9:12:40am
+    Author:  motzi
+
+  ==============================================================================
+*/
+
+#include "LedScheduler.h"
+
+#include <cmath>
+
+namespace
+{
+    // calls fn (index) for every set bit, lowest first
+    template <typename Fn>
+    static void forEachSetBit (uint32_t bits, Fn&& fn)
+    {
+        while (bits != 0)
+        {
+            const auto lowest = bits & (~bits + 1u);
+            fn (juce::countNumberOfBits (lowest - 1u));
+            bits &= bits - 1u;
+        }
+    }
+}
+
+LedScheduler::Pattern LedScheduler::Pattern::steady (float brightness)
+{
+    Pattern p;
+    p.brightness = juce::jlimit (0.0f, 1.0f, brightness);
+    return p;
+}
+
+LedScheduler::Pattern LedScheduler::Pattern::blink (double periodSeconds, float dutyCycle, double phaseOriginSeconds)
+{
+    Pattern p;
+    p.blinkPeriodSeconds = juce::jmax (0.0, periodSeconds);
+    p.blinkDutyCycle = juce::jlimit (0.0f, 1.0f, dutyCycle);
+    p.phaseOriginSeconds = phaseOriginSeconds;
+    return p;
+}
+
+LedScheduler::Pattern LedScheduler::Pattern::tempo (double beatsPerMinute, double beatTimeSeconds)
+{
+    const auto period = 60.0 / juce::jlimit (20.0, 400.0, beatsPerMinute);
+
+    // about 60 ms per flash, but never more than half the beat
+    return blink (period, juce::jlimit (0.05f, 0.5f, static_cast<float> (0.06 / period)), beatTimeSeconds);
+}
+
+bool LedScheduler::Pattern::isAnimated() const
+{
+    return brightness > 0.0f && (brightness < 1.0f || blinkPeriodSeconds > 0.0);
+}
+
+void LedScheduler::setNumLeds (int newNumLeds)
+{
+    numLeds = juce::jlimit (0, GpioBackend::maxLeds, newNumLeds);
+
+    const auto mask = numLeds < 32 ? (1u << numLeds) - 1u : ~0u;
+    litBits &= mask;
+    animatedBits &= mask;
+    shownBits &= mask;
+    updateNextChange();
+}
+
+void LedScheduler::setPattern (int ledIndex, const Pattern& pattern, double nowSeconds)
+{
+    if (! juce::isPositiveAndBelow (ledIndex, numLeds))
+        return;
+
+    leds[(size_t) ledIndex].pattern = pattern;
+    schedule (ledIndex, nowSeconds);
+    updateNextChange();
+}
+
+void LedScheduler::setLitLeds (uint32_t ledBits, double nowSeconds)
+{
+    ledBits &= numLeds < 32 ? (1u << numLeds) - 1u : ~0u;
+
+    const auto changed = ledBits ^ litBits;
+
+    if (changed == 0)
+        return;
+
+    litBits = ledBits;
+    forEachSetBit (changed, [&] (int i) { schedule (i, nowSeconds); });
+    updateNextChange();
+}
+
+uint32_t LedScheduler::update (double nowSeconds)
+{
+    if (nowSeconds < nextChangeSeconds)
+        return shownBits;
+
+    forEachSetBit (animatedBits, [&] (int i)
+    {
+        if (leds[(size_t) i].nextChangeSeconds <= nowSeconds)
+            schedule (i, nowSeconds);
+    });
+
+    updateNextChange();
+    return shownBits;
+}
+
+void LedScheduler::schedule (int ledIndex, double nowSeconds)
+{
+    auto& led = leds[(size_t) ledIndex];
+    const auto& p = led.pattern;
+    const auto bit = 1u << ledIndex;
+    const auto isLit = (litBits & bit) != 0;
+
+    led.nextChangeSeconds = std::numeric_limits<double>::infinity();
+
+    if (! isLit || ! p.isAnimated())
+    {
+        led.on = isLit && p.brightness > 0.0f;
+        animatedBits &= ~bit;
+    }
+    else
+    {
+        auto on = true;
+        auto next = std::numeric_limits<double>::infinity();
+
+        if (p.blinkPeriodSeconds > 0.0)
+        {
+            const auto period = p.blinkPeriodSeconds;
+            const auto cycleStart = p.phaseOriginSeconds + std::floor ((nowSeconds - p.phaseOriginSeconds) / period) * period;
+            const auto onUntil = cycleStart + period * p.blinkDutyCycle;
+
+            on = nowSeconds < onUntil;
+            next = on ? onUntil : cycleStart + period;
+        }
+
+        if (on && p.brightness < 1.0f)
+        {
+            const auto frame = 1.0 / pwmFrequencyHz;
+            const auto frameStart = std::floor (nowSeconds / frame) * frame;
+            const auto onUntil = frameStart + frame * p.brightness;
+
+            on = nowSeconds < onUntil;
+            next = juce::jmin (next, on ? onUntil : frameStart + frame);
+        }
+
+        led.on = on;
+
+        // rounding must never schedule the change into the past, or the thread would spin
+        led.nextChangeSeconds = juce::jmax (next, nowSeconds + 1.0e-6);
+        animatedBits |= bit;
+    }
+
+    shownBits = led.on ? (shownBits | bit) : (shownBits & ~bit);
+}
+
+void LedScheduler::updateNextChange()
+{
+    nextChangeSeconds = std::numeric_limits<double>::infinity();
+
+    forEachSetBit (animatedBits, [this] (int i)
+    {
+        nextChangeSeconds = juce::jmin (nextChangeSeconds, leds[(size_t) i].nextChangeSeconds);
+    });
+}
@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    LedScheduler.h
+    Created: 17 Oct 2026 9:12:40am
+    Author:  motzi
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <limits>
+
+#include "GpioBackend.h"
+
+// Works out what the pedal LEDs show, on the hardware thread. An LED is either steady
+// or animated (blinking, or dimmed by software PWM); for the animated ones the scheduler
+// knows when each has to change next, so the thread only wakes up for a real change and
+// steady LEDs cost nothing at all between changes.
+class LedScheduler
+{
+public:
+    struct Pattern
+    {
+        float brightness = 1.0f;            // below 1 the LED is switched at pwmFrequencyHz
+        double blinkPeriodSeconds = 0.0;    // 0: steady
+        float blinkDutyCycle = 0.5f;
+        double phaseOriginSeconds = 0.0;    // a blink starts here, e.g. at the last tap
+
+        static Pattern steady (float brightness = 1.0f);
+        static Pattern blink (double periodSeconds, float dutyCycle = 0.5f, double phaseOriginSeconds = 0.0);
+
+        // a short flash on every beat, lined up with the beat at beatTimeSeconds
+        static Pattern tempo (double beatsPerMinute, double beatTimeSeconds);
+
+        bool isAnimated() const;
+    };
+
+    static constexpr double pwmFrequencyHz = 200.0;
+
+    LedScheduler() = default;
+
+    void setNumLeds (int numLeds);
+
+    void setPattern (int ledIndex, const Pattern& pattern, double nowSeconds);
+
+    // bit i: LED i is lit, following its pattern
+    void setLitLeds (uint32_t ledBits, double nowSeconds);
+
+    // the LED states at the given time; only the animated LEDs that are due are looked at
+    uint32_t update (double nowSeconds);
+
+    // when update() will next return something different, or infinity if nothing is animated
+    double getNextChangeSeconds() const { return nextChangeSeconds; }
+
+private:
+    struct LedState
+    {
+        Pattern pattern;
+        bool on = false;
+        double nextChangeSeconds = std::numeric_limits<double>::infinity();
+    };
+
+    void schedule (int ledIndex, double nowSeconds);
+    void updateNextChange();
+
+    std::array<LedState, GpioBackend::maxLeds> leds;
+    int numLeds = 0;
+
+    uint32_t litBits = 0;
+    uint32_t animatedBits = 0;  // lit LEDs with an animated pattern
+    uint32_t shownBits = 0;
+    double nextChangeSeconds = std::numeric_limits<double>::infinity();
+};
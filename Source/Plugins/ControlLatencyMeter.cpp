@@ -0,0 +1,137 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE framework.
+   Copyright (c) Raw Material Software Limited
+
+   JUCE is an open source framework subject to commercial or open source
+   licensing.
+
+   By downloading, installing, or using the JUCE framework, or combining the
+   JUCE framework with any other source code, object code, content or any other
+   copyrightable work, you agree to the terms of the JUCE End User Licence
+   Agreement, and all incorporated terms including the JUCE Privacy Policy and
+   the JUCE Website Terms of Service, as applicable, which will bind you. If you
+   do not agree to the terms of these agreements, we will not license the JUCE
+   framework to you, and you must discontinue the installation or download
+   process and cease use of the JUCE framework.
+
+   JUCE End User Licence Agreement: https://juce.com/legal/juce-8-licence/
+   JUCE Privacy Policy: https://juce.com/juce-privacy-policy
+   JUCE Website Terms of Service: https://juce.com/juce-website-terms-of-service/
+
+   Or:
+
+   You may also use this code under the terms of the AGPLv3:
+   https://www.gnu.org/licenses/agpl-3.0.en.html
+
+   THE JUCE FRAMEWORK IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL
+   WARRANTIES, WHETHER EXPRESSED OR IMPLIED, INCLUDING WARRANTY OF
+   MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "ControlLatencyMeter.h"
+#include "Fx/FxCommon.h"
+
+//==============================================================================
+ControlLatencyMeter& ControlLatencyMeter::getInstance()
+{
+    static ControlLatencyMeter instance;
+    return instance;
+}
+
+void ControlLatencyMeter::setEnabled (bool shouldBeEnabled) noexcept
+{
+    // events from before the measurement started would only show up as outliers
+    if (shouldBeEnabled && ! isEnabled())
+    {
+        const auto now = Time::getMillisecondCounterHiRes() * 0.001;
+
+        for (auto& h : histograms)
+            h.lastEventSeconds.store (now);
+    }
+
+    enabled.store (shouldBeEnabled);
+}
+
+void ControlLatencyMeter::setOutputLatency (int samples) noexcept
+{
+    outputLatencySamples.store (jmax (0, samples));
+}
+
+void ControlLatencyMeter::beginBlock (int graphLatencySamples, double sampleRate) noexcept
+{
+    if (! isEnabled() || sampleRate <= 0.0)
+        return;
+
+    const auto now = Time::getMillisecondCounterHiRes() * 0.001;
+    const auto delaySamples = graphLatencySamples + outputLatencySamples.load (std::memory_order_relaxed);
+
+    blockOutputSeconds.store (now + delaySamples / sampleRate, std::memory_order_relaxed);
+
+    changeTookEffect (Path::potToAudioBlock, FxCommon::getHardwareAnalogChangeSeconds());
+}
+
+void ControlLatencyMeter::changeTookEffect (Path path, double eventSeconds) noexcept
+{
+    if (! isEnabled() || eventSeconds <= 0.0)
+        return;
+
+    auto& h = histograms[(size_t) path];
+    auto last = h.lastEventSeconds.load (std::memory_order_relaxed);
+
+    // only the first node or worker to apply an event counts it
+    do
+    {
+        if (eventSeconds <= last)
+            return;
+    }
+    while (! h.lastEventSeconds.compare_exchange_weak (last, eventSeconds, std::memory_order_relaxed));
+
+    const auto latencyMs = (blockOutputSeconds.load (std::memory_order_relaxed) - eventSeconds) * 1000.0;
+
+    // a change that only took effect this late wasn't caused by the event (e.g. a bypass clicked on screen)
+    if (latencyMs > 1000.0)
+        return;
+
+    const auto bin = jlimit (0, numBins, (int) (jmax (0.0, latencyMs) / binWidthMs));
+    h.bins[(size_t) bin].fetch_add (1, std::memory_order_relaxed);
+    h.count.fetch_add (1, std::memory_order_relaxed);
+}
+
+//==============================================================================
+void ControlLatencyMeter::reset() noexcept
+{
+    for (auto& h : histograms)
+    {
+        for (auto& b : h.bins)
+            b.store (0);
+
+        h.count.store (0);
+    }
+}
+
+int ControlLatencyMeter::getNumMeasurements (Path path) const noexcept
+{
+    return histograms[(size_t) path].count.load();
+}
+
+bool ControlLatencyMeter::writeCsv (const File& file) const
+{
+    String csv ("latency_ms,footswitch_to_bypass,footswitch_to_snapshot,pot_to_audio_block\n");
+
+    for (int bin = 0; bin <= numBins; ++bin)
+    {
+        csv << (bin < numBins ? String (bin * binWidthMs, 1) : ">" + String (numBins * binWidthMs, 1));
+
+        for (auto& h : histograms)
+            csv << ',' << h.bins[(size_t) bin].load();
+
+        csv << '\n';
+    }
+
+    return file.replaceWithText (csv);
+}
@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE framework.
+   Copyright (c) Raw Material Software Limited
+
+   JUCE is an open source framework subject to commercial or open source
+   licensing.
+
+   By downloading, installing, or using the JUCE framework, or combining the
+   JUCE framework with any other source code, object code, content or any other
+   copyrightable work, you agree to the terms of the JUCE End User Licence
+   Agreement, and all incorporated terms including the JUCE Privacy Policy and
+   the JUCE Website Terms of Service, as applicable, which will bind you. If you
+   do not agree to the terms of these agreements, we will not license the JUCE
+   framework to you, and you must discontinue the installation or download
+   process and cease use of the JUCE framework.
+
+   JUCE End User Licence Agreement: https://juce.com/legal/juce-8-licence/
+   JUCE Privacy Policy: https://juce.com/juce-privacy-policy
+   JUCE Website Terms of Service: https://juce.com/juce-website-terms-of-service/
+
+   Or:
+
+   You may also use this code under the terms of the AGPLv3:
+   https://www.gnu.org/licenses/agpl-3.0.en.html
+
+   THE JUCE FRAMEWORK IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL
+   WARRANTIES, WHETHER EXPRESSED OR IMPLIED, INCLUDING WARRANTY OF
+   MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+//==============================================================================
+/**
+    Measures how long it takes from a footswitch or pot moving to the change
+    being heard, per control path, as a histogram that can be exported as CSV.
+
+    The hardware layer stamps every switch edge and pot change with its time on
+    Time::getMillisecondCounterHiRes()'s clock (with GPIO edge events, the
+    kernel's edge timestamp), and FxCommon passes that time on with the value.
+    At the start of every block the renderer tells the meter when that block
+    will reach the output: now, plus the graph's latency, plus the device's
+    output latency. When a path applies a hardware change on the audio thread,
+    the difference is one measurement.
+
+    Each hardware event is counted once per path, however many nodes it
+    reaches. Everything the audio thread touches is preallocated and atomic,
+    and the measurement costs nothing but a flag check while disabled.
+*/
+class ControlLatencyMeter final
+{
+public:
+    //==============================================================================
+    enum class Path
+    {
+        footswitchToBypass,     // a mapped bypass toggles
+        footswitchToSnapshot,   // the snapshot footswitch recalls the next snapshot
+        potToAudioBlock,        // the first block that sees a pot change
+        numPaths
+    };
+
+    static constexpr double binWidthMs = 0.5;
+    static constexpr int numBins = 200;         // up to 100 ms; one more bin counts everything above
+
+    static ControlLatencyMeter& getInstance();
+
+    //==============================================================================
+    void setEnabled (bool shouldBeEnabled) noexcept;
+    bool isEnabled() const noexcept             { return enabled.load (std::memory_order_relaxed); }
+
+    /** The device's output latency, which the audio callback can't see. Message thread. */
+    void setOutputLatency (int samples) noexcept;
+
+    /** Called on the audio thread at the start of every block. */
+    void beginBlock (int graphLatencySamples, double sampleRate) noexcept;
+
+    /** Called on the audio thread when a path applies a hardware change that happened
+        at eventSeconds. Safe to call from the renderer's workers.
+    */
+    void changeTookEffect (Path, double eventSeconds) noexcept;
+
+    //==============================================================================
+    void reset() noexcept;
+
+    int getNumMeasurements (Path) const noexcept;
+
+    /** One row per bin, one column per path. */
+    bool writeCsv (const File&) const;
+
+private:
+    //==============================================================================
+    ControlLatencyMeter() = default;
+
+    struct Histogram
+    {
+        std::array<std::atomic<int>, numBins + 1> bins {};
+        std::atomic<int> count { 0 };
+        std::atomic<double> lastEventSeconds { 0.0 };
+    };
+
+    std::atomic<bool> enabled { false };
+    std::atomic<int> outputLatencySamples { 0 };
+    std::atomic<double> blockOutputSeconds { 0.0 };
+    std::array<Histogram, (size_t) Path::numPaths> histograms;
+
+    JUCE_DECLARE_NON_COPYABLE (ControlLatencyMeter)
+};
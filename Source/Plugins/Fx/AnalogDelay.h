@@ -27,7 +27,8 @@
 // Einfaches analoges Delay (mono) - Aufbau & UI wie GainProcessor
 //==============================================================================
 
-class AnalogDelay final : public AudioProcessor
+class AnalogDelay final : public AudioProcessor,
+                          public FxCommon::TailRenderer
 {
 public:
     //==============================================================================
@@ -118,12 +119,9 @@ public:
         return static_cast<SampleType>(outLimited);
     }
 
-    void processBlock(AudioBuffer<float>& buffer, MidiBuffer&) override
+    template<typename SampleType>
+    void processChannels(AudioBuffer<SampleType>& buffer)
     {
-        const bool isBypassed = FxCommon::applyMappedBypassFromHardware(this, bypass);
-        if (isBypassed)
-            return;
-
         const int numCh = buffer.getNumChannels();
         const int numSamples = buffer.getNumSamples();
 
@@ -133,36 +131,36 @@ public:
 
         for (int ch = 0; ch < numCh; ++ch)
         {
-            float* data = buffer.getWritePointer(ch);
+            SampleType* data = buffer.getWritePointer(ch);
             for (int i = 0; i < numSamples; ++i)
             {
-                data[i] = processSampleInternal<float>(data[i], ch);
+                data[i] = processSampleInternal<SampleType>(data[i], ch);
             }
         }
     }
 
-    void processBlock(AudioBuffer<double>& buffer, MidiBuffer&) override
+    void processBlock(AudioBuffer<float>& buffer, MidiBuffer&) override
     {
         const bool isBypassed = FxCommon::applyMappedBypassFromHardware(this, bypass);
         if (isBypassed)
             return;
 
-        const int numCh = buffer.getNumChannels();
-        const int numSamples = buffer.getNumSamples();
+        processChannels(buffer);
+    }
 
-        if ((int)fbState.size() < numCh)
-            fbState.resize(numCh, 0.0);
+    void processBlock(AudioBuffer<double>& buffer, MidiBuffer&) override
+    {
+        const bool isBypassed = FxCommon::applyMappedBypassFromHardware(this, bypass);
+        if (isBypassed)
+            return;
 
-        for (int ch = 0; ch < numCh; ++ch)
-        {
-            double* data = buffer.getWritePointer(ch);
-            for (int i = 0; i < numSamples; ++i)
-            {
-                data[i] = processSampleInternal<double>(data[i], ch);
-            }
-        }
+        processChannels(buffer);
     }
 
+    // fuer Ausblenden und Tail im Bypass: das Delay klingt mit den aktuellen Reglern aus
+    void processIgnoringBypass(AudioBuffer<float>& buffer) override { processChannels(buffer); }
+    void processIgnoringBypass(AudioBuffer<double>& buffer) override { processChannels(buffer); }
+
     //==============================================================================
     AudioProcessorEditor* createEditor() override { return new Editor(*this, delay, mix, regen, bypass); }
     bool hasEditor() const override { return true; }
@@ -172,6 +170,7 @@ public:
     bool acceptsMidi() const override { return false; }
     bool producesMidi() const override { return false; }
     double getTailLengthSeconds() const override { return maxDelayMilliseconds / 1000.0; }
+    AudioProcessorParameter* getBypassParameter() const override { return bypass; }
 
     //==============================================================================
     int getNumPrograms() override { return 1; }
@@ -206,7 +205,7 @@ public:
     // Editor: Pedal-styled UI (basierend auf FxCommon::PedalLookAndFeel)
     class Editor final : public AudioProcessorEditor,
                          private Slider::Listener,
-                         private Timer
+                         private FxCommon::UiTick::Subscriber
     {
     public:
         Editor(AnalogDelay& p,
@@ -288,13 +287,13 @@ public:
             pedalLaf.setColour(juce::Slider::rotarySliderFillColourId, Colours::black);
             pedalLaf.setColour(juce::Slider::rotarySliderOutlineColourId, Colours::white);
 
-            startTimerHz(30);
+            FxCommon::UiTick::instance().subscribe(*this, *this);
             setWantsKeyboardFocus(false);
         }
 
         ~Editor() override
         {
-            stopTimer();
+            FxCommon::UiTick::instance().unsubscribe(*this);
             delaySlider.removeListener(this);
             mixSlider.removeListener(this);
             regenSlider.removeListener(this);
@@ -302,6 +301,29 @@ public:
         }
 
         void paint(Graphics& g) override
+        {
+            // der unveraenderliche Teil kommt aus dem Bild-Cache, nur die LED wird jedes Mal gezeichnet
+            pedalLayer.draw(g, getLocalBounds(), [this](Graphics& lg) { paintPedal(lg); });
+
+            const auto footCentre = getFootCentre();
+
+            // LED indicator (rot wenn Effekt aktiviert) - jetzt links neben Footswitch
+            bool isBypassed = (bypassParameter ? static_cast<bool>(*bypassParameter) : false);
+            bool ledOn = !isBypassed;
+            float ledR = 7.0f;
+            // LED links neben den Fußschalter platzieren
+            Point<float> ledPos(footCentre.x - footRadius - 18.0f, footCentre.y);
+            ledArea = FxCommon::getLedRepaintArea(ledPos, ledR);
+            if (ledOn)
+                g.setColour(Colours::red.brighter(0.0f));
+            else
+                g.setColour(Colours::darkred.darker(0.7f));
+            g.fillEllipse(ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f);
+            g.setColour(Colours::black.withAlpha(0.6f));
+            g.drawEllipse(ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f, 1.0f);
+        }
+
+        void paintPedal(Graphics& g)
         {
             auto bounds = getLocalBounds().toFloat();
 
@@ -328,35 +350,29 @@ public:
             g.drawRoundedRectangle(foot, 4.0f, 1.4f);
 
             // footswitch circle (metallic)
-            Point<float> footCentre(bounds.getCentreX(), foot.getCentreY());
-            float footR = 20.0f;
+            const auto footCentre = getFootCentre();
+            const float footR = footRadius;
             Colour metal = Colour::fromRGB(200, 200, 200);
             g.setColour(metal.overlaidWith(Colours::white.withAlpha(0.15f)));
             g.fillEllipse(footCentre.x - footR, footCentre.y - footR, footR * 2.0f, footR * 2.0f);
             g.setColour(metal.contrasting(0.4f));
             g.drawEllipse(footCentre.x - footR, footCentre.y - footR, footR * 2.0f, footR * 2.0f, 2.0f);
 
-            // LED indicator (rot wenn Effekt aktiviert) - jetzt links neben Footswitch
-            bool isBypassed = (bypassParameter ? static_cast<bool>(*bypassParameter) : false);
-            bool ledOn = !isBypassed;
-            float ledR = 7.0f;
-            // LED links neben den Fußschalter platzieren
-            Point<float> ledPos(footCentre.x - footR - 18.0f, footCentre.y);
-            if (ledOn)
-                g.setColour(Colours::red.brighter(0.0f));
-            else
-                g.setColour(Colours::darkred.darker(0.7f));
-            g.fillEllipse(ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f);
-            g.setColour(Colours::black.withAlpha(0.6f));
-            g.drawEllipse(ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f, 1.0f);
-
             // subtle border
             g.setColour(Colours::black.withAlpha(0.35f));
             g.drawRoundedRectangle(bounds.reduced(8.0f), 6.0f, 2.0f);
         }
 
+        Point<float> getFootCentre() const
+        {
+            // Mitte des Fussschalter-Felds (64 px hoch, 78 px ueber dem unteren Rand)
+            return { getWidth() * 0.5f, getHeight() - 46.0f };
+        }
+
         void resized() override
         {
+            pedalLayer.invalidate();
+
             auto r = getLocalBounds().reduced(12);
             Rectangle<int> top = r.removeFromTop(122);
 
@@ -401,8 +417,11 @@ public:
         }
 
     private:
-        void timerCallback() override
+        void uiTick() override
         {
+            if (! changeTracker.hasChanged())
+                return;
+
             if (delayParameter && mixParameter && regenParameter && bypassParameter)
             {
                 const float pDelay = FxCommon::getDisplayValueForParameter(&processor, delayParameter);
@@ -425,7 +444,12 @@ public:
                 if (bypassButton.getToggleState() != pBypass)
                     bypassButton.setToggleState(pBypass, dontSendNotification);
 
-                repaint();
+                // Regler und Schalter zeichnen sich selbst neu, im paint() haengt nur die LED vom Zustand ab
+                if (pBypass != ledShowsBypass)
+                {
+                    ledShowsBypass = pBypass;
+                    repaint(ledArea);
+                }
             }
         }
 
@@ -473,6 +497,11 @@ public:
         ToggleButton bypassButton;
         juce::TextButton hardwareMappingButton;
         FxCommon::HardwareMappingPopup hardwareMappingPopup;
+        FxCommon::EditorChangeTracker changeTracker { processor };
+        Rectangle<int> ledArea;      // von paint() gesetzt
+        bool ledShowsBypass = false;
+        FxCommon::CachedLayer pedalLayer { juce::Image::RGB };
+        static constexpr float footRadius = 20.0f;
 
         FxCommon::PedalLookAndFeel pedalLaf;
 
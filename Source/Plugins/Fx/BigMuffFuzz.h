@@ -22,7 +22,8 @@
 // Controls: Sustain (gain), Tone, Volume, Bypass
 //==============================================================================
 
-class BigMuffFuzz final : public AudioProcessor
+class BigMuffFuzz final : public AudioProcessor,
+                          public FxCommon::TailRenderer
 {
 public:
     //==============================================================================
@@ -55,10 +56,6 @@ public:
     template<typename SampleType>
     inline SampleType processSampleInternal(SampleType in, int ch)
     {
-        // If bypass is enabled just return input
-        if (bypass && static_cast<bool>(*bypass))
-            return in;
-
         // 1) Input booster (pre-gain) controlled by Sustain knob
         // Adjusted mapping to be more aggressive (closer to actual Big Muff behaviour)
         // Map sustain [0..1] to dB range [-10 .. +46]
@@ -131,44 +128,44 @@ public:
         return static_cast<SampleType>(out);
     }
 
-    void processBlock(AudioBuffer<float>& buffer, MidiBuffer&) override
+    template<typename SampleType>
+    void processChannels(AudioBuffer<SampleType>& buffer)
     {
-        const bool isBypassed = FxCommon::applyMappedBypassFromHardware(this, bypass);
-        if (isBypassed)
-            return;
-
         const int numCh = buffer.getNumChannels();
         const int numSamples = buffer.getNumSamples();
 
         for (int ch = 0; ch < numCh; ++ch)
         {
-            float* data = buffer.getWritePointer(ch);
+            SampleType* data = buffer.getWritePointer(ch);
             for (int i = 0; i < numSamples; ++i)
             {
-                data[i] = processSampleInternal<float>(data[i], ch);
+                data[i] = processSampleInternal<SampleType>(data[i], ch);
             }
         }
     }
 
-    void processBlock(AudioBuffer<double>& buffer, MidiBuffer&) override
+    void processBlock(AudioBuffer<float>& buffer, MidiBuffer&) override
     {
         const bool isBypassed = FxCommon::applyMappedBypassFromHardware(this, bypass);
         if (isBypassed)
             return;
 
-        const int numCh = buffer.getNumChannels();
-        const int numSamples = buffer.getNumSamples();
+        processChannels(buffer);
+    }
 
-        for (int ch = 0; ch < numCh; ++ch)
-        {
-            double* data = buffer.getWritePointer(ch);
-            for (int i = 0; i < numSamples; ++i)
-            {
-                data[i] = processSampleInternal<double>(data[i], ch);
-            }
-        }
+    void processBlock(AudioBuffer<double>& buffer, MidiBuffer&) override
+    {
+        const bool isBypassed = FxCommon::applyMappedBypassFromHardware(this, bypass);
+        if (isBypassed)
+            return;
+
+        processChannels(buffer);
     }
 
+    // ein Block Fuzz fuer das Ausblenden beim Umschalten auf Bypass
+    void processIgnoringBypass(AudioBuffer<float>& buffer) override { processChannels(buffer); }
+    void processIgnoringBypass(AudioBuffer<double>& buffer) override { processChannels(buffer); }
+
     //==============================================================================
     AudioProcessorEditor* createEditor() override { return new Editor(*this, sustain, tone, volume, bypass); }
     bool hasEditor() const override { return true; }
@@ -178,6 +175,7 @@ public:
     bool acceptsMidi() const override { return false; }
     bool producesMidi() const override { return false; }
     double getTailLengthSeconds() const override { return 0; }
+    AudioProcessorParameter* getBypassParameter() const override { return bypass; }
 
     //==============================================================================
     int getNumPrograms() override { return 1; }
@@ -220,7 +218,7 @@ public:
     // Editor: GUI implementation inspired by the Big Muff layout and FxCommon::PedalLookAndFeel
     class Editor final : public AudioProcessorEditor,
                          private Slider::Listener,
-                         private Timer
+                         private FxCommon::UiTick::Subscriber
     {
     public:
         Editor(BigMuffFuzz& p,
@@ -296,13 +294,13 @@ public:
             addAndMakeVisible(hardwareMappingButton);
             FxCommon::initialiseHardwareMappingUI(*this, hardwareMappingButton, hardwareMappingPopup, &processor);
 
-            startTimerHz(30);
+            FxCommon::UiTick::instance().subscribe(*this, *this);
             setWantsKeyboardFocus(false);
         }
 
         ~Editor() override
         {
-            stopTimer();
+            FxCommon::UiTick::instance().unsubscribe(*this);
             sustainSlider.removeListener(this);
             toneSlider.removeListener(this);
             volumeSlider.removeListener(this);
@@ -310,6 +308,25 @@ public:
         }
 
         void paint(Graphics& g) override
+        {
+            // der unveraenderliche Teil kommt aus dem Bild-Cache, nur die LED wird jedes Mal gezeichnet
+            pedalLayer.draw(g, getLocalBounds(), [this](Graphics& lg) { paintPedal(lg); });
+
+            const auto footCentre = getFootCentre();
+
+            // LED (red when engaged)
+            bool isBypassed = (bypassParameter ? static_cast<bool>(*bypassParameter) : false);
+            bool ledOn = !isBypassed;
+            float ledR = 7.0f;
+            Point<float> ledPos(footCentre.x, footCentre.y - 46.0f);
+            ledArea = FxCommon::getLedRepaintArea(ledPos, ledR);
+            g.setColour(ledOn ? Colours::red.brighter(0.0f) : Colours::darkred.darker(0.75f));
+            g.fillEllipse(ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f);
+            g.setColour(Colours::black.withAlpha(0.6f));
+            g.drawEllipse(ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f, 1.0f);
+        }
+
+        void paintPedal(Graphics& g)
         {
             auto bounds = getLocalBounds().toFloat();
             // metallic pedal background (silver)
@@ -337,27 +354,24 @@ public:
             g.drawFittedText("BIG MUFF", Rectangle<int>((int)logoBox.getX(), (int)logoBox.getY(), (int)logoBox.getWidth(), (int)logoBox.getHeight()), Justification::centred, 1);
 
             // footswitch knob (metal)
-            Point<float> footCentre(bounds.getCentreX(), bounds.getBottom() - 64.0f);
+            const auto footCentre = getFootCentre();
             float footR = 28.0f;
             Colour chrome = Colour::fromRGB(200, 200, 200);
             g.setColour(chrome.overlaidWith(Colours::white.withAlpha(0.14f)));
             g.fillEllipse(footCentre.x - footR, footCentre.y - footR, footR * 2.0f, footR * 2.0f);
             g.setColour(chrome.contrasting(0.45f));
             g.drawEllipse(footCentre.x - footR, footCentre.y - footR, footR * 2.0f, footR * 2.0f, 2.0f);
+        }
 
-            // LED (red when engaged)
-            bool isBypassed = (bypassParameter ? static_cast<bool>(*bypassParameter) : false);
-            bool ledOn = !isBypassed;
-            float ledR = 7.0f;
-            Point<float> ledPos(footCentre.x, footCentre.y - 46.0f);
-            g.setColour(ledOn ? Colours::red.brighter(0.0f) : Colours::darkred.darker(0.75f));
-            g.fillEllipse(ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f);
-            g.setColour(Colours::black.withAlpha(0.6f));
-            g.drawEllipse(ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f, 1.0f);
+        Point<float> getFootCentre() const
+        {
+            return { getWidth() * 0.5f, getHeight() - 64.0f };
         }
 
         void resized() override
         {
+            pedalLayer.invalidate();
+
             auto r = getLocalBounds().reduced(18);
             Rectangle<int> topBar = r.removeFromTop(110);
 
@@ -390,9 +404,12 @@ public:
         }
 
     private:
-        // Timer: keep sliders / bypass in sync with parameters
-        void timerCallback() override
+        // UI tick: keep sliders / bypass in sync with parameters
+        void uiTick() override
         {
+            if (! changeTracker.hasChanged())
+                return;
+
             if (sustainParameter && toneParameter && volumeParameter && bypassParameter)
             {
                 const float pSustain = FxCommon::getDisplayValueForParameter(&processor, sustainParameter);
@@ -419,7 +436,12 @@ public:
                 if (bypassButton.getToggleState() != pBypass)
                     bypassButton.setToggleState(pBypass, dontSendNotification);
 
-                repaint();
+                // Regler und Schalter zeichnen sich selbst neu, im paint() haengt nur die LED vom Zustand ab
+                if (pBypass != ledShowsBypass)
+                {
+                    ledShowsBypass = pBypass;
+                    repaint(ledArea);
+                }
             }
         }
 
@@ -469,6 +491,10 @@ public:
         ToggleButton bypassButton;
         juce::TextButton hardwareMappingButton;
         FxCommon::HardwareMappingPopup hardwareMappingPopup;
+        FxCommon::EditorChangeTracker changeTracker { processor };
+        Rectangle<int> ledArea;      // von paint() gesetzt
+        bool ledShowsBypass = false;
+        FxCommon::CachedLayer pedalLayer { juce::Image::RGB };
 
         // Inversion flags because artwork/knob orientation is mirrored vertically:
         // physical 7h -> logical 0, 5h -> logical 1
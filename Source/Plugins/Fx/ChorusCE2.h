@@ -19,7 +19,8 @@
 // ChorusCE2 - kompakter Chorus im Stil der Boss CE-2 (struktur hnlich GainProcessor)
 //==============================================================================
 
-class ChorusCE2 final : public AudioProcessor
+class ChorusCE2 final : public AudioProcessor,
+                        public FxCommon::TailRenderer
 {
 public:
     ChorusCE2()
@@ -42,17 +43,16 @@ public:
         const double maxDelayMs = maxDelayMilliseconds;
         const int maxSamples = static_cast<int>(std::ceil(maxDelayMs * 0.001 * sampleRate)) + 4;
 
-        delayBuffer.assign( std::max(1, getTotalNumInputChannels()), std::vector<double>(maxSamples, 0.0) );
+        // assign() statt neuer Vektoren: bei gleicher Samplerate wird nichts neu alloziert
+        delayBuffer.resize( std::max(1, getTotalNumInputChannels()) );
+        for (auto& buf : delayBuffer)
+            buf.assign(maxSamples, 0.0);
         writeIndex.assign(getTotalNumInputChannels(), 0);
         lfoPhase.assign(getTotalNumInputChannels(), 0.0);
 
         // base delay (static centre of modulation) - CE-2 style ~10 ms
         baseDelayMs = 10.0;
 
-        // reset states
-        for (auto& buf : delayBuffer)
-            std::fill(buf.begin(), buf.end(), 0.0);
-
         updateLfoIncrement();
     }
 
@@ -62,10 +62,6 @@ public:
     template<typename SampleType>
     inline SampleType processSampleInternal(SampleType inSample, int ch)
     {
-        // Bypass
-        if (bypass && static_cast<bool>(*bypass))
-            return inSample;
-
         // write input into circular delay buffer
         auto& buf = delayBuffer[ch];
         const int bufSize = static_cast<int>(buf.size());
@@ -117,45 +113,45 @@ public:
         return static_cast<SampleType>(out);
     }
 
-    void processBlock(AudioBuffer<float>& buffer, MidiBuffer&) override
+    template<typename SampleType>
+    void processChannels(AudioBuffer<SampleType>& buffer)
     {
-        const bool isBypassed = FxCommon::applyMappedBypassFromHardware(this, bypass);
-        if (isBypassed)
-            return;
-
         const int numCh = buffer.getNumChannels();
         const int numSamples = buffer.getNumSamples();
 
         for (int ch = 0; ch < numCh; ++ch)
         {
-            float* data = buffer.getWritePointer(ch);
+            SampleType* data = buffer.getWritePointer(ch);
             for (int i = 0; i < numSamples; ++i)
-                data[i] = processSampleInternal<float>(data[i], ch);
+                data[i] = processSampleInternal<SampleType>(data[i], ch);
         }
 
         // keep LFO increment in sync if rate parameter changed
         updateLfoIncrement();
     }
 
-    void processBlock(AudioBuffer<double>& buffer, MidiBuffer&) override
+    void processBlock(AudioBuffer<float>& buffer, MidiBuffer&) override
     {
         const bool isBypassed = FxCommon::applyMappedBypassFromHardware(this, bypass);
         if (isBypassed)
             return;
 
-        const int numCh = buffer.getNumChannels();
-        const int numSamples = buffer.getNumSamples();
+        processChannels(buffer);
+    }
 
-        for (int ch = 0; ch < numCh; ++ch)
-        {
-            double* data = buffer.getWritePointer(ch);
-            for (int i = 0; i < numSamples; ++i)
-                data[i] = processSampleInternal<double>(data[i], ch);
-        }
+    void processBlock(AudioBuffer<double>& buffer, MidiBuffer&) override
+    {
+        const bool isBypassed = FxCommon::applyMappedBypassFromHardware(this, bypass);
+        if (isBypassed)
+            return;
 
-        updateLfoIncrement();
+        processChannels(buffer);
     }
 
+    // fuer das Ausblenden im Bypass (der Chorus hat keinen Nachklang)
+    void processIgnoringBypass(AudioBuffer<float>& buffer) override { processChannels(buffer); }
+    void processIgnoringBypass(AudioBuffer<double>& buffer) override { processChannels(buffer); }
+
     //==============================================================================
     AudioProcessorEditor* createEditor() override { return new Editor(*this, rate, depth, bypass); }
     bool hasEditor() const override { return true; }
@@ -165,6 +161,7 @@ public:
     bool acceptsMidi() const override { return false; }
     bool producesMidi() const override { return false; }
     double getTailLengthSeconds() const override { return 0; }
+    AudioProcessorParameter* getBypassParameter() const override { return bypass; }
 
     //==============================================================================
     int getNumPrograms() override { return 1; }
@@ -222,7 +219,7 @@ public:
     // Editor: GUI implementation, anpassung an Bild (Rate, Depth, Fuschalter + LED)
     class Editor final : public AudioProcessorEditor,
                          private Slider::Listener,
-                         private Timer
+                         private FxCommon::UiTick::Subscriber
     {
     public:
         Editor(ChorusCE2& p,
@@ -290,18 +287,37 @@ public:
             addAndMakeVisible(hardwareMappingButton);
             FxCommon::initialiseHardwareMappingUI(*this, hardwareMappingButton, hardwareMappingPopup, &processor);
 
-            startTimerHz(30); // parameter polling for UI sync
+            FxCommon::UiTick::instance().subscribe(*this, *this);
         }
 
         ~Editor() override
         {
-            stopTimer();
+            FxCommon::UiTick::instance().unsubscribe(*this);
             rateSlider.removeListener(this);
             depthSlider.removeListener(this);
             setLookAndFeel(nullptr);
         }
 
         void paint(Graphics& g) override
+        {
+            // der unveraenderliche Teil kommt aus dem Bild-Cache, nur die LED wird jedes Mal gezeichnet
+            pedalLayer.draw(g, getLocalBounds(), [this](Graphics& lg) { paintPedal(lg); });
+
+            const Point<float> footCentre = footCentreCached;
+
+            // LED (red when effect engaged i.e. bypass == false)
+            bool isBypassed = (bypassParameter ? static_cast<bool>(*bypassParameter) : false);
+            bool ledOn = !isBypassed;
+            float ledR = 6.0f;
+            Point<float> ledPos(footCentre.x, footCentre.y - 46.0f);
+            ledArea = FxCommon::getLedRepaintArea(ledPos, ledR);
+            g.setColour(ledOn ? Colours::red.brighter(0.0f) : Colours::darkred.darker(0.6f));
+            g.fillEllipse(ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f);
+            g.setColour(Colours::black.withAlpha(0.6f));
+            g.drawEllipse(ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f, 1.0f);
+        }
+
+        void paintPedal(Graphics& g)
         {
             auto bounds = getLocalBounds().toFloat();
             g.fillAll(Colours::lightblue.brighter(0.16f));
@@ -325,16 +341,6 @@ public:
             g.setColour(metal.contrasting(0.45f));
             g.drawEllipse(footCentre.x - footR, footCentre.y - footR, footR * 2.0f, footR * 2.0f, 2.0f);
 
-            // LED (red when effect engaged i.e. bypass == false)
-            bool isBypassed = (bypassParameter ? static_cast<bool>(*bypassParameter) : false);
-            bool ledOn = !isBypassed;
-            float ledR = 6.0f;
-            Point<float> ledPos(footCentre.x, footCentre.y - 46.0f);
-            g.setColour(ledOn ? Colours::red.brighter(0.0f) : Colours::darkred.darker(0.6f));
-            g.fillEllipse(ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f);
-            g.setColour(Colours::black.withAlpha(0.6f));
-            g.drawEllipse(ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f, 1.0f);
-
             // subtle border
             g.setColour(Colours::black.withAlpha(0.2f));
             g.drawRoundedRectangle(getLocalBounds().toFloat().reduced(10.0f), 6.0f, 2.0f);
@@ -342,6 +348,8 @@ public:
 
         void resized() override
         {
+            pedalLayer.invalidate();
+
             // Layout now:
             // 1) top header (chorusLabel placed here, grer)
             // 2) knobs area (zwischen Header/Label und Footswitch)
@@ -396,8 +404,11 @@ public:
         }
 
     private:
-        void timerCallback() override
+        void uiTick() override
         {
+            if (! changeTracker.hasChanged())
+                return;
+
             if (rateParameter && depthParameter && bypassParameter)
             {
                 const float pRate = FxCommon::getDisplayValueForParameter(&processor, rateParameter);
@@ -416,7 +427,12 @@ public:
                 if (bypassButton.getToggleState() != pBypass)
                     bypassButton.setToggleState(pBypass, dontSendNotification);
 
-                repaint();
+                // Regler und Schalter zeichnen sich selbst neu, im paint() haengt nur die LED vom Zustand ab
+                if (pBypass != ledShowsBypass)
+                {
+                    ledShowsBypass = pBypass;
+                    repaint(ledArea);
+                }
             }
         }
 
@@ -483,6 +499,10 @@ public:
         ToggleButton bypassButton;
         juce::TextButton hardwareMappingButton;
         FxCommon::HardwareMappingPopup hardwareMappingPopup;
+        FxCommon::EditorChangeTracker changeTracker { processor };
+        Rectangle<int> ledArea;      // von paint() gesetzt
+        bool ledShowsBypass = false;
+        FxCommon::CachedLayer pedalLayer { juce::Image::RGB };
 
         FxCommon::PedalLookAndFeel pedalLaf;
 
@@ -15,6 +15,10 @@
 #include <mutex>
 #include <optional>
 #include <atomic>
+#include <array>
+#include <algorithm>
+#include <map>
+#include <vector>
 
 namespace FxCommon
 {
@@ -25,8 +29,60 @@ namespace FxCommon
         double y1 = 0.0;
     };
 
+    // Zwischengespeicherte, unveraenderliche Grafik (Pedal-Hintergrund, Reglerkoerper): wird nur neu
+    // gerendert, wenn sich die Groesse oder der Pixel-Massstab (DPI, Skalierung des Fensters) aendert,
+    // und sonst 1:1 auf die physikalischen Pixel kopiert.
+    class CachedLayer final
+    {
+    public:
+        explicit CachedLayer(juce::Image::PixelFormat formatToUse = juce::Image::ARGB)
+            : format(formatToUse)
+        {
+        }
+
+        // paintLayer zeichnet in denselben Koordinaten wie g, beschraenkt auf area
+        template <typename PaintFunction>
+        void draw(juce::Graphics& g, juce::Rectangle<int> area, PaintFunction&& paintLayer)
+        {
+            if (area.isEmpty())
+                return;
+
+            const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+            if (! image.isValid() || area.getWidth() != cachedWidth || area.getHeight() != cachedHeight || scale != cachedScale)
+            {
+                cachedWidth = area.getWidth();
+                cachedHeight = area.getHeight();
+                cachedScale = scale;
+
+                image = juce::Image(format,
+                                    juce::jmax(1, juce::roundToInt(cachedWidth * scale)),
+                                    juce::jmax(1, juce::roundToInt(cachedHeight * scale)),
+                                    true);
+
+                juce::Graphics ig(image);
+                ig.addTransform(juce::AffineTransform::translation((float) -area.getX(), (float) -area.getY())
+                                                      .scaled(scale));
+                paintLayer(ig);
+            }
+
+            g.drawImage(image, area.toFloat());
+        }
+
+        void invalidate()
+        {
+            image = {};
+        }
+
+    private:
+        juce::Image::PixelFormat format;
+        juce::Image image;
+        int cachedWidth = 0, cachedHeight = 0;
+        float cachedScale = 0.0f;
+    };
+
     // gemeinsames Pedal-LookAndFeel fr rotierende Regler (verwendet von beiden UI)
-    // Zeichnet Basiselemente 
+    // Zeichnet Basiselemente; der Reglerkoerper kommt aus einem Bild je Groesse, nur der Zeiger wird gezeichnet
     struct PedalLookAndFeel : public juce::LookAndFeel_V4
     {
         PedalLookAndFeel()
@@ -43,17 +99,24 @@ namespace FxCommon
             const float radius = jmin(width, height) * 0.5f - 6.0f;
             const float angle = rotaryStartAngle + sliderPosProportional * (rotaryEndAngle - rotaryStartAngle);
 
-            // outer ring
-            g.setColour(juce::Colours::black.brighter(0.08f));
-            g.fillEllipse(cx - radius - 4.0f, cy - radius - 4.0f, (radius + 4.0f) * 2.0f, (radius + 4.0f) * 2.0f);
+            // beim Aufziehen eines Fensters entstehen viele Groessen, die nicht wiederkommen
+            if (knobLayers.size() > 8 && knobLayers.find({ width, height }) == knobLayers.end())
+                knobLayers.clear();
 
-            // thin white outer ring
-            g.setColour(juce::Colours::white);
-            g.drawEllipse(cx - radius, cy - radius, radius * 2.0f, radius * 2.0f, 2.2f);
+            knobLayers[{ width, height }].draw(g, { x, y, width, height }, [cx, cy, radius](juce::Graphics& lg)
+            {
+                // outer ring
+                lg.setColour(juce::Colours::black.brighter(0.08f));
+                lg.fillEllipse(cx - radius - 4.0f, cy - radius - 4.0f, (radius + 4.0f) * 2.0f, (radius + 4.0f) * 2.0f);
 
-            // inner knob
-            g.setColour(juce::Colours::black);
-            g.fillEllipse(cx - radius * 0.7f, cy - radius * 0.7f, radius * 1.4f, radius * 1.4f);
+                // thin white outer ring
+                lg.setColour(juce::Colours::white);
+                lg.drawEllipse(cx - radius, cy - radius, radius * 2.0f, radius * 2.0f, 2.2f);
+
+                // inner knob
+                lg.setColour(juce::Colours::black);
+                lg.fillEllipse(cx - radius * 0.7f, cy - radius * 0.7f, radius * 1.4f, radius * 1.4f);
+            });
 
             // pointer
             juce::Path p;
@@ -65,6 +128,9 @@ namespace FxCommon
             p.lineTo(px, py);
             g.strokePath(p, juce::PathStrokeType(3.0f, juce::PathStrokeType::curved, juce::PathStrokeType::rounded));
         }
+
+    private:
+        std::map<std::pair<int, int>, CachedLayer> knobLayers;
     };
 
     struct LfoDefinition
@@ -84,46 +150,185 @@ namespace FxCommon
         float offsetPercent = 50.0f;
     };
 
-    enum class ModulationSource
+    // Quelle einer Parameter-Zuordnung; Potis und Fussschalter werden ab 0 durchnummeriert,
+    // wie viele es gibt, legt das Board fest (siehe HardwareLayout)
+    struct ModulationSource
     {
-        none,
-        poti1,
-        poti2,
-        lfo,
-        footswitch1,
-        footswitch2,
-        footswitch3
+        enum class Kind
+        {
+            none,
+            poti,
+            lfo,
+            footswitch
+        };
+
+        Kind kind = Kind::none;
+        int index = 0;
+
+        static constexpr ModulationSource poti(int i) { return { Kind::poti, i }; }
+        static constexpr ModulationSource footswitch(int i) { return { Kind::footswitch, i }; }
+
+        bool isNone() const { return kind == Kind::none; }
+
+        bool operator==(const ModulationSource& other) const
+        {
+            const bool hasIndex = kind == Kind::poti || kind == Kind::footswitch;
+            return kind == other.kind && (! hasIndex || index == other.index);
+        }
+
+        bool operator!=(const ModulationSource& other) const { return ! operator==(other); }
     };
 
     struct ParameterAssignment
     {
-        ModulationSource source = ModulationSource::none;
+        ModulationSource source;
         int lfoIndex = 0;
     };
 
+    // "Poti1", "Footswitch3" usw., wie in gespeicherten Sessions
     inline juce::String toString(ModulationSource source)
     {
-        switch (source)
-        {
-            case ModulationSource::poti1: return "Poti1";
-            case ModulationSource::poti2: return "Poti2";
-            case ModulationSource::lfo: return "LFO";
-            case ModulationSource::footswitch1: return "Footswitch1";
-            case ModulationSource::footswitch2: return "Footswitch2";
-            case ModulationSource::footswitch3: return "Footswitch3";
+        switch (source.kind)
+        {
+            case ModulationSource::Kind::poti: return "Poti" + juce::String(source.index + 1);
+            case ModulationSource::Kind::lfo: return "LFO";
+            case ModulationSource::Kind::footswitch: return "Footswitch" + juce::String(source.index + 1);
             default: return "None";
         }
     }
 
     inline ModulationSource modulationSourceFromString(const juce::String& s)
     {
-        if (s == "Poti1") return ModulationSource::poti1;
-        if (s == "Poti2") return ModulationSource::poti2;
-        if (s == "LFO") return ModulationSource::lfo;
-        if (s == "Footswitch1") return ModulationSource::footswitch1;
-        if (s == "Footswitch2") return ModulationSource::footswitch2;
-        if (s == "Footswitch3") return ModulationSource::footswitch3;
-        return ModulationSource::none;
+        if (s == "LFO")
+            return { ModulationSource::Kind::lfo, 0 };
+
+        const auto number = s.getTrailingIntValue();
+
+        if (number >= 1 && s == "Poti" + juce::String(number))
+            return ModulationSource::poti(number - 1);
+
+        if (number >= 1 && s == "Footswitch" + juce::String(number))
+            return ModulationSource::footswitch(number - 1);
+
+        return {};
+    }
+
+    // Anzahl der Bedienelemente des Boards; wird beim Start vom Hardware-Dienst gesetzt,
+    // damit ein Programm 4-, 6- und 8-Schalter-Boards bedienen kann
+    constexpr int maxHardwareControls = 32;
+
+    struct HardwareLayout
+    {
+        int numAnalogInputs = 2;
+        int numSwitches = 3;
+        int numLeds = 3;
+    };
+
+    // Zustand aller Bedienelemente, eine Cache-Line-ausgerichtete Struktur ohne Locks:
+    // jeder Poti ist ein eigener Wert, die Schalter und LEDs je ein Bitfeld (Bit i = Element i).
+    // Jeder Lesezugriff ist ein einzelner atomarer Load, egal wie viele Elemente es gibt.
+    // Die Zaehler steigen bei jeder Aenderung, wer sie sich merkt, kann Arbeit sparen,
+    // solange sich nichts bewegt hat.
+    struct alignas(64) HardwareControlState
+    {
+        std::atomic<int> numAnalogInputs { 2 };
+        std::atomic<int> numSwitches { 3 };
+        std::atomic<int> numLeds { 3 };
+        std::atomic<uint32_t> switchBits { 0 };
+        std::atomic<uint32_t> changeCounter { 0 };
+        // Zeitpunkt der letzten Aenderung (Time::getMillisecondCounterHiRes() in Sekunden), fuer die Latenzmessung
+        std::atomic<double> switchChangeSeconds { 0.0 };
+        std::atomic<double> analogChangeSeconds { 0.0 };
+        alignas(64) std::atomic<uint32_t> requestedLedBits { 0 };
+        alignas(64) std::array<std::atomic<float>, maxHardwareControls> analog {};
+        std::array<std::atomic<uint32_t>, maxHardwareControls> analogChangeCounts {};
+    };
+
+    inline HardwareControlState& hardwareControlState()
+    {
+        static HardwareControlState state;
+        return state;
+    }
+
+    inline void setHardwareLayout(const HardwareLayout& layout)
+    {
+        auto& state = hardwareControlState();
+        state.numAnalogInputs.store(juce::jlimit(0, maxHardwareControls, layout.numAnalogInputs));
+        state.numSwitches.store(juce::jlimit(0, maxHardwareControls, layout.numSwitches));
+        state.numLeds.store(juce::jlimit(0, maxHardwareControls, layout.numLeds));
+    }
+
+    inline HardwareLayout getHardwareLayout()
+    {
+        const auto& state = hardwareControlState();
+        return { state.numAnalogInputs.load(), state.numSwitches.load(), state.numLeds.load() };
+    }
+
+    // nur bei echten Aenderungen aufrufen (der Hardware-Dienst filtert das Rauschen der Potis)
+    inline void setHardwareAnalogInput(int index, float value, double changeSeconds = 0.0)
+    {
+        if (! juce::isPositiveAndBelow(index, maxHardwareControls))
+            return;
+
+        auto& state = hardwareControlState();
+        state.analog[(size_t) index].store(juce::jlimit(0.0f, 1.0f, value), std::memory_order_relaxed);
+
+        if (changeSeconds > 0.0)
+            state.analogChangeSeconds.store(changeSeconds, std::memory_order_relaxed);
+
+        state.analogChangeCounts[(size_t) index].fetch_add(1, std::memory_order_release);
+        state.changeCounter.fetch_add(1, std::memory_order_release);
+    }
+
+    // edgeSeconds: wann der Schalter tatsaechlich betaetigt wurde (bei Flanken-Events die Zeit des Kernels)
+    inline void setHardwareSwitchBits(uint32_t bits, double edgeSeconds = 0.0)
+    {
+        auto& state = hardwareControlState();
+
+        if (edgeSeconds > 0.0)
+            state.switchChangeSeconds.store(edgeSeconds, std::memory_order_relaxed);
+
+        if (state.switchBits.exchange(bits, std::memory_order_release) != bits)
+            state.changeCounter.fetch_add(1, std::memory_order_release);
+    }
+
+    inline double getHardwareSwitchChangeSeconds()
+    {
+        return hardwareControlState().switchChangeSeconds.load(std::memory_order_relaxed);
+    }
+
+    inline double getHardwareAnalogChangeSeconds()
+    {
+        return hardwareControlState().analogChangeSeconds.load(std::memory_order_relaxed);
+    }
+
+    // aendert sich bei jeder Bewegung eines Potis oder Schalters
+    inline uint32_t getHardwareChangeCounter()
+    {
+        return hardwareControlState().changeCounter.load(std::memory_order_acquire);
+    }
+
+    inline uint32_t getHardwareAnalogChangeCount(int index)
+    {
+        if (! juce::isPositiveAndBelow(index, maxHardwareControls))
+            return 0;
+
+        return hardwareControlState().analogChangeCounts[(size_t) index].load(std::memory_order_acquire);
+    }
+
+    inline float getHardwareSourceNormalised(ModulationSource source)
+    {
+        if (! juce::isPositiveAndBelow(source.index, maxHardwareControls))
+            return 0.0f;
+
+        const auto& state = hardwareControlState();
+
+        switch (source.kind)
+        {
+            case ModulationSource::Kind::poti: return state.analog[(size_t) source.index].load(std::memory_order_relaxed);
+            case ModulationSource::Kind::footswitch: return ((state.switchBits.load(std::memory_order_relaxed) >> source.index) & 1u) != 0 ? 1.0f : 0.0f;
+            default: return 0.0f;
+        }
     }
 
     inline juce::String makeParameterKey(const juce::String& nodeId, const juce::String& parameterId)
@@ -150,22 +355,67 @@ namespace FxCommon
         {
             std::lock_guard<std::mutex> lock(mutex);
             lfos = newLfos;
+            ++revision;
         }
 
         int addDefaultLfo()
         {
             std::lock_guard<std::mutex> lock(mutex);
             lfos.push_back({ LfoDefinition::Waveform::sine, 0.5f, 50.0f, 50.0f });
+            ++revision;
             return static_cast<int>(lfos.size()) - 1;
         }
 
         void setAssignment(const juce::String& parameterKey, ParameterAssignment assignment)
         {
             std::lock_guard<std::mutex> lock(mutex);
-            if (assignment.source == ModulationSource::none)
+            if (assignment.source.isNone())
                 assignments.erase(parameterKey);
             else
                 assignments[parameterKey] = assignment;
+            ++revision;
+        }
+
+        // aendert sich bei jeder Aenderung an LFOs oder Zuordnungen
+        uint32_t getRevision() const
+        {
+            return revision.load();
+        }
+
+        // ist einem Parameter dieses Knotens ein LFO zugeordnet, bewegt sich seine Anzeige staendig
+        bool hasLfoAssignmentForNode(const juce::String& nodeId) const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto prefix = nodeId + "::";
+
+            return std::any_of(assignments.begin(), assignments.end(), [&prefix](const auto& entry)
+            {
+                return entry.second.source.kind == ModulationSource::Kind::lfo && entry.first.startsWith(prefix);
+            });
+        }
+
+        // ein geloeschter Knoten nimmt seine Zuordnungen mit; seine Adresse kann wiederverwendet werden
+        void removeAssignmentsForNode(const juce::String& nodeId)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto prefix = nodeId + "::";
+            bool removedAny = false;
+
+            for (auto it = assignments.begin(); it != assignments.end();)
+            {
+                if (it->first.startsWith(prefix))
+                {
+                    it = assignments.erase(it);
+                    removedAny = true;
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+
+            if (removedAny)
+                ++revision;
         }
 
         ParameterAssignment getAssignment(const juce::String& parameterKey) const
@@ -216,6 +466,7 @@ namespace FxCommon
             std::lock_guard<std::mutex> lock(mutex);
             lfos.clear();
             assignments.clear();
+            ++revision;
 
             if (auto lfoRoot = root.getChildWithName("Lfos"); lfoRoot.isValid())
             {
@@ -243,7 +494,7 @@ namespace FxCommon
                     ParameterAssignment a;
                     a.source = modulationSourceFromString(n.getProperty("source").toString());
                     a.lfoIndex = static_cast<int>(n.getProperty("lfoIndex", 0));
-                    if (a.source != ModulationSource::none)
+                    if (! a.source.isNone())
                         assignments[key] = a;
                 }
             }
@@ -253,6 +504,7 @@ namespace FxCommon
         mutable std::mutex mutex;
         std::vector<LfoDefinition> lfos;
         std::unordered_map<juce::String, ParameterAssignment> assignments;
+        std::atomic<uint32_t> revision { 0 };
     };
 
     inline void setAssignmentFromDropdown(const juce::String& nodeId,
@@ -310,8 +562,146 @@ namespace FxCommon
         button.setBounds(mappingX, footswitchCenterY - mappingH / 2, mappingW, mappingH);
     }
 
+    // Ein gemeinsamer Takt fuer alle Pedal-Editoren, statt eines eigenen 30-Hz-Timers pro Editor.
+    // Er haengt am VBlank der Fenster der Abonnenten: der erste VBlank nach Ablauf der Periode
+    // loest den Takt fuer alle aus, so dass neu gezeichnete Bereiche mit dem Bildaufbau zusammenfallen.
+    class UiTick final
+    {
+    public:
+        struct Subscriber
+        {
+            virtual ~Subscriber() = default;
+            virtual void uiTick() = 0;
+        };
+
+        static constexpr double tickRateHz = 30.0;
+
+        static UiTick& instance()
+        {
+            static UiTick tick;
+            return tick;
+        }
+
+        // owner: die Komponente, an deren Fenster der VBlank abgegriffen wird
+        void subscribe(Subscriber& subscriber, juce::Component& owner)
+        {
+            unsubscribe(subscriber);
+
+            Entry entry;
+            entry.subscriber = &subscriber;
+            entry.vblank = std::make_unique<juce::VBlankAttachment>(&owner, [this] { vblankArrived(); });
+            entries.push_back(std::move(entry));
+        }
+
+        void unsubscribe(Subscriber& subscriber)
+        {
+            entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                         [&subscriber](const Entry& e) { return e.subscriber == &subscriber; }),
+                          entries.end());
+        }
+
+    private:
+        UiTick() = default;
+
+        struct Entry
+        {
+            Subscriber* subscriber = nullptr;
+            std::unique_ptr<juce::VBlankAttachment> vblank;
+        };
+
+        void vblankArrived()
+        {
+            const double now = juce::Time::getMillisecondCounterHiRes() * 0.001;
+
+            // ein halbes Bild Toleranz, damit der Takt bei 60 Hz genau auf jeden zweiten VBlank faellt
+            if (now - lastTickSeconds < 1.0 / tickRateHz - 0.008)
+                return;
+
+            lastTickSeconds = now;
+
+            // ein Abonnent kann waehrend des Takts andere Editoren schliessen
+            current.clear();
+            for (const auto& e : entries)
+                current.push_back(e.subscriber);
+
+            for (auto* subscriber : current)
+            {
+                const bool stillSubscribed = std::any_of(entries.begin(), entries.end(),
+                                                         [subscriber](const Entry& e) { return e.subscriber == subscriber; });
+                if (stillSubscribed)
+                    subscriber->uiTick();
+            }
+        }
+
+        std::vector<Entry> entries;
+        std::vector<Subscriber*> current;
+        double lastTickSeconds = 0.0;
+    };
+
+    // Sagt einem Editor, ob beim Takt ueberhaupt etwas abzufragen ist: nur wenn sich ein Parameter
+    // seines Prozessors (gezaehlt, auch vom Audio-Thread aus), die Hardware oder die Zuordnungen
+    // geaendert haben - oder wenn ein LFO einem seiner Parameter zugeordnet ist.
+    class EditorChangeTracker final : private juce::AudioProcessorParameter::Listener
+    {
+    public:
+        explicit EditorChangeTracker(juce::AudioProcessor& p)
+            : processor(p)
+        {
+            for (auto* parameter : processor.getParameters())
+                parameter->addListener(this);
+        }
+
+        ~EditorChangeTracker() override
+        {
+            for (auto* parameter : processor.getParameters())
+                parameter->removeListener(this);
+        }
+
+        bool hasChanged()
+        {
+            auto& model = SessionModulationModel::instance();
+
+            const uint32_t parameters = parameterChanges.load(std::memory_order_acquire);
+            const uint32_t hardware = getHardwareChangeCounter();
+            const uint32_t mapping = model.getRevision();
+
+            if (! initialised || mapping != lastMapping)
+                isAnimated = model.hasLfoAssignmentForNode(makeRuntimeNodeId(&processor));
+
+            const bool changed = ! initialised || isAnimated
+                              || parameters != lastParameters || hardware != lastHardware || mapping != lastMapping;
+
+            initialised = true;
+            lastParameters = parameters;
+            lastHardware = hardware;
+            lastMapping = mapping;
+            return changed;
+        }
+
+    private:
+        void parameterValueChanged(int, float) override
+        {
+            parameterChanges.fetch_add(1, std::memory_order_release);
+        }
+
+        void parameterGestureChanged(int, bool) override {}
+
+        juce::AudioProcessor& processor;
+        std::atomic<uint32_t> parameterChanges { 0 };
+
+        bool initialised = false;
+        bool isAnimated = false;
+        uint32_t lastParameters = 0, lastHardware = 0, lastMapping = 0;
+    };
+
+    // Bereich einer gezeichneten LED (inkl. Kontur), damit nur er neu gezeichnet wird
+    inline juce::Rectangle<int> getLedRepaintArea(juce::Point<float> centre, float radius)
+    {
+        return juce::Rectangle<float>(radius * 2.0f, radius * 2.0f).withCentre(centre).expanded(2.0f).getSmallestIntegerContainer();
+    }
+
     class HardwareMappingPopup final : public juce::Component,
-                                    private juce::Timer
+                                    private UiTick::Subscriber
     {
     public:
         HardwareMappingPopup()
@@ -427,10 +817,15 @@ namespace FxCommon
             };
 
             setInterceptsMouseClicks(true, true);
-            startTimerHz(30);
+            UiTick::instance().subscribe(*this, *this);
             showMappingView();
         }
 
+        ~HardwareMappingPopup() override
+        {
+            UiTick::instance().unsubscribe(*this);
+        }
+
         void setParameters(const juce::String& nodeIdIn, juce::AudioProcessor* processor)
         {
             nodeId = nodeIdIn;
@@ -463,17 +858,19 @@ namespace FxCommon
 
                 const auto lowerName = p->getName(64).trim().toLowerCase();
                 const bool isBypass = (lowerName == "bypass");
+                const auto layout = getHardwareLayout();
+
                 if (isBypass)
                 {
-                    combo->addItem("Footswitch1", 2);
-                    combo->addItem("Footswitch2", 3);
-                    combo->addItem("Footswitch3", 4);
+                    for (int i = 0; i < layout.numSwitches; ++i)
+                        combo->addItem(toString(ModulationSource::footswitch(i)), combo->getNumItems() + 1);
                 }
                 else
                 {
-                    combo->addItem("Poti1", 2);
-                    combo->addItem("Poti2", 3);
-                    combo->addItem("LFO", 4);
+                    for (int i = 0; i < layout.numAnalogInputs; ++i)
+                        combo->addItem(toString(ModulationSource::poti(i)), combo->getNumItems() + 1);
+
+                    combo->addItem("LFO", combo->getNumItems() + 1);
                 }
 
                 const auto saved = getDropdownValueForParameter(nodeId, parameterId);
@@ -860,7 +1257,7 @@ namespace FxCommon
             if (activeMappingParameterIndex >= 0 && activeMappingParameterIndex < (int) parameterIds.size())
             {
                 const auto a = SessionModulationModel::instance().getAssignment(makeParameterKey(nodeId, parameterIds[(size_t) activeMappingParameterIndex]));
-                if (a.source == ModulationSource::lfo)
+                if (a.source.kind == ModulationSource::Kind::lfo)
                     assignedIndex = a.lfoIndex;
             }
 
@@ -1060,7 +1457,8 @@ namespace FxCommon
             offsetValueLabel.setBounds(offsetKnob.getX(), offsetKnob.getBottom() + 2, knobW, 20);
         }
 
-        void timerCallback() override
+        // nur die LFO-Ansichten sind animiert
+        void uiTick() override
         {
             if (isVisible() && (currentView == View::lfoGrid || currentView == View::lfoDetail))
                 repaint();
@@ -1158,7 +1556,7 @@ namespace FxCommon
     inline bool isManualControlAllowed(const juce::AudioProcessor* processor,
                                        const juce::AudioProcessorParameter* parameter)
     {
-        return getAssignmentForParameter(processor, parameter).source == ModulationSource::none;
+        return getAssignmentForParameter(processor, parameter).source.isNone();
     }
 
     inline float evaluateLfoWave(const LfoDefinition& lfo, double timeSec)
@@ -1187,77 +1585,6 @@ namespace FxCommon
         return juce::jlimit(-1.0f, 1.0f, wave * depth + offset);
     }
 
-    inline std::atomic<float>& hardwarePoti1Value()
-    {
-        static std::atomic<float> v { 0.0f };
-        return v;
-    }
-
-    inline std::atomic<float>& hardwarePoti2Value()
-    {
-        static std::atomic<float> v { 0.0f };
-        return v;
-    }
-
-    inline std::atomic<bool>& hardwareFootswitch1Value()
-    {
-        static std::atomic<bool> v { false };
-        return v;
-    }
-
-    inline std::atomic<bool>& hardwareFootswitch2Value()
-    {
-        static std::atomic<bool> v { false };
-        return v;
-    }
-
-    inline std::atomic<bool>& hardwareFootswitch3Value()
-    {
-        static std::atomic<bool> v { false };
-        return v;
-    }
-
-    inline std::atomic<bool>& hardwareLed1Requested()
-    {
-        static std::atomic<bool> v { false };
-        return v;
-    }
-
-    inline std::atomic<bool>& hardwareLed2Requested()
-    {
-        static std::atomic<bool> v { false };
-        return v;
-    }
-
-    inline std::atomic<bool>& hardwareLed3Requested()
-    {
-        static std::atomic<bool> v { false };
-        return v;
-    }
-
-    inline void setHardwareInputSnapshot(float poti1, float poti2,
-                                     bool footswitch1, bool footswitch2, bool footswitch3)
-    {
-        hardwarePoti1Value().store(juce::jlimit(0.0f, 1.0f, poti1));
-        hardwarePoti2Value().store(juce::jlimit(0.0f, 1.0f, poti2));
-        hardwareFootswitch1Value().store(footswitch1);
-        hardwareFootswitch2Value().store(footswitch2);
-        hardwareFootswitch3Value().store(footswitch3);
-    }
-
-    inline float getHardwareSourceNormalised(ModulationSource source)
-    {
-        switch (source)
-        {
-            case ModulationSource::poti1: return hardwarePoti1Value().load();
-            case ModulationSource::poti2: return hardwarePoti2Value().load();
-            case ModulationSource::footswitch1: return hardwareFootswitch1Value().load() ? 1.0f : 0.0f;
-            case ModulationSource::footswitch2: return hardwareFootswitch2Value().load() ? 1.0f : 0.0f;
-            case ModulationSource::footswitch3: return hardwareFootswitch3Value().load() ? 1.0f : 0.0f;
-            default: return 0.0f;
-        }
-    }
-
     struct BypassRuntimeState
     {
         bool initialised = false;
@@ -1267,7 +1594,7 @@ namespace FxCommon
 
     struct BypassLedClaim
     {
-        ModulationSource source = ModulationSource::none;
+        ModulationSource source;
         bool ledOn = false;
     };
 
@@ -1291,16 +1618,13 @@ namespace FxCommon
 
     inline bool isFootswitchSource(ModulationSource source)
     {
-        return source == ModulationSource::footswitch1
-            || source == ModulationSource::footswitch2
-            || source == ModulationSource::footswitch3;
+        return source.kind == ModulationSource::Kind::footswitch;
     }
 
+    // die LED neben einem Fussschalter hat dieselbe Nummer wie der Schalter
     inline void rebuildHardwareLedRequestFromClaimsLocked()
     {
-        bool led1 = false;
-        bool led2 = false;
-        bool led3 = false;
+        uint32_t ledBits = 0;
 
         for (const auto& [key, claim] : bypassLedClaims())
         {
@@ -1308,14 +1632,11 @@ namespace FxCommon
             if (! claim.ledOn)
                 continue;
 
-            if (claim.source == ModulationSource::footswitch1) led1 = true;
-            else if (claim.source == ModulationSource::footswitch2) led2 = true;
-            else if (claim.source == ModulationSource::footswitch3) led3 = true;
+            if (juce::isPositiveAndBelow(claim.source.index, maxHardwareControls))
+                ledBits |= 1u << claim.source.index;
         }
 
-        hardwareLed1Requested().store(led1);
-        hardwareLed2Requested().store(led2);
-        hardwareLed3Requested().store(led3);
+        hardwareControlState().requestedLedBits.store(ledBits);
     }
 
     inline bool applyMappedBypassFromHardware(const juce::AudioProcessor* processor,
@@ -1370,6 +1691,29 @@ namespace FxCommon
         return bypassState;
     }
 
+    // Vergisst alles, was unter der Runtime-ID des Prozessors liegt (Zuordnungen, Schalterzustand,
+    // LED). Muss laufen, bevor der Prozessor geloescht oder wiederverwendet wird, denn die ID ist
+    // nur seine Adresse.
+    inline void forgetRuntimeNode(const juce::AudioProcessor* processor)
+    {
+        const auto nodeId = makeRuntimeNodeId(processor);
+        const auto prefix = nodeId + "::";
+
+        SessionModulationModel::instance().removeAssignmentsForNode(nodeId);
+
+        std::lock_guard<std::mutex> lock(bypassRuntimeMutex());
+
+        auto eraseNode = [&prefix](auto& map)
+        {
+            for (auto it = map.begin(); it != map.end();)
+                it = it->first.startsWith(prefix) ? map.erase(it) : std::next(it);
+        };
+
+        eraseNode(bypassRuntimeStates());
+        eraseNode(bypassLedClaims());
+        rebuildHardwareLedRequestFromClaimsLocked();
+    }
+
     inline bool getDisplayBypassStateForParameter(const juce::AudioProcessor* processor,
                                                   juce::AudioParameterBool* parameter)
     {
@@ -1379,11 +1723,20 @@ namespace FxCommon
         return applyMappedBypassFromHardware(processor, parameter);
     }
 
-    inline void getRequestedHardwareLedStates(bool& led1, bool& led2, bool& led3)
+    // Alle internen Effekte koennen vom Graph-Renderer auch bei gesetztem Bypass gerendert
+    // werden: beim Umschalten fuer das Ausblenden, Effekte mit Nachklang (z.B. Delay) danach mit
+    // stillem Eingang fuer den Tail, der auf das trockene Signal gemischt wird. Der
+    // Bypass-Parameter wird dabei ignoriert.
+    struct TailRenderer
+    {
+        virtual ~TailRenderer() = default;
+        virtual void processIgnoringBypass(juce::AudioBuffer<float>& buffer) = 0;
+        virtual void processIgnoringBypass(juce::AudioBuffer<double>& buffer) = 0;
+    };
+
+    inline uint32_t getRequestedHardwareLedBits()
     {
-        led1 = hardwareLed1Requested().load();
-        led2 = hardwareLed2Requested().load();
-        led3 = hardwareLed3Requested().load();
+        return hardwareControlState().requestedLedBits.load();
     }
 
     inline float getDisplayValueForParameter(const juce::AudioProcessor* processor,
@@ -1395,12 +1748,12 @@ namespace FxCommon
         const float baseValue = parameter->get();
         const auto assignment = getAssignmentForParameter(processor, parameter);
 
-        if (assignment.source == ModulationSource::none)
+        if (assignment.source.isNone())
             return baseValue;
 
         const auto& range = parameter->getNormalisableRange();
 
-        if (assignment.source == ModulationSource::lfo)
+        if (assignment.source.kind == ModulationSource::Kind::lfo)
         {
             auto lfos = SessionModulationModel::instance().getLfos();
             if (lfos.empty())
@@ -19,7 +19,8 @@
 using namespace juce;
 
 //==============================================================================
-class GainBoostProcessor final : public AudioProcessor
+class GainBoostProcessor final : public AudioProcessor,
+                                 public FxCommon::TailRenderer
 {
 public:
     //==============================================================================
@@ -45,6 +46,7 @@ public:
     bool acceptsMidi() const override { return false; }
     bool producesMidi() const override { return false; }
     double getTailLengthSeconds() const override { return 0.0; }
+    AudioProcessorParameter* getBypassParameter() const override { return bypassParam; }
 
     //==============================================================================
     int getNumPrograms() override { return 1; }
@@ -69,7 +71,25 @@ public:
         const bool isBypassed = FxCommon::applyMappedBypassFromHardware(this, bypassParam);
         if (isBypassed)
             return;
-            
+
+        processChannels (buffer);
+    }
+
+    void processBlock (AudioBuffer<double>& buffer, MidiBuffer&) override
+    {
+        const bool isBypassed = FxCommon::applyMappedBypassFromHardware(this, bypassParam);
+        if (isBypassed)
+            return;
+
+        processChannels (buffer);
+    }
+
+    // lets the renderer fade the boost out instead of cutting it
+    void processIgnoringBypass (AudioBuffer<float>& buffer) override    { processChannels (buffer); }
+    void processIgnoringBypass (AudioBuffer<double>& buffer) override   { processChannels (buffer); }
+
+    void processChannels (AudioBuffer<float>& buffer)
+    {
         auto totalNumInputChannels  = getTotalNumInputChannels();
         auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -90,20 +110,15 @@ public:
         }
     }
 
-    void processBlock (AudioBuffer<double>& buffer, MidiBuffer&) override
+    void processChannels (AudioBuffer<double>& buffer)
     {
-        const bool isBypassed = FxCommon::applyMappedBypassFromHardware(this, bypassParam);
-        if (isBypassed)
-            return;
-            
         AudioBuffer<float> floatBuffer (buffer.getNumChannels(), buffer.getNumSamples());
         
         for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
             for (int i = 0; i < buffer.getNumSamples(); ++i)
                 floatBuffer.setSample (ch, i, (float) buffer.getSample (ch, i));
         
-        MidiBuffer dummyMidi;
-        processBlock (floatBuffer, dummyMidi);
+        processChannels (floatBuffer);
         
         for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
             for (int i = 0; i < buffer.getNumSamples(); ++i)
@@ -147,7 +162,7 @@ public:
     // Editor: Custom GUI inspired by MXR Micro Amp pedal design
     class Editor final : public AudioProcessorEditor,
                          private Slider::Listener,
-                         private Timer
+                         private FxCommon::UiTick::Subscriber
     {
     public:
         Editor (GainBoostProcessor& p,
@@ -198,18 +213,36 @@ public:
             addAndMakeVisible (hardwareMappingButton);
             FxCommon::initialiseHardwareMappingUI (*this, hardwareMappingButton, hardwareMappingPopup, &processor);
 
-            startTimerHz (30);
+            FxCommon::UiTick::instance().subscribe (*this, *this);
             setWantsKeyboardFocus (false);
         }
 
         ~Editor() override
         {
-            stopTimer();
+            FxCommon::UiTick::instance().unsubscribe (*this);
             gainSlider.removeListener (this);
             setLookAndFeel (nullptr);
         }
 
         void paint (Graphics& g) override
+        {
+            // der unveraenderliche Teil kommt aus dem Bild-Cache, nur die LED wird jedes Mal gezeichnet
+            pedalLayer.draw (g, getLocalBounds(), [this](Graphics& lg) { paintPedal (lg); });
+
+            const auto footCentre = getFootCentre();
+
+            bool isBypassed = (bypassParam ? static_cast<bool>(*bypassParam) : false);
+            bool ledOn = !isBypassed;
+            float ledR = 6.0f;
+            Point<float> ledPos (footCentre.x, footCentre.y - 38.0f);
+            ledArea = FxCommon::getLedRepaintArea (ledPos, ledR);
+            g.setColour (ledOn ? Colours::red.brighter (0.0f) : Colours::darkred.darker (0.75f));
+            g.fillEllipse (ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f);
+            g.setColour (Colours::black.withAlpha (0.6f));
+            g.drawEllipse (ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f, 1.0f);
+        }
+
+        void paintPedal (Graphics& g)
         {
             auto bounds = getLocalBounds().toFloat();
             
@@ -242,26 +275,24 @@ public:
                                                           (int)logoArea.getWidth(), 22), 
                               Justification::centred, 1);
 
-            Point<float> footCentre (bounds.getCentreX(), bounds.getBottom() - 50.0f);
+            const auto footCentre = getFootCentre();
             float footR = 24.0f;
             Colour chrome = Colour::fromRGB (200, 200, 200);
             g.setColour (chrome.overlaidWith (Colours::white.withAlpha (0.14f)));
             g.fillEllipse (footCentre.x - footR, footCentre.y - footR, footR * 2.0f, footR * 2.0f);
             g.setColour (chrome.contrasting (0.45f));
             g.drawEllipse (footCentre.x - footR, footCentre.y - footR, footR * 2.0f, footR * 2.0f, 2.0f);
+        }
 
-            bool isBypassed = (bypassParam ? static_cast<bool>(*bypassParam) : false);
-            bool ledOn = !isBypassed;
-            float ledR = 6.0f;
-            Point<float> ledPos (footCentre.x, footCentre.y - 38.0f);
-            g.setColour (ledOn ? Colours::red.brighter (0.0f) : Colours::darkred.darker (0.75f));
-            g.fillEllipse (ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f);
-            g.setColour (Colours::black.withAlpha (0.6f));
-            g.drawEllipse (ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f, 1.0f);
+        Point<float> getFootCentre() const
+        {
+            return { getWidth() * 0.5f, getHeight() - 50.0f };
         }
 
         void resized() override
         {
+            pedalLayer.invalidate();
+
             auto r = getLocalBounds().reduced (15);
             Rectangle<int> topBar = r.removeFromTop (140);
 
@@ -288,8 +319,11 @@ public:
         }
 
     private:
-        void timerCallback() override
+        void uiTick() override
         {
+            if (! changeTracker.hasChanged())
+                return;
+
             if (gainParam && bypassParam)
             {
                 const float pGain = FxCommon::getDisplayValueForParameter(&processor, gainParam);
@@ -304,7 +338,12 @@ public:
                 if (bypassButton.getToggleState() != pBypass)
                     bypassButton.setToggleState (pBypass, dontSendNotification);
 
-                repaint();
+                // Regler und Schalter zeichnen sich selbst neu, im paint() haengt nur die LED vom Zustand ab
+                if (pBypass != ledShowsBypass)
+                {
+                    ledShowsBypass = pBypass;
+                    repaint (ledArea);
+                }
             }
         }
 
@@ -332,6 +371,10 @@ public:
         ToggleButton bypassButton;
         juce::TextButton hardwareMappingButton;
         FxCommon::HardwareMappingPopup hardwareMappingPopup;
+        FxCommon::EditorChangeTracker changeTracker { processor };
+        Rectangle<int> ledArea;      // von paint() gesetzt
+        bool ledShowsBypass = false;
+        FxCommon::CachedLayer pedalLayer { juce::Image::RGB };
 
         FxCommon::PedalLookAndFeel pedalLaf;
 
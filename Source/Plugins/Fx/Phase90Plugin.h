@@ -16,7 +16,8 @@
 //==============================================================================
 // MXR Phase 90 style phaser processor with simple GUI (one SPEED knob + footswitch)
 // NOTE: Audio is ALWAYS wet. Bypass parameter only affects UI/LED state, not audio path.
-class Phase90Processor final : public juce::AudioProcessor
+class Phase90Processor final : public juce::AudioProcessor,
+                               public FxCommon::TailRenderer
 {
 public:
     Phase90Processor()
@@ -51,12 +52,27 @@ public:
     // main processing (float)
     void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer&) override
     {
-        juce::ScopedNoDenormals noDenormals;
-
         const bool isBypassed = FxCommon::applyMappedBypassFromHardware(this, bypass);
         if (isBypassed)
             return;
 
+        processChannels(buffer);
+    }
+
+    // double precision not implemented
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override
+    {
+        jassertfalse;
+    }
+
+    // Ausblenden beim Bypass; double wird wie oben nicht unterstuetzt
+    void processIgnoringBypass(juce::AudioBuffer<float>& buffer) override { processChannels(buffer); }
+    void processIgnoringBypass(juce::AudioBuffer<double>&) override {}
+
+    void processChannels(juce::AudioBuffer<float>& buffer)
+    {
+        juce::ScopedNoDenormals noDenormals;
+
         const int numChannels = jmin(2, buffer.getNumChannels());
         const int numSamples = buffer.getNumSamples();
 
@@ -130,12 +146,6 @@ public:
         // leave extra channels untouched (if any)
     }
 
-    // double precision not implemented
-    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override
-    {
-        jassertfalse;
-    }
-
     //============================================================================== 
     juce::AudioProcessorEditor* createEditor() override { return new Editor(*this, rate, bypass); }
     bool hasEditor() const override { return true; }
@@ -146,6 +156,7 @@ public:
     bool producesMidi() const override { return false; }
     bool isMidiEffect() const override { return false; }
     double getTailLengthSeconds() const override { return 0.0; }
+    juce::AudioProcessorParameter* getBypassParameter() const override { return bypass; }
 
     //============================================================================== 
     int getNumPrograms() override { return 1; }
@@ -186,7 +197,7 @@ public:
     // Editor: simple single-knob script-logo style pedal
     class Editor final : public juce::AudioProcessorEditor,
                          private juce::Slider::Listener,
-                         private juce::Timer
+                         private FxCommon::UiTick::Subscriber
     {
     public:
         Editor(Phase90Processor& p, juce::AudioParameterFloat* rateParam, juce::AudioParameterBool* bypassParam)
@@ -232,19 +243,39 @@ public:
             addAndMakeVisible(hardwareMappingButton);
             FxCommon::initialiseHardwareMappingUI(*this, hardwareMappingButton, hardwareMappingPopup, &processor);
 
-            // Start polling timer (same approach as GainProcessor)
-            startTimerHz(30);
+            // Poll parameters on the shared UI tick (same approach as GainProcessor)
+            FxCommon::UiTick::instance().subscribe(*this, *this);
             setWantsKeyboardFocus(false);
         }
 
         ~Editor() override
         {
-            stopTimer();
+            FxCommon::UiTick::instance().unsubscribe(*this);
             rateSlider.removeListener(this);
             setLookAndFeel(nullptr);
         }
 
         void paint(juce::Graphics& g) override
+        {
+            // der unveraenderliche Teil kommt aus dem Bild-Cache, nur die LED wird jedes Mal gezeichnet
+            pedalLayer.draw(g, getLocalBounds(), [this](juce::Graphics& lg) { paintPedal(lg); });
+
+            const auto footCentre = getFootCentre();
+
+            // LED: lights when effect engaged (not bypassed) — purely visual
+            bool isBypassed = (bypassParameter ? static_cast<bool>(*bypassParameter) : false);
+            bool ledOn = !isBypassed;
+            float ledR = 7.0f;
+            juce::Point<float> ledPos(footCentre.x, footCentre.y - 52.0f);
+            ledArea = FxCommon::getLedRepaintArea(ledPos, ledR);
+            if (ledOn) g.setColour(juce::Colours::red.brighter(0.0f));
+            else g.setColour(juce::Colours::darkred.darker(0.7f));
+            g.fillEllipse(ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f);
+            g.setColour(juce::Colours::black.withAlpha(0.6f));
+            g.drawEllipse(ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f, 1.0f);
+        }
+
+        void paintPedal(juce::Graphics& g)
         {
             auto bounds = getLocalBounds().toFloat();
             // orange pedal background
@@ -259,7 +290,7 @@ public:
             g.drawFittedText("Phase 90", getWidth() / 2 - 80, 18, 160, 30, juce::Justification::centred, 1);
 
             // draw footswitch
-            juce::Point<float> footCentre(bounds.getCentreX(), bounds.getBottom() - 72.0f);
+            const auto footCentre = getFootCentre();
             float footR = 26.0f;
             juce::Colour metal = juce::Colour::fromRGB(200, 200, 200);
             g.setColour(metal.overlaidWith(juce::Colours::white.withAlpha(0.15f)));
@@ -267,24 +298,20 @@ public:
             g.setColour(metal.contrasting(0.4f));
             g.drawEllipse(footCentre.x - footR, footCentre.y - footR, footR * 2.0f, footR * 2.0f, 2.0f);
 
-            // LED: lights when effect engaged (not bypassed) — purely visual
-            bool isBypassed = (bypassParameter ? static_cast<bool>(*bypassParameter) : false);
-            bool ledOn = !isBypassed;
-            float ledR = 7.0f;
-            juce::Point<float> ledPos(footCentre.x, footCentre.y - 52.0f);
-            if (ledOn) g.setColour(juce::Colours::red.brighter(0.0f));
-            else g.setColour(juce::Colours::darkred.darker(0.7f));
-            g.fillEllipse(ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f);
-            g.setColour(juce::Colours::black.withAlpha(0.6f));
-            g.drawEllipse(ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f, 1.0f);
-
             // small border
             g.setColour(juce::Colours::black.withAlpha(0.35f));
             g.drawRoundedRectangle(bounds.reduced(10.0f), 6.0f, 2.0f);
         }
 
+        juce::Point<float> getFootCentre() const
+        {
+            return { getWidth() * 0.5f, getHeight() - 72.0f };
+        }
+
         void resized() override
         {
+            pedalLayer.invalidate();
+
             auto r = getLocalBounds().reduced(18);
             int knobSize = 120;
             int cx = r.getCentreX();
@@ -307,8 +334,11 @@ public:
         }
 
     private:
-        void timerCallback() override
+        void uiTick() override
         {
+            if (! changeTracker.hasChanged())
+                return;
+
             if (rateParameter && bypassParameter)
             {
                 const float pRate = FxCommon::getDisplayValueForParameter(&processor, rateParameter);
@@ -323,7 +353,12 @@ public:
                 if (bypassButton.getToggleState() != pBy)
                     bypassButton.setToggleState(pBy, juce::dontSendNotification);
 
-                repaint();
+                // Regler und Schalter zeichnen sich selbst neu, im paint() haengt nur die LED vom Zustand ab
+                if (pBy != ledShowsBypass)
+                {
+                    ledShowsBypass = pBy;
+                    repaint(ledArea);
+                }
             }
         }
 
@@ -353,6 +388,10 @@ public:
         juce::ToggleButton bypassButton;
         juce::TextButton hardwareMappingButton;
         FxCommon::HardwareMappingPopup hardwareMappingPopup;
+        FxCommon::EditorChangeTracker changeTracker { processor };
+        juce::Rectangle<int> ledArea;      // von paint() gesetzt
+        bool ledShowsBypass = false;
+        FxCommon::CachedLayer pedalLayer { juce::Image::RGB };
 
         // Use shared pedal look-and-feel from FxCommon
         FxCommon::PedalLookAndFeel laf;
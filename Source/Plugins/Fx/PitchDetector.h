@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    PitchDetector.h
+    Created: 16 Oct 2026 9:12:40am
+    Author:  motzi
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <cmath>
+#include <vector>
+
+//==============================================================================
+// Pitch detector core shared by ChromaticTuner and the PitchShifter harmonizer.
+// Works on a contiguous frame that is owned by the caller (the tuner's
+// linearised ring buffer, or the PitchShifter's analysis ring), so the
+// detector itself keeps no audio history and never allocates after prepare().
+//
+// Normalised autocorrelation (McLeod's NSDF): every lag is scaled by the energy
+// of both windows, so a clear period scores close to 1 regardless of level.
+// The first peak within a few percent of the best one wins, which avoids
+// picking a multiple of the period, and frames without a clear peak return 0.
+//==============================================================================
+
+class PitchDetector
+{
+public:
+    static constexpr float minFrequency = 60.0f;
+    static constexpr float maxFrequency = 1200.0f;
+
+    //==============================================================================
+    void prepare(double sampleRateIn)
+    {
+        sampleRate = sampleRateIn;
+        minPeriod = juce::jmax(2, static_cast<int>(sampleRate / maxFrequency));
+        maxPeriod = static_cast<int>(std::ceil(sampleRate / minFrequency)) + 1;
+        nsdf.assign((size_t) maxPeriod + 2, 0.0f);
+    }
+
+    // Frames shorter than this can't hold two periods of the lowest note
+    // (2 * sampleRate / 60 Hz); longer frames are cut to their newest samples.
+    int getRequiredFrameSize() const { return 2 * maxPeriod; }
+
+    // Returns the detected fundamental in Hz, or 0 if the frame is too quiet,
+    // too short, or has no clear period.
+    float detect(const float* frame, int frameSize) const
+    {
+        const int required = getRequiredFrameSize();
+
+        if (frame == nullptr || frameSize < required || nsdf.empty())
+            return 0.0f;
+
+        frame += frameSize - required;
+
+        // window and longest lag both span maxPeriod samples
+        const int window = maxPeriod;
+
+        // Calculate RMS to check if signal is strong enough
+        float energy0 = 0.0f;
+        for (int i = 0; i < window; ++i)
+            energy0 += frame[i] * frame[i];
+
+        if (std::sqrt(energy0 / window) < 0.01f) // Signal too weak
+            return 0.0f;
+
+        float energyLag = energy0;
+
+        for (int lag = 1; lag <= maxPeriod; ++lag)
+        {
+            energyLag += frame[lag + window - 1] * frame[lag + window - 1] - frame[lag - 1] * frame[lag - 1];
+
+            float corr = 0.0f;
+            for (int i = 0; i < window; ++i)
+                corr += frame[i] * frame[i + lag];
+
+            const float denominator = energy0 + energyLag;
+            nsdf[(size_t) lag] = denominator > 0.0f ? 2.0f * corr / denominator : 0.0f;
+        }
+
+        // the lobe around lag 0 says nothing about the period, skip it
+        int firstLag = 1;
+        while (firstLag < maxPeriod && nsdf[(size_t) firstLag] >= 0.0f)
+            ++firstLag;
+
+        firstLag = juce::jmax(firstLag, minPeriod);
+
+        float highest = 0.0f;
+        for (int lag = firstLag; lag < maxPeriod; ++lag)
+            highest = juce::jmax(highest, nsdf[(size_t) lag]);
+
+        if (highest < clarityThreshold)
+            return 0.0f;
+
+        // the first maximum that comes close to the best one is the period, later ones are multiples
+        for (int lag = firstLag; lag < maxPeriod; ++lag)
+        {
+            const float value = nsdf[(size_t) lag];
+
+            if (value < peakRatio * highest || value < nsdf[(size_t) lag - 1] || value < nsdf[(size_t) lag + 1])
+                continue;
+
+            // parabolic interpolation between the neighbouring lags
+            const float a = nsdf[(size_t) lag - 1], c = nsdf[(size_t) lag + 1];
+            const float curvature = a - 2.0f * value + c;
+            const float offset = curvature < 0.0f ? 0.5f * (a - c) / curvature : 0.0f;
+
+            return static_cast<float>(sampleRate / (lag + offset));
+        }
+
+        return 0.0f;
+    }
+
+    // A4 = 440 Hz, MIDI note 69: n = 69 + 12 * log2(f / 440)
+    static float frequencyToMidiNote(float frequency)
+    {
+        return 69.0f + 12.0f * std::log2(frequency / 440.0f);
+    }
+
+private:
+    static constexpr float clarityThreshold = 0.6f;  // below: noise, chords, decaying mush
+    static constexpr float peakRatio = 0.9f;
+
+    double sampleRate = 44100.0;
+    int minPeriod = 36;
+    int maxPeriod = 736;
+    mutable std::vector<float> nsdf;
+};
@@ -12,14 +12,481 @@
 
 #include <JuceHeader.h>
 #include "FxCommon.h"
+#include "PitchDetector.h"
+#include <array>
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <cmath>
 
+//==============================================================================
+// Studio-Modus: Phase-Vocoder auf Basis von juce::dsp::FFT.
+// Eine Analyse pro Hop wird von allen Stimmen geteilt; die Stimmen werden im
+// Spektrum aufsummiert, so dass pro Hop genau eine Vorwaerts- und eine
+// Rueckwaerts-FFT anfallen - unabhaengig von der Anzahl aktiver Stimmen.
+// Identity phase locking (Laroche/Dolson) haelt die Bins um jeden Peak
+// phasenstarr, bei Transienten werden die Synthesephasen zurueckgesetzt.
+class SpectralPitchEngine
+{
+public:
+    static constexpr int minOrder = 9;   // 512
+    static constexpr int maxOrder = 11;  // 2048
+    static constexpr int overlap = 4;
+    static constexpr int maxVoices = 6;  // 4 Oktaven + 2 Harmony-Stimmen
+
+    using Ratios = std::array<double, maxVoices>; // <= 0.0 -> voice inactive
+
+    // allocates everything for the largest FFT size, call from prepareToPlay only
+    void prepare(int initialOrder)
+    {
+        // die FFT-Objekte haengen nicht von der Samplerate ab - nur einmal anlegen
+        for (int o = minOrder; o <= maxOrder; ++o)
+            if (ffts[(size_t) (o - minOrder)] == nullptr)
+                ffts[(size_t) (o - minOrder)] = std::make_unique<juce::dsp::FFT>(o);
+
+        const int maxSize = 1 << maxOrder;
+        const int maxBins = maxSize / 2 + 1;
+
+        inFifo.assign((size_t) maxSize, 0.0f);
+        outFifo.assign((size_t) maxSize, 0.0f);
+        outAccum.assign((size_t) maxSize * 2, 0.0f);
+        fftData.assign((size_t) maxSize * 2, 0.0f);
+        window.assign((size_t) maxSize, 0.0f);
+
+        magnitude.assign((size_t) maxBins, 0.0f);
+        phase.assign((size_t) maxBins, 0.0f);
+        lastPhase.assign((size_t) maxBins, 0.0f);
+        trueBin.assign((size_t) maxBins, 0.0f);
+        peaks.assign((size_t) maxBins, 0);
+        sumRe.assign((size_t) maxBins, 0.0f);
+        sumIm.assign((size_t) maxBins, 0.0f);
+
+        for (auto& v : voices)
+            v.synthPhase.assign((size_t) maxBins, 0.0f);
+
+        setOrder(initialOrder);
+    }
+
+    // switches the FFT size without allocating (buffers are sized for maxOrder)
+    void setOrder(int newOrder)
+    {
+        order = juce::jlimit(minOrder, maxOrder, newOrder);
+        size = 1 << order;
+        hop = size / overlap;
+        latency = size - hop;
+        bins = size / 2 + 1;
+
+        for (int n = 0; n < size; ++n)
+            window[(size_t) n] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * (float) n / (float) size);
+
+        reset();
+    }
+
+    void reset()
+    {
+        std::fill(inFifo.begin(), inFifo.end(), 0.0f);
+        std::fill(outFifo.begin(), outFifo.end(), 0.0f);
+        std::fill(outAccum.begin(), outAccum.end(), 0.0f);
+        std::fill(magnitude.begin(), magnitude.end(), 0.0f);
+        std::fill(lastPhase.begin(), lastPhase.end(), 0.0f);
+
+        for (auto& v : voices)
+        {
+            std::fill(v.synthPhase.begin(), v.synthPhase.end(), 0.0f);
+            v.wasActive = false;
+        }
+
+        rover = latency;
+    }
+
+    int getOrder() const { return order; }
+    int getLatencySamples() const { return latency; }
+
+    // Incremented for every analysed hop; lets callers skip work when no new frame arrived.
+    juce::uint32 getFrameCount() const { return frameCount; }
+
+    // Returns the wet sample; delayedDry receives the input delayed by the
+    // engine latency so that dry/wet stay time-aligned.
+    float processSample(float in, const Ratios& ratios, bool wetEnabled, float& delayedDry)
+    {
+        inFifo[(size_t) rover] = in;
+        delayedDry = inFifo[(size_t) (rover - latency)];
+        const float out = outFifo[(size_t) (rover - latency)];
+
+        if (++rover >= size)
+        {
+            rover = latency;
+            ++frameCount;
+
+            if (wetEnabled)
+            {
+                processFrame(ratios);
+            }
+            else
+            {
+                std::fill(outFifo.begin(), outFifo.begin() + hop, 0.0f);
+
+                for (auto& v : voices)
+                    v.wasActive = false;
+            }
+
+            std::copy(inFifo.begin() + hop, inFifo.begin() + size, inFifo.begin());
+        }
+
+        return wetEnabled ? out : 0.0f;
+    }
+
+private:
+    struct Voice
+    {
+        std::vector<float> synthPhase;
+        bool wasActive = false;
+    };
+
+    static float wrapPhase(float p)
+    {
+        using MC = juce::MathConstants<float>;
+        p = std::fmod(p + MC::pi, MC::twoPi);
+        return p < 0.0f ? p + MC::pi : p - MC::pi;
+    }
+
+    void processFrame(const Ratios& ratios)
+    {
+        analyse();
+
+        std::fill(sumRe.begin(), sumRe.begin() + bins, 0.0f);
+        std::fill(sumIm.begin(), sumIm.begin() + bins, 0.0f);
+
+        int activeCount = 0;
+        for (auto r : ratios)
+            if (r > 0.0)
+                ++activeCount;
+
+        if (activeCount > 0)
+        {
+            const float gain = 1.0f / (float) activeCount;
+
+            for (size_t v = 0; v < voices.size(); ++v)
+            {
+                const bool active = ratios[v] > 0.0;
+
+                if (active)
+                    synthesiseVoice(voices[v], ratios[v], gain, transient || ! voices[v].wasActive);
+
+                voices[v].wasActive = active;
+            }
+        }
+        else
+        {
+            for (auto& v : voices)
+                v.wasActive = false;
+        }
+
+        resynthesise();
+    }
+
+    void analyse()
+    {
+        auto* data = fftData.data();
+
+        for (int n = 0; n < size; ++n)
+            data[n] = inFifo[(size_t) n] * window[(size_t) n];
+
+        std::fill(fftData.begin() + size, fftData.begin() + size * 2, 0.0f);
+        ffts[(size_t) (order - minOrder)]->performRealOnlyForwardTransform(data, true);
+
+        const float expected = juce::MathConstants<float>::twoPi * (float) hop / (float) size;
+        const float binsPerRadian = (float) overlap / juce::MathConstants<float>::twoPi;
+
+        float flux = 0.0f;
+        float energy = 0.0f;
+
+        for (int k = 0; k < bins; ++k)
+        {
+            const float re = data[2 * k];
+            const float im = data[2 * k + 1];
+            const float mag = std::sqrt(re * re + im * im);
+            const float ph = std::atan2(im, re);
+
+            flux += juce::jmax(0.0f, mag - magnitude[(size_t) k]);
+            energy += mag;
+            magnitude[(size_t) k] = mag;
+
+            const float delta = wrapPhase(ph - lastPhase[(size_t) k] - (float) k * expected);
+            lastPhase[(size_t) k] = ph;
+            phase[(size_t) k] = ph;
+            trueBin[(size_t) k] = (float) k + delta * binsPerRadian;
+        }
+
+        // spectral flux relative to frame energy -> onset, synthesis phases get reset
+        transient = energy > energyFloor && flux > transientThreshold * energy;
+
+        numPeaks = 0;
+        const float peakFloor = energy * 1.0e-4f;
+
+        for (int k = 2; k < bins - 2; ++k)
+        {
+            const float m = magnitude[(size_t) k];
+
+            if (m > peakFloor
+                && m > magnitude[(size_t) k - 1] && m >= magnitude[(size_t) k + 1]
+                && m > magnitude[(size_t) k - 2] && m >= magnitude[(size_t) k + 2])
+                peaks[(size_t) numPeaks++] = k;
+        }
+    }
+
+    void synthesiseVoice(Voice& voice, double ratio, float gain, bool resetPhases)
+    {
+        const float expected = juce::MathConstants<float>::twoPi * (float) hop / (float) size;
+        const float r = (float) ratio;
+
+        for (int i = 0; i < numPeaks; ++i)
+        {
+            const int kp = peaks[(size_t) i];
+            const int kt = juce::roundToInt((float) kp * r);
+
+            if (kt <= 0 || kt >= bins)
+                continue;
+
+            float& peakPhase = voice.synthPhase[(size_t) kt];
+            peakPhase = resetPhases ? phase[(size_t) kp]
+                                    : wrapPhase(peakPhase + expected * trueBin[(size_t) kp] * r);
+
+            // region of influence: halfway to the neighbouring peaks
+            const int regionStart = i == 0 ? 0 : (peaks[(size_t) i - 1] + kp) / 2 + 1;
+            const int regionEnd = i == numPeaks - 1 ? bins - 1 : (kp + peaks[(size_t) i + 1]) / 2;
+
+            for (int k = regionStart; k <= regionEnd; ++k)
+            {
+                const int target = kt + (k - kp);
+
+                if (target < 0 || target >= bins)
+                    continue;
+
+                const float ph = peakPhase + (phase[(size_t) k] - phase[(size_t) kp]);
+                const float m = magnitude[(size_t) k] * gain;
+                sumRe[(size_t) target] += m * std::cos(ph);
+                sumIm[(size_t) target] += m * std::sin(ph);
+            }
+        }
+    }
+
+    void resynthesise()
+    {
+        auto* data = fftData.data();
+
+        for (int k = 0; k < bins; ++k)
+        {
+            data[2 * k] = sumRe[(size_t) k];
+            data[2 * k + 1] = sumIm[(size_t) k];
+        }
+
+        std::fill(fftData.begin() + bins * 2, fftData.end(), 0.0f);
+        ffts[(size_t) (order - minOrder)]->performRealOnlyInverseTransform(data);
+
+        // Hann analysis * Hann synthesis at 75% overlap sums to 1.5
+        constexpr float olaGain = 1.0f / 1.5f;
+
+        for (int n = 0; n < size; ++n)
+            outAccum[(size_t) n] += data[n] * window[(size_t) n] * olaGain;
+
+        std::copy(outAccum.begin(), outAccum.begin() + hop, outFifo.begin());
+        std::copy(outAccum.begin() + hop, outAccum.begin() + size + hop, outAccum.begin());
+        std::fill(outAccum.begin() + size, outAccum.begin() + size + hop, 0.0f);
+    }
+
+    static constexpr float transientThreshold = 0.45f;
+    static constexpr float energyFloor = 1.0e-3f;
+
+    std::array<std::unique_ptr<juce::dsp::FFT>, maxOrder - minOrder + 1> ffts;
+    int order = 10, size = 1024, hop = 256, latency = 768, bins = 513;
+    int rover = 0;
+    juce::uint32 frameCount = 0;
+
+    std::vector<float> inFifo, outFifo, outAccum, fftData, window;
+    std::vector<float> magnitude, phase, lastPhase, trueBin;
+    std::vector<float> sumRe, sumIm;
+    std::vector<int> peaks;
+    int numPeaks = 0;
+    bool transient = false;
+
+    std::array<Voice, maxVoices> voices;
+};
+
+//==============================================================================
+// Poly-Modus: polyphone Oktave abwaerts ohne Latenz (Prinzip wie beim POG).
+// Eine Bank aus Bandpaessen zerlegt das Signal, jedes Band wird per Flip-Flop
+// an seinen Nulldurchgaengen frequenzgeteilt (x * Rechteck mit f/2 -> f/2) und
+// von einem zweiten Bandpass auf fc/2 gesaeubert; -2 Oktaven teilt das -1-Band
+// noch einmal und filtert auf fc/4. Da jedes Band nur einen Teilton sieht,
+// bleiben Akkorde sauber.
+// Layout ist structure-of-arrays: jeder Koeffizient/Zustand liegt als Array von
+// SIMDRegister-Paketen ueber die Baender vor, gerechnet wird paketweise.
+class PolyOctaveFilterBank
+{
+public:
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    static constexpr int numBands = 48;
+    static constexpr float lowestCentre = 60.0f;
+    static constexpr float highestCentre = 4000.0f;
+    static constexpr float bandQ = 8.0f;
+
+    // call from prepareToPlay only (allocates)
+    void prepare(double sampleRate)
+    {
+        numPacks = (numBands + (int) Vec::size() - 1) / (int) Vec::size();
+
+        for (auto* stage : { &split, &sub1, &sub2 })
+            stage->allocate((size_t) numPacks);
+
+        for (auto* v : { &flip1, &flip2, &prev1, &prev2 })
+            v->assign((size_t) numPacks, Vec::expand(0.0f));
+
+        std::vector<float> centres((size_t) numPacks * Vec::size(), 0.0f);
+        const float ratio = std::pow(highestCentre / lowestCentre, 1.0f / (float) (numBands - 1));
+
+        for (int b = 0; b < numBands; ++b)
+            centres[(size_t) b] = lowestCentre * std::pow(ratio, (float) b);
+
+        // Padding-Baender (b >= numBands) bleiben stumm: b0 = 0
+        split.design(centres, 1.0f, sampleRate);
+        sub1.design(centres, 0.5f, sampleRate);
+        sub2.design(centres, 0.25f, sampleRate);
+
+        // Rechteck-Grundwelle 4/pi, Mischprodukt halbiert -> 2/pi pro Teilung;
+        // benachbarte Baender ueberlappen sich um ca. (1/Q) / (ratio - 1)
+        const float overlap = juce::jmax(1.0f, (1.0f / bandQ) / (ratio - 1.0f));
+        outputGain = juce::MathConstants<float>::halfPi / overlap;
+
+        reset();
+    }
+
+    void reset()
+    {
+        for (auto* stage : { &split, &sub1, &sub2 })
+            stage->reset();
+
+        for (auto* v : { &flip1, &flip2, &prev1, &prev2 })
+            std::fill(v->begin(), v->end(), Vec::expand(0.0f));
+    }
+
+    // Zero latency: one input sample in, -1 and -2 octave samples out
+    void processSample(float in, float& down1Out, float& down2Out)
+    {
+        const Vec x = Vec::expand(in);
+        const Vec zero = Vec::expand(0.0f);
+        const Vec one = Vec::expand(1.0f);
+        const Vec two = Vec::expand(2.0f);
+
+        Vec acc1 = zero, acc2 = zero;
+
+        for (int p = 0; p < numPacks; ++p)
+        {
+            const auto i = (size_t) p;
+
+            const Vec band = split.process(i, x);
+            const Vec d1 = divide(band, prev1[i], flip1[i], zero, one, two);
+            const Vec s1 = sub1.process(i, d1);
+            const Vec d2 = divide(s1, prev2[i], flip2[i], zero, one, two);
+            const Vec s2 = sub2.process(i, d2);
+
+            acc1 += s1;
+            acc2 += s2;
+        }
+
+        down1Out = acc1.sum() * outputGain;
+        down2Out = acc2.sum() * outputGain * outputGain;
+    }
+
+private:
+    // Bandpass (RBJ, 0 dB peak): b1 = 0, b2 = -b0, transposed direct form II
+    struct BiquadBank
+    {
+        std::vector<Vec> b0, a1, a2, z1, z2;
+
+        void allocate(size_t packs)
+        {
+            for (auto* v : { &b0, &a1, &a2, &z1, &z2 })
+                v->assign(packs, Vec::expand(0.0f));
+        }
+
+        void reset()
+        {
+            for (auto* v : { &z1, &z2 })
+                std::fill(v->begin(), v->end(), Vec::expand(0.0f));
+        }
+
+        void design(const std::vector<float>& centres, float factor, double sampleRate)
+        {
+            alignas(Vec) float cb0[Vec::SIMDNumElements], ca1[Vec::SIMDNumElements], ca2[Vec::SIMDNumElements];
+
+            for (size_t p = 0; p < b0.size(); ++p)
+            {
+                for (size_t l = 0; l < Vec::size(); ++l)
+                {
+                    const float fc = centres[p * Vec::size() + l] * factor;
+                    cb0[l] = ca1[l] = ca2[l] = 0.0f;
+
+                    if (fc <= 0.0f || fc >= 0.45f * (float) sampleRate)
+                        continue;
+
+                    const float w0 = juce::MathConstants<float>::twoPi * fc / (float) sampleRate;
+                    const float alpha = std::sin(w0) / (2.0f * bandQ);
+                    const float a0 = 1.0f + alpha;
+
+                    cb0[l] = alpha / a0;
+                    ca1[l] = -2.0f * std::cos(w0) / a0;
+                    ca2[l] = (1.0f - alpha) / a0;
+                }
+
+                b0[p] = Vec::fromRawArray(cb0);
+                a1[p] = Vec::fromRawArray(ca1);
+                a2[p] = Vec::fromRawArray(ca2);
+            }
+        }
+
+        Vec process(size_t p, Vec x)
+        {
+            const Vec y = b0[p] * x + z1[p];
+            z1[p] = z2[p] - a1[p] * y;
+            z2[p] = (b0[p] * x + a2[p] * y) * -1.0f;
+            return y;
+        }
+    };
+
+    // Flip-Flop toggelt bei jedem positiven Nulldurchgang, Ausgang = x * (+/-1)
+    static Vec divide(Vec x, Vec& prev, Vec& flip, Vec zero, Vec one, Vec two)
+    {
+        const auto crossing = Vec::lessThanOrEqual(prev, zero) & Vec::greaterThan(x, zero);
+        const Vec c = one & crossing;
+
+        flip = flip + c - two * flip * c;
+        prev = x;
+
+        return x * (one - two * flip);
+    }
+
+    int numPacks = 0;
+    float outputGain = 1.0f;
+
+    BiquadBank split, sub1, sub2;
+    std::vector<Vec> flip1, flip2, prev1, prev2;
+};
+
 // Vereinfachter PitchShifter: 1 Blend-Regler + 4 Oktav-Tasten (+2, +1, -1, -2).
 // Alle Tasten knnen parallel aktiv sein; das Wet-Signal ist die (normierte) Summe
 // der aktiven Stimmen. Aufbau und Stil orientieren sich an GainProcessor.h.
 // Zustzlich: einfache LPF + HPF auf dem Wet-Signal, um klicks/Artefakte zu reduzieren.
-class PitchShifter final : public AudioProcessor
+// Harmony-Modus: zwei Stimmen mit tonartabhaengigen Intervallen; die Tonhoehe wird
+// pro Hop einmal mit dem Tuner-Detektor (PitchDetector) aus einem eigenen Analyse-Ring
+// geschaetzt (der FIFO der Engine ist fuer tiefe Saiten zu kurz), jede weitere Stimme
+// kostet nur ihre Synthese.
+// Poly-Modus: -1/-2 Oktaven kommen aus der PolyOctaveFilterBank (ohne Latenz),
+// die Oktaven nach oben weiter aus dem klassischen Pfad.
+class PitchShifter final : public AudioProcessor,
+                           public FxCommon::TailRenderer,
+                           private AsyncUpdater
 {
 public:
     //==============================================================================
@@ -33,6 +500,17 @@ public:
         addParameter(down1 = new AudioParameterBool({ "down1", 1 }, "-1Oct", false));
         addParameter(down2 = new AudioParameterBool({ "down2", 1 }, "-2Oct", false));
         addParameter(bypass = new AudioParameterBool({ "bypass", 1 }, "Bypass", false));
+        addParameter(mode = new AudioParameterChoice({ "mode", 1 }, "Mode", StringArray { "Classic", "Studio", "Harmony", "Poly" }, 0));
+        addParameter(fftSize = new AudioParameterChoice({ "fftsize", 1 }, "FFT Size", StringArray { "512", "1024", "2048" }, 1));
+        addParameter(harmonyKey = new AudioParameterChoice({ "key", 1 }, "Key", getKeyNames(), 0));
+        addParameter(harmonyScale = new AudioParameterChoice({ "scale", 1 }, "Scale", StringArray { "Major", "Minor" }, 0));
+        addParameter(harmony1 = new AudioParameterChoice({ "harmony1", 1 }, "Harmony 1", getIntervalNames(), 2));
+        addParameter(harmony2 = new AudioParameterChoice({ "harmony2", 1 }, "Harmony 2", getIntervalNames(), 0));
+    }
+
+    ~PitchShifter() override
+    {
+        cancelPendingUpdate();
     }
 
     //==============================================================================
@@ -58,6 +536,20 @@ public:
 
         recomputeRatios();
         updateFilterCoeffs();
+
+        // Studio-Engine: alle Puffer fuer 2048 vorallozieren, Umschalten der
+        // FFT-Groesse im Audio-Thread ist danach allokationsfrei
+        spectralEngine.prepare(getSelectedFftOrder());
+        pitchDetector.prepare(sampleRate);
+        analysisFrame.assign((size_t) pitchDetector.getRequiredFrameSize(), 0.0f);
+        analysisRing.assign((size_t) nextPowerOfTwo(pitchDetector.getRequiredFrameSize()), 0.0f);
+        analysisWritePos = 0;
+        octaveBank.prepare(sampleRate);
+        lastAnalysedFrame = spectralEngine.getFrameCount();
+        harmonyRatios = { 0.0, 0.0 };
+        studioActive = isStudioModeSelected();
+        reportedLatency.store(studioActive ? spectralEngine.getLatencySamples() : 0);
+        setLatencySamples(reportedLatency.load());
     }
 
     void releaseResources() override {}
@@ -65,11 +557,8 @@ public:
     //==============================================================================
 
     template<typename SampleType>
-    inline SampleType processSampleInternal(SampleType in)
+    inline SampleType processSampleInternal(SampleType in, bool polyDown)
     {
-        if (bypass && static_cast<bool>(*bypass))
-            return in;
-
         // write input into ring buffer
         buffer[writeIndex] = static_cast<double>(in);
         writeIndex = bufferIdxWrap(writeIndex + 1);
@@ -99,8 +588,21 @@ public:
 
         if (static_cast<bool>(*up2)) { processVoice(up2, voicePosUp2, stepUp2, sUp2); ++activeCount; }
         if (static_cast<bool>(*up1)) { processVoice(up1, voicePosUp1, stepUp1, sUp1); ++activeCount; }
-        if (static_cast<bool>(*down1)) { processVoice(down1, voicePosDown1, stepDown1, sDown1); ++activeCount; }
-        if (static_cast<bool>(*down2)) { processVoice(down2, voicePosDown2, stepDown2, sDown2); ++activeCount; }
+
+        if (polyDown)
+        {
+            // Filterbank laeuft immer mit, damit das Zuschalten ohne Einschwingen klappt
+            float bankDown1 = 0.0f, bankDown2 = 0.0f;
+            octaveBank.processSample(static_cast<float>(in), bankDown1, bankDown2);
+
+            if (static_cast<bool>(*down1)) { sDown1 = bankDown1; ++activeCount; }
+            if (static_cast<bool>(*down2)) { sDown2 = bankDown2; ++activeCount; }
+        }
+        else
+        {
+            if (static_cast<bool>(*down1)) { processVoice(down1, voicePosDown1, stepDown1, sDown1); ++activeCount; }
+            if (static_cast<bool>(*down2)) { processVoice(down2, voicePosDown2, stepDown2, sDown2); ++activeCount; }
+        }
 
         double sum = sUp2 + sUp1 + sDown1 + sDown2;
         double wet = 0.0;
@@ -109,55 +611,119 @@ public:
         else
             wet = 0.0;
 
-        // --- Filtering to reduce clicks/artifacts ---
-        // 1) gentle lowpass (anti-alias / soften transients)
-        double lpOut = lpfAlpha * wet + (1.0 - lpfAlpha) * wetLpState;
-        wetLpState = lpOut;
-
-        // 2) DC-blocking highpass to remove slow offsets after transients
-        // y[n] = hpAlpha * (y[n-1] + x[n] - x[n-1])
-        double hpOut = hpfAlpha * (wetHpState + lpOut - lastHpIn);
-        wetHpState = hpOut;
-        lastHpIn = lpOut;
-
-        // blend wet/dry
-        const double blendVal = static_cast<double>(*blend);
-        double out = static_cast<double>(in) * (1.0 - blendVal) + hpOut * blendVal;
+        const double hpOut = filterWet(wet);
 
-        // soft limit
-        out = std::tanh(out * 5.0) * 0.999;
+        return static_cast<SampleType>(blendAndLimit(static_cast<double>(in), hpOut));
+    }
 
-        return static_cast<SampleType>(out);
+    template<typename SampleType>
+    void processBlockInternal(AudioBuffer<SampleType>& bufferIn)
+    {
+        processChannels(bufferIn, FxCommon::applyMappedBypassFromHardware(this, bypass));
     }
 
-    void processBlock(AudioBuffer<float>& bufferIn, MidiBuffer&) override
+    template<typename SampleType>
+    void processChannels(AudioBuffer<SampleType>& bufferIn, bool isBypassed)
     {
-        const bool isBypassed = FxCommon::applyMappedBypassFromHardware(this, bypass);
-        if (isBypassed)
-            return;
+        updateStudioConfiguration();
 
         const int numSamples = bufferIn.getNumSamples();
         auto* ch0 = bufferIn.getWritePointer(0);
 
+        // im Studio-Modus laeuft die Engine auch bei Bypass weiter, damit das
+        // trockene Signal die gemeldete Latenz behaelt
+        if (studioActive)
+        {
+            processStudioBlock(ch0, numSamples, isBypassed);
+            return;
+        }
+
+        if (isBypassed)
+            return;
+
+        const bool polyDown = isPolyModeSelected();
+
+        for (int i = 0; i < numSamples; ++i)
+            ch0[i] = processSampleInternal<SampleType>(ch0[i], polyDown);
+    }
+
+    template<typename SampleType>
+    void processStudioBlock(SampleType* data, int numSamples, bool isBypassed)
+    {
+        if (isHarmonyModeSelected() && ! isBypassed)
+            updateHarmonyRatios();
+
+        const bool harmony = isHarmonyModeSelected();
+
+        const SpectralPitchEngine::Ratios ratios {
+            static_cast<bool>(*up2) ? stepUp2 : 0.0,
+            static_cast<bool>(*up1) ? stepUp1 : 0.0,
+            static_cast<bool>(*down1) ? stepDown1 : 0.0,
+            static_cast<bool>(*down2) ? stepDown2 : 0.0,
+            harmony && harmony1->getIndex() != 0 ? harmonyRatios[0] : 0.0,
+            harmony && harmony2->getIndex() != 0 ? harmonyRatios[1] : 0.0
+        };
+
         for (int i = 0; i < numSamples; ++i)
-            ch0[i] = processSampleInternal<float>(ch0[i]);
+        {
+            if (harmony)
+            {
+                analysisRing[(size_t) analysisWritePos] = static_cast<float>(data[i]);
+                analysisWritePos = (analysisWritePos + 1) & ((int) analysisRing.size() - 1);
+            }
+
+            float dry = 0.0f;
+            const float wet = spectralEngine.processSample(static_cast<float>(data[i]), ratios, ! isBypassed, dry);
+
+            if (isBypassed)
+            {
+                data[i] = static_cast<SampleType>(dry);
+                continue;
+            }
+
+            data[i] = static_cast<SampleType>(blendAndLimit(static_cast<double>(dry), filterWet(static_cast<double>(wet))));
+        }
+    }
+
+    void processBlock(AudioBuffer<float>& bufferIn, MidiBuffer&) override
+    {
+        processBlockInternal(bufferIn);
     }
 
     void processBlock(AudioBuffer<double>& bufferIn, MidiBuffer&) override
     {
-        const bool isBypassed = FxCommon::applyMappedBypassFromHardware(this, bypass);
-        if (isBypassed)
-            return;
+        processBlockInternal(bufferIn);
+    }
 
-        const int numSamples = bufferIn.getNumSamples();
-        auto* ch0 = bufferIn.getWritePointer(0);
+    // Bypass von aussen (Graph, Snapshots): wie der eigene Bypass-Parameter das trockene
+    // Signal um die Engine-Latenz verzoegert ausgeben, sonst springen parallele Pfade und
+    // das Umschalten in der Zeit (die Standard-Implementierung verlangt Latenz 0)
+    void processBlockBypassed(AudioBuffer<float>& bufferIn, MidiBuffer&) override
+    {
+        processBlockBypassedInternal(bufferIn);
+    }
 
-        for (int i = 0; i < numSamples; ++i)
-            ch0[i] = processSampleInternal<double>(ch0[i]);
+    void processBlockBypassed(AudioBuffer<double>& bufferIn, MidiBuffer&) override
+    {
+        processBlockBypassedInternal(bufferIn);
     }
 
+    template<typename SampleType>
+    void processBlockBypassedInternal(AudioBuffer<SampleType>& bufferIn)
+    {
+        updateStudioConfiguration();
+
+        if (studioActive)
+            processStudioBlock(bufferIn.getWritePointer(0), bufferIn.getNumSamples(), true);
+    }
+
+    // der Renderer blendet beim Bypass ueber einen Block mit dem Effektsignal aus
+    void processIgnoringBypass(AudioBuffer<float>& bufferIn) override { processChannels(bufferIn, false); }
+    void processIgnoringBypass(AudioBuffer<double>& bufferIn) override { processChannels(bufferIn, false); }
+
     //==============================================================================
-    AudioProcessorEditor* createEditor() override { return new Editor(*this, blend, up2, up1, down1, down2, bypass); }
+    AudioProcessorEditor* createEditor() override { return new Editor(*this, blend, up2, up1, down1, down2, bypass, mode, fftSize,
+                                                                                    harmonyKey, harmonyScale, harmony1, harmony2); }
     bool hasEditor() const override { return true; }
 
     //==============================================================================
@@ -165,6 +731,7 @@ public:
     bool acceptsMidi() const override { return false; }
     bool producesMidi() const override { return false; }
     double getTailLengthSeconds() const override { return 0.0; }
+    AudioProcessorParameter* getBypassParameter() const override { return bypass; }
 
     //==============================================================================
     int getNumPrograms() override { return 1; }
@@ -183,6 +750,12 @@ public:
         stream.writeFloat(static_cast<float>(down1 ? static_cast<float>(*down1) : 0.0f));
         stream.writeFloat(static_cast<float>(down2 ? static_cast<float>(*down2) : 0.0f));
         stream.writeFloat(static_cast<float>(bypass ? static_cast<float>(*bypass) : 0.0f));
+        stream.writeInt(mode->getIndex());
+        stream.writeInt(fftSize->getIndex());
+        stream.writeInt(harmonyKey->getIndex());
+        stream.writeInt(harmonyScale->getIndex());
+        stream.writeInt(harmony1->getIndex());
+        stream.writeInt(harmony2->getIndex());
     }
 
     void setStateInformation(const void* data, int sizeInBytes) override
@@ -194,6 +767,21 @@ public:
         if (down1) down1->setValueNotifyingHost(stream.readFloat());
         if (down2) down2->setValueNotifyingHost(stream.readFloat());
         if (bypass) bypass->setValueNotifyingHost(stream.readFloat());
+
+        // Mode/FFT-Groesse sind spaeter dazugekommen - aeltere States enden hier
+        if (! stream.isExhausted())
+            *mode = stream.readInt();
+        if (! stream.isExhausted())
+            *fftSize = stream.readInt();
+        if (! stream.isExhausted())
+            *harmonyKey = stream.readInt();
+        if (! stream.isExhausted())
+            *harmonyScale = stream.readInt();
+        if (! stream.isExhausted())
+            *harmony1 = stream.readInt();
+        if (! stream.isExhausted())
+            *harmony2 = stream.readInt();
+
         recomputeRatios();
     }
 
@@ -211,7 +799,7 @@ public:
     class Editor final : public AudioProcessorEditor,
                          private Slider::Listener,
                          private Button::Listener,
-                         private Timer
+                         private FxCommon::UiTick::Subscriber
     {
     public:
         Editor(PitchShifter& p,
@@ -220,7 +808,13 @@ public:
                AudioParameterBool* up1Param,
                AudioParameterBool* down1Param,
                AudioParameterBool* down2Param,
-               AudioParameterBool* bypassParam)
+               AudioParameterBool* bypassParam,
+               AudioParameterChoice* modeParam,
+               AudioParameterChoice* fftSizeParam,
+               AudioParameterChoice* keyParam,
+               AudioParameterChoice* scaleParam,
+               AudioParameterChoice* harmony1Param,
+               AudioParameterChoice* harmony2Param)
             : AudioProcessorEditor(&p),
               processor(p),
               blendParameter(blendParam),
@@ -228,10 +822,16 @@ public:
               up1Parameter(up1Param),
               down1Parameter(down1Param),
               down2Parameter(down2Param),
-              bypassParameter(bypassParam)
+              bypassParameter(bypassParam),
+              modeParameter(modeParam),
+              fftSizeParameter(fftSizeParam),
+              keyParameter(keyParam),
+              scaleParameter(scaleParam),
+              harmony1Parameter(harmony1Param),
+              harmony2Parameter(harmony2Param)
         {
             setLookAndFeel(&pedalLaf);
-            setSize(320, 420);
+            setSize(320, 480);
 
             const float baseStart = 2.09439510239319549f;
             const float baseEnd   = -2.09439510239319549f;
@@ -266,6 +866,35 @@ public:
                 addAndMakeVisible(b);
             }
 
+            // Modus (Classic / Studio / Harmony) + FFT-Groesse
+            // Harmony: Tonart, Tonleiter und zwei Intervalle
+            auto initChoiceBox = [this](ComboBox& box, AudioParameterChoice* param)
+            {
+                if (param == nullptr)
+                    return;
+
+                box.addItemList(param->choices, 1);
+                box.setSelectedItemIndex(param->getIndex(), dontSendNotification);
+                box.onChange = [&box, param]()
+                {
+                    if (box.getSelectedItemIndex() >= 0)
+                        *param = box.getSelectedItemIndex();
+                };
+                addAndMakeVisible(box);
+            };
+
+            initChoiceBox(modeBox, modeParameter);
+            initChoiceBox(fftSizeBox, fftSizeParameter);
+            initChoiceBox(keyBox, keyParameter);
+            initChoiceBox(scaleBox, scaleParameter);
+            initChoiceBox(harmony1Box, harmony1Parameter);
+            initChoiceBox(harmony2Box, harmony2Parameter);
+
+            addAndMakeVisible(latencyLabel);
+            latencyLabel.setJustificationType(Justification::centredLeft);
+            latencyLabel.setColour(Label::textColourId, Colours::lightgrey);
+            latencyLabel.setFont(Font(11.0f));
+
             // LED small indicators
             addAndMakeVisible(ledUp2);
             addAndMakeVisible(ledUp1);
@@ -287,13 +916,13 @@ public:
             if (down2Parameter) down2Button.setToggleState(static_cast<bool>(*down2Parameter), dontSendNotification);
             if (bypassParameter) bypassToggle.setToggleState(static_cast<bool>(*bypassParameter), dontSendNotification);
 
-            startTimerHz(30);
+            FxCommon::UiTick::instance().subscribe(*this, *this);
             setWantsKeyboardFocus(false);
         }
 
         ~Editor() override
         {
-            stopTimer();
+            FxCommon::UiTick::instance().unsubscribe(*this);
             blendSlider.removeListener(this);
             up2Button.removeListener(this);
             up1Button.removeListener(this);
@@ -304,6 +933,12 @@ public:
         }
 
         void paint(Graphics& g) override
+        {
+            // paint() haengt von keinem Parameter ab und kommt ganz aus dem Bild-Cache
+            pedalLayer.draw(g, getLocalBounds(), [this](Graphics& lg) { paintPedal(lg); });
+        }
+
+        void paintPedal(Graphics& g)
         {
             auto bounds = getLocalBounds().toFloat();
             g.fillAll(Colours::black.brighter(0.02f));
@@ -336,11 +971,13 @@ public:
             g.drawFittedText("PITCH FORK", Rectangle<int>((int)title.getX(), (int)title.getY(), (int)title.getWidth(), (int)title.getHeight()), Justification::centred, 1);
 
             // LED cluster for active voices
-            // (drawn by Timer via repaint to reflect toggles)
+            // (Labels, vom UI-Takt eingefaerbt)
         }
 
         void resized() override
         {
+            pedalLayer.invalidate();
+
             auto r = getLocalBounds().reduced(18);
 
             int knobSize = 110;
@@ -360,6 +997,19 @@ public:
             down1Button.setBounds(btnX, btnY + btnH + 10, btnW, btnH);
             down2Button.setBounds(btnX + btnW + 12, btnY + btnH + 10, btnW, btnH);
 
+            const int rowW = btnW * 2 + 12;
+            const int modeY = down2Button.getBottom() + 10;
+            modeBox.setBounds(btnX, modeY, 84, 24);
+            fftSizeBox.setBounds(modeBox.getRight() + 6, modeY, 70, 24);
+            latencyLabel.setBounds(fftSizeBox.getRight() + 6, modeY, btnX + rowW - fftSizeBox.getRight() - 6, 24);
+
+            const int harmonyY = modeY + 30;
+            const int boxW = (rowW - 3 * 6) / 4;
+            keyBox.setBounds(btnX, harmonyY, boxW, 24);
+            scaleBox.setBounds(keyBox.getRight() + 6, harmonyY, boxW, 24);
+            harmony1Box.setBounds(scaleBox.getRight() + 6, harmonyY, boxW, 24);
+            harmony2Box.setBounds(harmony1Box.getRight() + 6, harmonyY, boxW, 24);
+
             // LEDs near buttons
             ledUp2.setBounds(up2Button.getX() + up2Button.getWidth() - 18, up2Button.getY() + 6, 12, 12);
             ledUp1.setBounds(up1Button.getX() + up1Button.getWidth() - 18, up1Button.getY() + 6, 12, 12);
@@ -380,9 +1030,17 @@ public:
         }
 
     private:
-        void timerCallback() override
+        void uiTick() override
         {
-            if (!blendParameter) return;
+            // die Latenz haengt an der FFT-Groesse und wird erst im naechsten Block gemeldet
+            const int latency = processor.getLatencySamples();
+            if (latency != shownLatency)
+            {
+                shownLatency = latency;
+                latencyLabel.setText(latency > 0 ? String(latency) + " smp" : String(), dontSendNotification);
+            }
+
+            if (!blendParameter || !changeTracker.hasChanged()) return;
 
             const float pBlend = FxCommon::getDisplayValueForParameter(&processor, blendParameter);
 
@@ -408,13 +1066,30 @@ public:
                     bypassToggle.setToggleState(pBypass, dontSendNotification);
             }
 
+            auto syncChoiceBox = [](ComboBox& box, AudioParameterChoice* param)
+            {
+                if (param && box.getSelectedItemIndex() != param->getIndex())
+                    box.setSelectedItemIndex(param->getIndex(), dontSendNotification);
+            };
+
+            syncChoiceBox(modeBox, modeParameter);
+            syncChoiceBox(fftSizeBox, fftSizeParameter);
+            syncChoiceBox(keyBox, keyParameter);
+            syncChoiceBox(scaleBox, scaleParameter);
+            syncChoiceBox(harmony1Box, harmony1Parameter);
+            syncChoiceBox(harmony2Box, harmony2Parameter);
+
+            const int modeIndex = modeBox.getSelectedItemIndex();
+            fftSizeBox.setEnabled(modeIndex == 1 || modeIndex == 2);
+
+            for (auto* box : { &keyBox, &scaleBox, &harmony1Box, &harmony2Box })
+                box->setEnabled(modeIndex == 2);
+
             // update small LED components
             ledUp2.setColour(Label::backgroundColourId, up2Button.getToggleState() ? Colours::red : Colours::darkred);
             ledUp1.setColour(Label::backgroundColourId, up1Button.getToggleState() ? Colours::orange : Colours::darkred);
             ledDown1.setColour(Label::backgroundColourId, down1Button.getToggleState() ? Colours::yellow : Colours::darkred);
             ledDown2.setColour(Label::backgroundColourId, down2Button.getToggleState() ? Colours::green : Colours::darkred);
-
-            repaint();
         }
 
         void sliderValueChanged(Slider* s) override
@@ -439,6 +1114,7 @@ public:
                 down2Parameter->setValueNotifyingHost(down2Button.getToggleState() ? 1.0f : 0.0f);
             else if (b == &bypassToggle && bypassParameter)
                 bypassParameter->setValueNotifyingHost(bypassToggle.getToggleState() ? 1.0f : 0.0f);
+
         }
 
         PitchShifter& processor;
@@ -449,6 +1125,12 @@ public:
         AudioParameterBool* down1Parameter = nullptr;
         AudioParameterBool* down2Parameter = nullptr;
         AudioParameterBool* bypassParameter = nullptr;
+        AudioParameterChoice* modeParameter = nullptr;
+        AudioParameterChoice* fftSizeParameter = nullptr;
+        AudioParameterChoice* keyParameter = nullptr;
+        AudioParameterChoice* scaleParameter = nullptr;
+        AudioParameterChoice* harmony1Parameter = nullptr;
+        AudioParameterChoice* harmony2Parameter = nullptr;
 
         Slider blendSlider;
         Label blendLabel;
@@ -458,8 +1140,18 @@ public:
         TextButton down1Button;
         TextButton down2Button;
         ToggleButton bypassToggle;
+        ComboBox modeBox;
+        ComboBox fftSizeBox;
+        ComboBox keyBox;
+        ComboBox scaleBox;
+        ComboBox harmony1Box;
+        ComboBox harmony2Box;
+        Label latencyLabel;
         juce::TextButton hardwareMappingButton;
         FxCommon::HardwareMappingPopup hardwareMappingPopup;
+        FxCommon::EditorChangeTracker changeTracker { processor };
+        int shownLatency = -1;
+        FxCommon::CachedLayer pedalLayer { juce::Image::RGB };
 
         // small LED indicators implemented as Labels (background colour)
         Label ledUp2, ledUp1, ledDown1, ledDown2;
@@ -477,6 +1169,27 @@ private:
     AudioParameterBool* down1 = nullptr;
     AudioParameterBool* down2 = nullptr;
     AudioParameterBool* bypass = nullptr;
+    AudioParameterChoice* mode = nullptr;
+    AudioParameterChoice* fftSize = nullptr;
+    AudioParameterChoice* harmonyKey = nullptr;
+    AudioParameterChoice* harmonyScale = nullptr;
+    AudioParameterChoice* harmony1 = nullptr;
+    AudioParameterChoice* harmony2 = nullptr;
+
+    // studio mode (phase vocoder)
+    SpectralPitchEngine spectralEngine;
+
+    // poly mode (zero-latency octave-down filter bank)
+    PolyOctaveFilterBank octaveBank;
+
+    // harmony mode: one pitch estimate per block, shared by both harmony voices
+    PitchDetector pitchDetector;
+    std::vector<float> analysisRing, analysisFrame;  // zwei Perioden von 60 Hz
+    int analysisWritePos = 0;
+    juce::uint32 lastAnalysedFrame = 0;
+    std::array<double, 2> harmonyRatios { 0.0, 0.0 };
+    bool studioActive = false;
+    std::atomic<int> reportedLatency { 0 };
 
     // ring buffer
     std::vector<double> buffer;
@@ -517,6 +1230,138 @@ private:
 
     //==============================================================================
 
+    // --- Filtering to reduce clicks/artifacts ---
+    double filterWet(double wet)
+    {
+        // 1) gentle lowpass (anti-alias / soften transients)
+        double lpOut = lpfAlpha * wet + (1.0 - lpfAlpha) * wetLpState;
+        wetLpState = lpOut;
+
+        // 2) DC-blocking highpass to remove slow offsets after transients
+        // y[n] = hpAlpha * (y[n-1] + x[n] - x[n-1])
+        double hpOut = hpfAlpha * (wetHpState + lpOut - lastHpIn);
+        wetHpState = hpOut;
+        lastHpIn = lpOut;
+        return hpOut;
+    }
+
+    double blendAndLimit(double dry, double wet) const
+    {
+        // blend wet/dry
+        const double blendVal = static_cast<double>(*blend);
+        double out = dry * (1.0 - blendVal) + wet * blendVal;
+
+        // soft limit
+        return std::tanh(out * 5.0) * 0.999;
+    }
+
+    // Studio und Harmony laufen beide ueber die Spektral-Engine
+    bool isStudioModeSelected() const { return mode != nullptr && (mode->getIndex() == 1 || mode->getIndex() == 2); }
+    bool isHarmonyModeSelected() const { return mode != nullptr && mode->getIndex() == 2; }
+    bool isPolyModeSelected() const { return mode != nullptr && mode->getIndex() == 3; }
+    int getSelectedFftOrder() const { return SpectralPitchEngine::minOrder + (fftSize != nullptr ? fftSize->getIndex() : 1); }
+
+    static StringArray getKeyNames()
+    {
+        return { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
+    }
+
+    static StringArray getIntervalNames()
+    {
+        return { "Off", "2nd up", "3rd up", "4th up", "5th up", "6th up", "Oct up",
+                 "3rd down", "4th down", "5th down", "6th down" };
+    }
+
+    // Tonleiterschritte passend zu getIntervalNames()
+    static int getIntervalSteps(int index)
+    {
+        static const int steps[] = { 0, 1, 2, 3, 4, 5, 7, -2, -3, -4, -5 };
+        return steps[jlimit(0, numElementsInArray(steps) - 1, index)];
+    }
+
+    // Semitone offset for moving the given note 'steps' degrees along the scale.
+    // Notes outside the scale are treated as the scale note just below them.
+    static int getDiatonicOffset(int midiNote, int key, bool minor, int steps)
+    {
+        static const int major[] = { 0, 2, 4, 5, 7, 9, 11 };
+        static const int naturalMinor[] = { 0, 2, 3, 5, 7, 8, 10 };
+        const int* scale = minor ? naturalMinor : major;
+
+        const int pitchClass = ((midiNote - key) % 12 + 12) % 12;
+
+        int degree = 0;
+        for (int d = 0; d < 7; ++d)
+            if (scale[d] <= pitchClass)
+                degree = d;
+
+        const int target = degree + steps;
+        const int octave = target >= 0 ? target / 7 : (target - 6) / 7;
+        const int targetDegree = target - octave * 7;
+
+        return scale[targetDegree] + octave * 12 - scale[degree];
+    }
+
+    // Einmal pro Block: Tonhoehe aus dem Analyse-Ring schaetzen (nur wenn seit dem
+    // letzten Block ein neuer Frame der Engine analysiert wurde) und daraus
+    // beide Harmony-Verhaeltnisse ableiten. Ohne gueltige Tonhoehe bleibt das
+    // letzte Intervall stehen.
+    void updateHarmonyRatios()
+    {
+        const auto frame = spectralEngine.getFrameCount();
+
+        if (frame == lastAnalysedFrame)
+            return;
+
+        lastAnalysedFrame = frame;
+
+        // die neuesten Samples in Reihenfolge, so wie der Detektor sie erwartet
+        const int frameSize = (int) analysisFrame.size();
+        const int mask = (int) analysisRing.size() - 1;
+
+        for (int i = 0; i < frameSize; ++i)
+            analysisFrame[(size_t) i] = analysisRing[(size_t) ((analysisWritePos - frameSize + i) & mask)];
+
+        const float hz = pitchDetector.detect(analysisFrame.data(), frameSize);
+
+        if (hz <= 0.0f)
+            return;
+
+        const int note = roundToInt(PitchDetector::frequencyToMidiNote(hz));
+        const int key = harmonyKey->getIndex();
+        const bool minor = harmonyScale->getIndex() == 1;
+
+        auto ratioFor = [&](AudioParameterChoice* interval)
+        {
+            const int steps = getIntervalSteps(interval->getIndex());
+            return steps == 0 ? 0.0 : std::pow(2.0, getDiatonicOffset(note, key, minor, steps) / 12.0);
+        };
+
+        harmonyRatios = { ratioFor(harmony1), ratioFor(harmony2) };
+    }
+
+    // Mode/FFT-Groesse werden blockweise uebernommen; die neue Latenz wird
+    // asynchron auf dem Message-Thread gemeldet (setLatencySamples ruft Listener)
+    void updateStudioConfiguration()
+    {
+        const bool wantStudio = isStudioModeSelected();
+        const int wantOrder = getSelectedFftOrder();
+
+        if (wantStudio == studioActive && (! wantStudio || wantOrder == spectralEngine.getOrder()))
+            return;
+
+        if (wantStudio)
+            spectralEngine.setOrder(wantOrder);
+
+        studioActive = wantStudio;
+        reportedLatency.store(studioActive ? spectralEngine.getLatencySamples() : 0);
+        triggerAsyncUpdate();
+    }
+
+    void handleAsyncUpdate() override
+    {
+        setLatencySamples(reportedLatency.load());
+    }
+
     // Read with linear interpolation from circular buffer
     double readInterpolated(double& pos)
     {
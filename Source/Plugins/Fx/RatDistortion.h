@@ -17,7 +17,8 @@
 // ProCo Rat inspired distortion processor
 //==============================================================================
 
-class RatDistortion final : public AudioProcessor
+class RatDistortion final : public AudioProcessor,
+                            public FxCommon::TailRenderer
 {
 public:
     //==============================================================================
@@ -103,44 +104,44 @@ public:
         return static_cast<SampleType>(out);
     }
 
-    void processBlock(AudioBuffer<float>& buffer, MidiBuffer&) override
+    template<typename SampleType>
+    void processChannels(AudioBuffer<SampleType>& buffer)
     {
-        const bool isBypassed = FxCommon::applyMappedBypassFromHardware(this, bypass);
-        if (isBypassed)
-            return;
-
         const int numCh = buffer.getNumChannels();
         const int numSamples = buffer.getNumSamples();
 
         for (int ch = 0; ch < numCh; ++ch)
         {
-            float* data = buffer.getWritePointer(ch);
+            SampleType* data = buffer.getWritePointer(ch);
             for (int i = 0; i < numSamples; ++i)
             {
-                data[i] = processSampleInternal<float>(data[i], ch);
+                data[i] = processSampleInternal<SampleType>(data[i], ch);
             }
         }
     }
 
-    void processBlock(AudioBuffer<double>& buffer, MidiBuffer&) override
+    void processBlock(AudioBuffer<float>& buffer, MidiBuffer&) override
     {
         const bool isBypassed = FxCommon::applyMappedBypassFromHardware(this, bypass);
         if (isBypassed)
             return;
 
-        const int numCh = buffer.getNumChannels();
-        const int numSamples = buffer.getNumSamples();
+        processChannels(buffer);
+    }
 
-        for (int ch = 0; ch < numCh; ++ch)
-        {
-            double* data = buffer.getWritePointer(ch);
-            for (int i = 0; i < numSamples; ++i)
-            {
-                data[i] = processSampleInternal<double>(data[i], ch);
-            }
-        }
+    void processBlock(AudioBuffer<double>& buffer, MidiBuffer&) override
+    {
+        const bool isBypassed = FxCommon::applyMappedBypassFromHardware(this, bypass);
+        if (isBypassed)
+            return;
+
+        processChannels(buffer);
     }
 
+    // damit blendet der Renderer beim Bypass aus, statt hart umzuschalten
+    void processIgnoringBypass(AudioBuffer<float>& buffer) override { processChannels(buffer); }
+    void processIgnoringBypass(AudioBuffer<double>& buffer) override { processChannels(buffer); }
+
     //==============================================================================
     AudioProcessorEditor* createEditor() override { return new Editor(*this, drive, filter, volume, bypass); }
     bool hasEditor() const override { return true; }
@@ -150,6 +151,7 @@ public:
     bool acceptsMidi() const override { return false; }
     bool producesMidi() const override { return false; }
     double getTailLengthSeconds() const override { return 0; }
+    AudioProcessorParameter* getBypassParameter() const override { return bypass; }
 
     //==============================================================================
     int getNumPrograms() override { return 1; }
@@ -193,7 +195,7 @@ public:
     // Editor: GUI implementation, visually inspired by the ProCo RAT Pedal
     class Editor final : public AudioProcessorEditor,
                          private Slider::Listener,
-                         private Timer
+                         private FxCommon::UiTick::Subscriber
     {
     public:
         Editor(RatDistortion& p,
@@ -286,14 +288,14 @@ public:
             FxCommon::initialiseHardwareMappingUI(*this, hardwareMappingButton, hardwareMappingPopup, &processor);
 
             // Ensure UI reflects parameter changes
-            startTimerHz(30);
+            FxCommon::UiTick::instance().subscribe(*this, *this);
 
             setWantsKeyboardFocus(false);
         }
 
         ~Editor() override
         {
-            stopTimer();
+            FxCommon::UiTick::instance().unsubscribe(*this);
             distortionSlider.removeListener(this);
             filterSlider.removeListener(this);
             volumeSlider.removeListener(this);
@@ -301,6 +303,29 @@ public:
         }
 
         void paint(Graphics& g) override
+        {
+            // der unveraenderliche Teil kommt aus dem Bild-Cache, nur die LED wird jedes Mal gezeichnet
+            pedalLayer.draw(g, getLocalBounds(), [this](Graphics& lg) { paintPedal(lg); });
+
+            const auto footCentre = getFootCentre();
+
+            // LED indicator (red when effect is ON)
+            bool isBypassed = (bypassParameter ? static_cast<bool>(*bypassParameter) : false);
+            // LED in real RAT lights when effect is engaged; we show red when NOT bypassed
+            bool ledOn = !isBypassed;
+            float ledR = 8.0f;
+            Point<float> ledPos(footCentre.x, footCentre.y - 48.0f);
+            ledArea = FxCommon::getLedRepaintArea(ledPos, ledR);
+            if (ledOn)
+                g.setColour(Colours::red.brighter(0.0f));
+            else
+                g.setColour(Colours::darkred.darker(0.7f));
+            g.fillEllipse(ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f);
+            g.setColour(Colours::black.withAlpha(0.6f));
+            g.drawEllipse(ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f, 1.0f);
+        }
+
+        void paintPedal(Graphics& g)
         {
             // Pedal body background (black)
             auto bounds = getLocalBounds().toFloat();
@@ -333,7 +358,7 @@ public:
             g.drawFittedText("RAT", Rectangle<int>((int)ratBox.getX(), (int)ratBox.getY(), (int)ratBox.getWidth(), (int)ratBox.getHeight()), Justification::centred, 1);
 
             // Footswitch (painted metallic)
-            Point<float> footCentre(bounds.getCentreX(), bounds.getBottom() - 54.0f);
+            const auto footCentre = getFootCentre();
             float footR = 24.0f;
             Colour metal = Colour::fromRGB(200, 200, 200);
             g.setColour(metal.overlaidWith(Colours::white.withAlpha(0.15f)));
@@ -341,27 +366,20 @@ public:
             g.setColour(metal.contrasting(0.4f));
             g.drawEllipse(footCentre.x - footR, footCentre.y - footR, footR * 2.0f, footR * 2.0f, 2.0f);
 
-            // LED indicator (red when effect is ON)
-            bool isBypassed = (bypassParameter ? static_cast<bool>(*bypassParameter) : false);
-            // LED in real RAT lights when effect is engaged; we show red when NOT bypassed
-            bool ledOn = !isBypassed;
-            float ledR = 8.0f;
-            Point<float> ledPos(footCentre.x, footCentre.y - 48.0f);
-            if (ledOn)
-                g.setColour(Colours::red.brighter(0.0f));
-            else
-                g.setColour(Colours::darkred.darker(0.7f));
-            g.fillEllipse(ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f);
-            g.setColour(Colours::black.withAlpha(0.6f));
-            g.drawEllipse(ledPos.x - ledR, ledPos.y - ledR, ledR * 2.0f, ledR * 2.0f, 1.0f);
-
             // subtle border
             g.setColour(Colours::black.withAlpha(0.35f));
             g.drawRoundedRectangle(bounds.reduced(8.0f), 6.0f, 2.0f);
         }
 
+        Point<float> getFootCentre() const
+        {
+            return { getWidth() * 0.5f, getHeight() - 54.0f };
+        }
+
         void resized() override
         {
+            pedalLayer.invalidate();
+
             auto r = getLocalBounds().reduced(18);
             // top bar height
             int topBarH = 46;
@@ -396,9 +414,12 @@ public:
         }
 
     private:
-        // Timer: poll parameters and update sliders / LED
-        void timerCallback() override
+        // UI tick: poll parameters and update sliders / LED
+        void uiTick() override
         {
+            if (! changeTracker.hasChanged())
+                return;
+
             if (driveParameter && filterParameter && volumeParameter && bypassParameter)
             {
                 const float pDrive = FxCommon::getDisplayValueForParameter(&processor, driveParameter);
@@ -425,7 +446,12 @@ public:
                 if (bypassButton.getToggleState() != pBypass)
                     bypassButton.setToggleState(pBypass, dontSendNotification);
 
-                repaint();
+                // Regler und Schalter zeichnen sich selbst neu, im paint() haengt nur die LED vom Zustand ab
+                if (pBypass != ledShowsBypass)
+                {
+                    ledShowsBypass = pBypass;
+                    repaint(ledArea);
+                }
             }
         }
 
@@ -477,6 +503,10 @@ public:
         ToggleButton bypassButton;
         TextButton hardwareMappingButton;
         FxCommon::HardwareMappingPopup hardwareMappingPopup;
+        FxCommon::EditorChangeTracker changeTracker { processor };
+        Rectangle<int> ledArea;      // von paint() gesetzt
+        bool ledShowsBypass = false;
+        FxCommon::CachedLayer pedalLayer { juce::Image::RGB };
 
         // Manual inversion flags for selected knobs
         bool invertDistortion = false;
@@ -11,6 +11,8 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "FxCommon.h"
+#include "PitchDetector.h"
 #include <cmath>
 #include <memory>
 #include <vector>
@@ -20,7 +22,8 @@
 // Chromatic Tuner - Detects pitch and displays note name and cents deviation
 //==============================================================================
 
-class ChromaticTuner final : public juce::AudioProcessor
+class ChromaticTuner final : public juce::AudioProcessor,
+                             public FxCommon::TailRenderer
 {
 public:
     //==============================================================================
@@ -33,6 +36,7 @@ public:
         // Initialize autocorrelation buffer
         bufferSize = 8192;
         circularBuffer.resize(bufferSize, 0.0f);
+        linearBuffer.resize(bufferSize, 0.0f);
         writePos = 0;
         
         detectedFrequency = 0.0f;
@@ -44,6 +48,7 @@ public:
     void prepareToPlay(double sampleRateIn, int /*samplesPerBlock*/) override
     {
         sampleRate = sampleRateIn;
+        detector.prepare(sampleRate);
         circularBuffer.assign(bufferSize, 0.0f);
         writePos = 0;
         detectedFrequency = 0.0f;
@@ -82,6 +87,19 @@ public:
         detectPitch();
     }
 
+    // der Tuner hoert nur zu: auch beim Ausblenden laeuft das Signal unveraendert durch
+    void processIgnoringBypass(juce::AudioBuffer<float>& buffer) override
+    {
+        juce::MidiBuffer midi;
+        processBlock(buffer, midi);
+    }
+
+    void processIgnoringBypass(juce::AudioBuffer<double>& buffer) override
+    {
+        juce::MidiBuffer midi;
+        processBlock(buffer, midi);
+    }
+
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override { return new Editor(*this, useFlats); }
     bool hasEditor() const override { return true; }
@@ -107,62 +125,24 @@ public:
 
 private:
     //==============================================================================
-    // Pitch detection using autocorrelation (YIN-like algorithm)
+    // Pitch detection using autocorrelation (core shared with the PitchShifter harmonizer)
     void detectPitch()
     {
-        // Create a linear buffer from circular buffer
-        std::vector<float> linearBuffer(bufferSize);
+        // Create a linear buffer from circular buffer (preallocated, no allocation per block)
         for (int i = 0; i < bufferSize; ++i)
         {
             linearBuffer[i] = circularBuffer[(writePos + i) % bufferSize];
         }
         
-        // Calculate RMS to check if signal is strong enough
-        float rms = 0.0f;
-        for (int i = 0; i < bufferSize; ++i)
-            rms += linearBuffer[i] * linearBuffer[i];
-        rms = std::sqrt(rms / bufferSize);
-        
-        if (rms < 0.01f) // Signal too weak
-        {
-            detectedFrequency = 0.0f;
-            detectedNote = "";
-            detectedCents = 0.0f;
-            return;
-        }
-        
-        // Autocorrelation
-        const int minPeriod = static_cast<int>(sampleRate / 1200.0f); // ~82 Hz (E2)
-        const int maxPeriod = static_cast<int>(sampleRate / 60.0f);   // ~60 Hz (B1)
-        
-        float bestCorr = 0.0f;
-        int bestPeriod = 0;
-        
-        for (int lag = minPeriod; lag < maxPeriod && lag < bufferSize / 2; ++lag)
-        {
-            float corr = 0.0f;
-            for (int i = 0; i < bufferSize / 2; ++i)
-            {
-                corr += linearBuffer[i] * linearBuffer[i + lag];
-            }
-            
-            if (corr > bestCorr)
-            {
-                bestCorr = corr;
-                bestPeriod = lag;
-            }
-        }
-        
-        if (bestPeriod > 0)
+        detectedFrequency = detector.detect(linearBuffer.data(), bufferSize);
+
+        if (detectedFrequency > 0.0f)
         {
-            detectedFrequency = static_cast<float>(sampleRate / bestPeriod);
-            
             // Convert frequency to note name and cents
             frequencyToNote(detectedFrequency);
         }
         else
         {
-            detectedFrequency = 0.0f;
             detectedNote = "";
             detectedCents = 0.0f;
         }
@@ -179,7 +159,7 @@ private:
         
         // A4 = 440 Hz, MIDI note 69
         // Formula: n = 69 + 12 * log2(f / 440)
-        float midiNote = 69.0f + 12.0f * std::log2(frequency / 440.0f);
+        float midiNote = PitchDetector::frequencyToMidiNote(frequency);
         int nearestNote = static_cast<int>(std::round(midiNote));
         
         // Calculate cents deviation (-50 to +50)
@@ -202,7 +182,7 @@ private:
 
     //==============================================================================
     // Editor component
-    class Editor : public juce::AudioProcessorEditor, private juce::Timer
+    class Editor : public juce::AudioProcessorEditor, private FxCommon::UiTick::Subscriber
     {
     public:
         Editor(ChromaticTuner& p, juce::AudioParameterBool* useFlatsParam)
@@ -221,7 +201,12 @@ private:
                 toggleButton.setButtonText(newState ? "Sharp #" : "Flat b");
             };
             
-            startTimerHz(30); // Update display 30 times per second
+            FxCommon::UiTick::instance().subscribe(*this, *this); // Update display on the shared UI tick
+        }
+
+        ~Editor() override
+        {
+            FxCommon::UiTick::instance().unsubscribe(*this);
         }
 
         void paint(juce::Graphics& g) override
@@ -301,10 +286,20 @@ private:
             toggleButton.setBounds(getWidth() - 100, 10, 90, 25);
         }
 
-        void timerCallback() override
+        void uiTick() override
         {
-            // Update display
-            repaint();
+            // Update display, but only when something shown has changed (title and button stay)
+            const int freqTenths = juce::roundToInt(processor.getDetectedFrequency() * 10.0f);
+            const juce::String note = processor.getDetectedNote();
+            const int cents = juce::roundToInt(processor.getDetectedCents());
+
+            if (freqTenths != shownFreqTenths || cents != shownCents || note != shownNote)
+            {
+                shownFreqTenths = freqTenths;
+                shownCents = cents;
+                shownNote = note;
+                repaint(getLocalBounds().withTrimmedTop(40));
+            }
             
             // Update button text if parameter changed externally
             bool isFlats = useFlats->get();
@@ -317,6 +312,10 @@ private:
         juce::AudioParameterBool* useFlats;
         juce::TextButton toggleButton;
 
+        int shownFreqTenths = -1;
+        int shownCents = 0;
+        juce::String shownNote;
+
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Editor)
     };
 
@@ -326,6 +325,8 @@ private:
     
     // Pitch detection buffers
     std::vector<float> circularBuffer;
+    std::vector<float> linearBuffer;
+    PitchDetector detector;
     int bufferSize;
     int writePos;
     
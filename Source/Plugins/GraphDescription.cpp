@@ -0,0 +1,421 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE framework.
+   Copyright (c) Raw Material Software Limited
+
+   JUCE is an open source framework subject to commercial or open source
+   licensing.
+
+   By downloading, installing, or using the JUCE framework, or combining the
+   JUCE framework with any other source code, object code, content or any other
+   copyrightable work, you agree to the terms of the JUCE End User Licence
+   Agreement, and all incorporated terms including the JUCE Privacy Policy and
+   the JUCE Website Terms of Service, as applicable, which will bind you. If you
+   do not agree to the terms of these agreements, we will not license the JUCE
+   framework to you, and you must discontinue the installation or download
+   process and cease use of the JUCE framework.
+
+   JUCE End User Licence Agreement: https://juce.com/legal/juce-8-licence/
+   JUCE Privacy Policy: https://juce.com/juce-privacy-policy
+   JUCE Website Terms of Service: https://juce.com/juce-website-terms-of-service/
+
+   Or:
+
+   You may also use this code under the terms of the AGPLv3:
+   https://www.gnu.org/licenses/agpl-3.0.en.html
+
+   THE JUCE FRAMEWORK IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL
+   WARRANTIES, WHETHER EXPRESSED OR IMPLIED, INCLUDING WARRANTY OF
+   MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+
+#include <JuceHeader.h>
+#include "GraphDescription.h"
+
+namespace
+{
+    constexpr char magic[] = { 'P', 'F', 'X', 'G' };
+
+    const char* const nodeTag        = "NODE";
+    const char* const connectionsTag = "CONN";
+    const char* const snapshotsTag   = "SNAP";
+
+    /** Bounds-checked reads from a memory-mapped file. */
+    struct Reader
+    {
+        Reader (const void* d, size_t s)
+            : data (static_cast<const char*> (d)), size (s) {}
+
+        bool canRead (size_t numBytes) noexcept
+        {
+            if (failed || size - position < numBytes)
+                failed = true;
+
+            return ! failed;
+        }
+
+        const char* readBlock (size_t numBytes) noexcept
+        {
+            if (! canRead (numBytes))
+                return nullptr;
+
+            auto* block = data + position;
+            position += numBytes;
+            return block;
+        }
+
+        uint32 readUInt32() noexcept
+        {
+            auto* block = readBlock (4);
+            return block != nullptr ? ByteOrder::littleEndianInt (block) : 0;
+        }
+
+        uint8 readByte() noexcept
+        {
+            auto* block = readBlock (1);
+            return block != nullptr ? (uint8) *block : 0;
+        }
+
+        String readString()
+        {
+            const auto numBytes = readUInt32();
+            auto* block = readBlock (numBytes);
+            return block != nullptr ? String::fromUTF8 (block, (int) numBytes) : String();
+        }
+
+        var readVar()
+        {
+            if (! canRead (1))
+                return {};
+
+            MemoryInputStream in (data + position, size - position, false);
+            auto v = var::readFromStream (in);
+            position += (size_t) in.getPosition();
+            return v;
+        }
+
+        const char* data;
+        size_t size, position = 0;
+        bool failed = false;
+    };
+
+    void writeString (OutputStream& out, const String& s)
+    {
+        const auto numBytes = s.getNumBytesAsUTF8();
+        out.writeInt ((int) numBytes);
+        out.write (s.toRawUTF8(), numBytes);
+    }
+
+    String toSingleLine (const XmlElement& xml)
+    {
+        return xml.toString (XmlElement::TextFormat().singleLine().withoutHeader());
+    }
+
+    /** Calls the function with each section's tag and payload, until it returns false. */
+    template <typename Fn>
+    bool forEachSection (const void* data, size_t size, Fn&& fn)
+    {
+        Reader reader (data, size);
+
+        auto* header = reader.readBlock (sizeof (magic));
+
+        if (header == nullptr || std::memcmp (header, magic, sizeof (magic)) != 0)
+            return false;
+
+        if (reader.readUInt32() > GraphDescription::currentVersion)
+            return false;
+
+        while (reader.position < reader.size)
+        {
+            auto* tag = reader.readBlock (4);
+            const auto sectionSize = reader.readUInt32();
+            auto* payload = reader.readBlock (sectionSize);
+
+            if (tag == nullptr || payload == nullptr)
+                return false;
+
+            if (! fn (String (tag, 4), Reader (payload, sectionSize)))
+                break;
+        }
+
+        return ! reader.failed;
+    }
+}
+
+//==============================================================================
+std::unique_ptr<GraphDescription> GraphDescription::fromXml (const XmlElement& xml)
+{
+    auto result = std::make_unique<GraphDescription>();
+
+    for (auto* e : xml.getChildWithTagNameIterator ("FILTER"))
+    {
+        Node node;
+        node.uid = (uint32) e->getIntAttribute ("uid");
+        node.useARA = e->getBoolAttribute ("useARA");
+
+        for (int i = 0; i < e->getNumAttributes(); ++i)
+        {
+            const auto name = e->getAttributeName (i);
+
+            if (name == "uid" || name == "useARA")
+                continue;
+
+            if (name == "x" || name == "y")
+                node.properties.set (name, e->getDoubleAttribute (name));
+            else
+                node.properties.set (name, e->getIntAttribute (name));
+        }
+
+        for (auto* child : e->getChildIterator())
+            if (node.description.loadFromXml (*child))
+                break;
+
+        if (auto* state = e->getChildByName ("STATE"))
+            node.ownedState.fromBase64Encoding (state->getAllSubText());
+
+        if (auto* layout = e->getChildByName ("LAYOUT"))
+            node.layout = std::make_unique<XmlElement> (*layout);
+
+        result->nodes.push_back (std::move (node));
+    }
+
+    for (auto* e : xml.getChildWithTagNameIterator ("CONNECTION"))
+    {
+        result->connections.push_back ({ (uint32) e->getIntAttribute ("srcFilter"), e->getIntAttribute ("srcChannel"),
+                                         (uint32) e->getIntAttribute ("dstFilter"), e->getIntAttribute ("dstChannel") });
+    }
+
+    if (auto* snapshots = xml.getChildByName ("SNAPSHOTS"))
+        result->snapshots = std::make_unique<XmlElement> (*snapshots);
+
+    return result;
+}
+
+std::unique_ptr<XmlElement> GraphDescription::toXml() const
+{
+    auto xml = std::make_unique<XmlElement> ("FILTERGRAPH");
+
+    for (const auto& node : nodes)
+    {
+        auto* e = xml->createNewChildElement ("FILTER");
+
+        e->setAttribute ("uid", (int) node.uid);
+
+        for (const auto& property : node.properties)
+            e->setAttribute (property.name, property.value.toString());
+
+        e->setAttribute ("useARA", node.useARA ? "1" : "0");
+
+        e->addChildElement (node.description.createXml().release());
+
+        MemoryBlock state (node.getStateData(), node.getStateSize());
+        e->createNewChildElement ("STATE")->addTextElement (state.toBase64Encoding());
+
+        if (node.layout != nullptr)
+            e->addChildElement (new XmlElement (*node.layout));
+    }
+
+    for (const auto& connection : connections)
+    {
+        auto e = xml->createNewChildElement ("CONNECTION");
+
+        e->setAttribute ("srcFilter", (int) connection.sourceNode);
+        e->setAttribute ("srcChannel", connection.sourceChannel);
+        e->setAttribute ("dstFilter", (int) connection.destNode);
+        e->setAttribute ("dstChannel", connection.destChannel);
+    }
+
+    if (snapshots != nullptr)
+        xml->addChildElement (new XmlElement (*snapshots));
+
+    return xml;
+}
+
+//==============================================================================
+bool GraphDescription::isBinaryFile (const File& file)
+{
+    FileInputStream in (file);
+    char header[sizeof (magic)] {};
+
+    return in.openedOk()
+        && in.read (header, (int) sizeof (header)) == (int) sizeof (header)
+        && std::memcmp (header, magic, sizeof (magic)) == 0;
+}
+
+std::unique_ptr<GraphDescription> GraphDescription::loadBinary (const File& file)
+{
+    auto mapped = std::make_unique<MemoryMappedFile> (file, MemoryMappedFile::readOnly);
+
+    if (mapped->getData() == nullptr)
+        return nullptr;
+
+    auto result = readBinary (mapped->getData(), mapped->getSize());
+
+    if (result != nullptr)
+        result->mappedFile = std::move (mapped);
+
+    return result;
+}
+
+std::unique_ptr<GraphDescription> GraphDescription::readBinary (const void* data, size_t size)
+{
+    auto result = std::make_unique<GraphDescription>();
+    bool corrupt = false;
+
+    const auto ok = forEachSection (data, size, [&] (const String& tag, Reader reader)
+    {
+        if (tag == nodeTag)
+        {
+            Node node;
+            node.uid = reader.readUInt32();
+            node.useARA = (reader.readByte() & 1) != 0;
+            reader.readString();    // the name, for previews
+
+            if (auto description = parseXML (reader.readString()))
+                node.description.loadFromXml (*description);
+
+            if (const auto layout = reader.readString(); layout.isNotEmpty())
+                node.layout = parseXML (layout);
+
+            for (auto numProperties = reader.readUInt32(); numProperties > 0 && ! reader.failed; --numProperties)
+            {
+                const auto name = reader.readString();
+                node.properties.set (name, reader.readVar());
+            }
+
+            node.mappedStateSize = reader.readUInt32();
+            node.mappedState = reader.readBlock (node.mappedStateSize);
+
+            if (reader.failed)
+            {
+                corrupt = true;
+                return false;
+            }
+
+            result->nodes.push_back (std::move (node));
+        }
+        else if (tag == connectionsTag)
+        {
+            for (auto numConnections = reader.readUInt32(); numConnections > 0 && ! reader.failed; --numConnections)
+            {
+                Connection c;
+                c.sourceNode    = reader.readUInt32();
+                c.sourceChannel = (int) reader.readUInt32();
+                c.destNode      = reader.readUInt32();
+                c.destChannel   = (int) reader.readUInt32();
+
+                if (! reader.failed)
+                    result->connections.push_back (c);
+            }
+        }
+        else if (tag == snapshotsTag)
+        {
+            result->snapshots = parseXML (reader.readString());
+        }
+
+        return true;
+    });
+
+    if (! ok || corrupt)
+        return nullptr;
+
+    return result;
+}
+
+void GraphDescription::writeBinary (OutputStream& out) const
+{
+    auto writeSection = [&] (const char* tag, const MemoryBlock& payload, const void* extra = nullptr, size_t extraSize = 0)
+    {
+        out.write (tag, 4);
+        out.writeInt ((int) (payload.getSize() + extraSize));
+        out.write (payload.getData(), payload.getSize());
+
+        if (extraSize > 0)
+            out.write (extra, extraSize);
+    };
+
+    out.write (magic, sizeof (magic));
+    out.writeInt ((int) currentVersion);
+
+    for (const auto& node : nodes)
+    {
+        MemoryBlock header;
+
+        {
+            MemoryOutputStream s (header, false);
+            s.writeInt ((int) node.uid);
+            s.writeByte (node.useARA ? 1 : 0);
+            writeString (s, node.description.name);
+            writeString (s, toSingleLine (*node.description.createXml()));
+            writeString (s, node.layout != nullptr ? toSingleLine (*node.layout) : String());
+            s.writeInt (node.properties.size());
+
+            for (const auto& property : node.properties)
+            {
+                writeString (s, property.name.toString());
+                property.value.writeToStream (s);
+            }
+
+            s.writeInt ((int) node.getStateSize());
+        }
+
+        // the state follows the header as a raw blob
+        writeSection (nodeTag, header, node.getStateData(), node.getStateSize());
+    }
+
+    {
+        MemoryBlock payload;
+        MemoryOutputStream s (payload, false);
+        s.writeInt ((int) connections.size());
+
+        for (const auto& c : connections)
+        {
+            s.writeInt ((int) c.sourceNode);
+            s.writeInt (c.sourceChannel);
+            s.writeInt ((int) c.destNode);
+            s.writeInt (c.destChannel);
+        }
+
+        s.flush();  // trims the block to what was written
+        writeSection (connectionsTag, payload);
+    }
+
+    if (snapshots != nullptr)
+    {
+        MemoryBlock payload;
+
+        {
+            MemoryOutputStream s (payload, false);
+            writeString (s, toSingleLine (*snapshots));
+        }
+
+        writeSection (snapshotsTag, payload);
+    }
+}
+
+Result GraphDescription::saveBinary (const File& file) const
+{
+    TemporaryFile temp (file);
+
+    {
+        FileOutputStream out (temp.getFile());
+
+        if (! out.openedOk())
+            return Result::fail ("Couldn't write to the file");
+
+        writeBinary (out);
+        out.flush();
+
+        if (out.getStatus().failed())
+            return out.getStatus();
+    }
+
+    if (! temp.overwriteTargetFileWithTemporary())
+        return Result::fail ("Couldn't write to the file");
+
+    return Result::ok();
+}
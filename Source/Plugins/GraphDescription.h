@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE framework.
+   Copyright (c) Raw Material Software Limited
+
+   JUCE is an open source framework subject to commercial or open source
+   licensing.
+
+   By downloading, installing, or using the JUCE framework, or combining the
+   JUCE framework with any other source code, object code, content or any other
+   copyrightable work, you agree to the terms of the JUCE End User Licence
+   Agreement, and all incorporated terms including the JUCE Privacy Policy and
+   the JUCE Website Terms of Service, as applicable, which will bind you. If you
+   do not agree to the terms of these agreements, we will not license the JUCE
+   framework to you, and you must discontinue the installation or download
+   process and cease use of the JUCE framework.
+
+   JUCE End User Licence Agreement: https://juce.com/legal/juce-8-licence/
+   JUCE Privacy Policy: https://juce.com/juce-privacy-policy
+   JUCE Website Terms of Service: https://juce.com/juce-website-terms-of-service/
+
+   Or:
+
+   You may also use this code under the terms of the AGPLv3:
+   https://www.gnu.org/licenses/agpl-3.0.en.html
+
+   THE JUCE FRAMEWORK IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL
+   WARRANTIES, WHETHER EXPRESSED OR IMPLIED, INCLUDING WARRANTY OF
+   MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+
+#pragma once
+
+//==============================================================================
+/**
+    The contents of a graph document, independent of the file format.
+
+    .filtergraph files are written in a versioned binary format:
+
+        "PFXG", uint32 version, then sections of { char[4] tag, uint32 size, payload }
+
+    with little-endian integers, one "NODE" section per node, one "CONN" section
+    for the connections and an optional "SNAP" section for the snapshots. Readers
+    skip sections they don't know. Node states are stored as raw blobs. Binary
+    files are memory-mapped, and a state is passed to setStateInformation()
+    straight from the mapping.
+
+    The older XML documents, with their base64-encoded states, can still be
+    read, and are written when exporting.
+*/
+class GraphDescription
+{
+public:
+    //==============================================================================
+    struct Node
+    {
+        uint32 uid = 0;
+        PluginDescription description;
+        bool useARA = false;
+
+        /** "x", "y" and the plug-in window properties. */
+        NamedValueSet properties;
+
+        /** The LAYOUT element holding the bus layouts, or nullptr. */
+        std::unique_ptr<XmlElement> layout;
+
+        /** The plug-in state, either in the mapped file or in ownedState. */
+        const void* getStateData() const noexcept   { return mappedState != nullptr ? mappedState : ownedState.getData(); }
+        size_t getStateSize() const noexcept        { return mappedState != nullptr ? mappedStateSize : ownedState.getSize(); }
+
+        MemoryBlock ownedState;
+        const void* mappedState = nullptr;
+        size_t mappedStateSize = 0;
+    };
+
+    struct Connection
+    {
+        uint32 sourceNode = 0;
+        int sourceChannel = 0;
+        uint32 destNode = 0;
+        int destChannel = 0;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Connection> connections;
+
+    /** The snapshot bank's SNAPSHOTS element, or nullptr. */
+    std::unique_ptr<XmlElement> snapshots;
+
+    //==============================================================================
+    static std::unique_ptr<GraphDescription> fromXml (const XmlElement&);
+    std::unique_ptr<XmlElement> toXml() const;
+
+    //==============================================================================
+    static constexpr uint32 currentVersion = 1;
+
+    static bool isBinaryFile (const File&);
+
+    /** Maps the file and reads it; the states stay in the mapping. Returns nullptr on failure. */
+    static std::unique_ptr<GraphDescription> loadBinary (const File&);
+
+    /** Reads the binary format from memory. The states point into the data, which
+        must outlive the description. Returns nullptr on failure.
+    */
+    static std::unique_ptr<GraphDescription> readBinary (const void* data, size_t size);
+
+    void writeBinary (OutputStream&) const;
+
+    /** Writes the binary format through a temporary file, replacing the target at the end. */
+    Result saveBinary (const File&) const;
+
+private:
+    std::unique_ptr<MemoryMappedFile> mappedFile;
+};
@@ -0,0 +1,556 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE framework.
+   Copyright (c) Raw Material Software Limited
+
+   JUCE is an open source framework subject to commercial or open source
+   licensing.
+
+   By downloading, installing, or using the JUCE framework, or combining the
+   JUCE framework with any other source code, object code, content or any other
+   copyrightable work, you agree to the terms of the JUCE End User Licence
+   Agreement, and all incorporated terms including the JUCE Privacy Policy and
+   the JUCE Website Terms of Service, as applicable, which will bind you. If you
+   do not agree to the terms of these agreements, we will not license the JUCE
+   framework to you, and you must discontinue the installation or download
+   process and cease use of the JUCE framework.
+
+   JUCE End User Licence Agreement: https://juce.com/legal/juce-8-licence/
+   JUCE Privacy Policy: https://juce.com/juce-privacy-policy
+   JUCE Website Terms of Service: https://juce.com/juce-website-terms-of-service/
+
+   Or:
+
+   You may also use this code under the terms of the AGPLv3:
+   https://www.gnu.org/licenses/agpl-3.0.en.html
+
+   THE JUCE FRAMEWORK IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL
+   WARRANTIES, WHETHER EXPRESSED OR IMPLIED, INCLUDING WARRANTY OF
+   MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+
+#include <JuceHeader.h>
+#include "GraphJournal.h"
+#include "PluginGraph.h"
+#include "InternalPlugins.h"
+#include "../UI/MainHostWindow.h"
+
+#if JUCE_LINUX || JUCE_BSD || JUCE_MAC
+ #include <cerrno>
+ #include <fcntl.h>
+ #include <unistd.h>
+ #define PFX_JOURNAL_USE_POSIX 1
+#else
+ #define PFX_JOURNAL_USE_POSIX 0
+#endif
+
+namespace
+{
+    constexpr int pollIntervalMs        = 100;
+    constexpr int batchIntervalMs       = 250;
+    constexpr size_t compactAfterBytes  = 64 * 1024;
+    constexpr uint32 compactAfterMs     = 30 * 1000;
+
+    // size, type and checksum around every payload
+    constexpr size_t frameOverhead = 4 + 1 + 4;
+
+    uint32 checksum (const void* data, size_t size) noexcept
+    {
+        // FNV-1a
+        auto* bytes = static_cast<const uint8*> (data);
+        uint32 hash = 2166136261u;
+
+        for (size_t i = 0; i < size; ++i)
+            hash = (hash ^ bytes[i]) * 16777619u;
+
+        return hash;
+    }
+
+    //==============================================================================
+    /** An append-only file that can be synced to the disk. */
+    class AppendFile
+    {
+    public:
+        AppendFile (const File& f, bool truncate)
+        {
+           #if PFX_JOURNAL_USE_POSIX
+            fd = ::open (f.getFullPathName().toRawUTF8(),
+                         O_WRONLY | O_CREAT | O_APPEND | (truncate ? O_TRUNC : 0), 0644);
+           #else
+            if (truncate)
+                f.deleteFile();
+
+            stream = std::make_unique<FileOutputStream> (f);
+
+            if (! stream->openedOk())
+                stream.reset();
+           #endif
+        }
+
+        ~AppendFile()
+        {
+           #if PFX_JOURNAL_USE_POSIX
+            if (fd >= 0)
+                ::close (fd);
+           #endif
+        }
+
+        bool isOpen() const noexcept
+        {
+           #if PFX_JOURNAL_USE_POSIX
+            return fd >= 0;
+           #else
+            return stream != nullptr;
+           #endif
+        }
+
+        bool append (const void* data, size_t size)
+        {
+           #if PFX_JOURNAL_USE_POSIX
+            auto* bytes = static_cast<const char*> (data);
+
+            while (size > 0)
+            {
+                const auto written = ::write (fd, bytes, size);
+
+                if (written < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+
+                    return false;
+                }
+
+                bytes += written;
+                size -= (size_t) written;
+            }
+
+            return true;
+           #else
+            return stream->write (data, size);
+           #endif
+        }
+
+        void sync()
+        {
+           #if PFX_JOURNAL_USE_POSIX
+            ::fsync (fd);
+           #else
+            stream->flush();
+           #endif
+        }
+
+    private:
+       #if PFX_JOURNAL_USE_POSIX
+        int fd = -1;
+       #else
+        std::unique_ptr<FileOutputStream> stream;
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE (AppendFile)
+    };
+
+    /** Replaces the target with the source in one step where the OS allows it. */
+    bool replaceFile (const File& source, const File& target)
+    {
+       #if PFX_JOURNAL_USE_POSIX
+        if (::rename (source.getFullPathName().toRawUTF8(), target.getFullPathName().toRawUTF8()) != 0)
+            return false;
+
+        // make the rename itself durable
+        const auto dir = ::open (target.getParentDirectory().getFullPathName().toRawUTF8(), O_RDONLY);
+
+        if (dir >= 0)
+        {
+            ::fsync (dir);
+            ::close (dir);
+        }
+
+        return true;
+       #else
+        return source.replaceFileIn (target);
+       #endif
+    }
+
+    AudioProcessorGraph::Node* findNode (AudioProcessorGraph& graph, uint32 uid)
+    {
+        return graph.getNodeForId (AudioProcessorGraph::NodeID (uid));
+    }
+}
+
+//==============================================================================
+GraphJournal::GraphJournal (PluginGraph& g, const File& f)
+    : Thread ("Autosave journal"),
+      owner (g),
+      file (f)
+{
+    file.getParentDirectory().createDirectory();
+
+    writeDocument();
+    startThread (Thread::Priority::background);
+    startTimer (pollIntervalMs);
+}
+
+GraphJournal::~GraphJournal()
+{
+    stopTimer();
+    signalThreadShouldExit();
+    queueEvent.signal();
+    stopThread (10000);
+}
+
+File GraphJournal::getDefaultFile()
+{
+    if (auto* settings = getAppProperties().getUserSettings())
+        return settings->getFile().getSiblingFile ("autosave.journal");
+
+    return File::getSpecialLocation (File::userApplicationDataDirectory).getChildFile ("autosave.journal");
+}
+
+void GraphJournal::discard()
+{
+    stopTimer();
+    signalThreadShouldExit();
+    queueEvent.signal();
+    stopThread (10000);
+
+    file.deleteFile();
+}
+
+//==============================================================================
+size_t GraphJournal::computeTopologyHash() const
+{
+    size_t hash = 0;
+
+    auto combine = [&hash] (size_t v)
+    {
+        hash ^= v + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    };
+
+    for (auto* node : owner.graph.getNodes())
+    {
+        // the node objects change when a preset replaces them with the same IDs
+        combine (std::hash<const void*>() (node));
+        combine (node->nodeID.uid);
+    }
+
+    for (auto& c : owner.graph.getConnections())
+    {
+        combine (c.source.nodeID.uid);
+        combine ((size_t) c.source.channelIndex);
+        combine (c.destination.nodeID.uid);
+        combine ((size_t) c.destination.channelIndex);
+    }
+
+    return hash;
+}
+
+void GraphJournal::writeDocument()
+{
+    topologyHash = computeTopologyHash();
+    slots.clear();
+    positions.clear();
+
+    for (auto* node : owner.graph.getNodes())
+    {
+        AudioProcessorGraph::Node::Ptr ptr (node);
+        slots.push_back ({ ptr, nullptr, -1, node->isBypassed() ? 1.0f : 0.0f });
+
+        if (auto* processor = node->getProcessor())
+        {
+            const auto& parameters = InternalPluginFormat::getProcessorWithParameters (*processor).getParameters();
+
+            for (int i = 0; i < parameters.size(); ++i)
+                slots.push_back ({ ptr, parameters[i], i, parameters[i]->getValue() });
+        }
+
+        positions.push_back ({ ptr, (double) node->properties["x"], (double) node->properties["y"] });
+    }
+
+    MemoryBlock payload;
+
+    {
+        MemoryOutputStream out (payload, false);
+        const auto path = owner.getFile().getFullPathName();
+
+        out.writeInt ((int) path.getNumBytesAsUTF8());
+        out.write (path.toRawUTF8(), path.getNumBytesAsUTF8());
+        owner.createDescription()->writeBinary (out);
+    }
+
+    push (RecordType::document, payload);
+
+    bytesSinceDocument = 0;
+    lastDocumentTime = Time::getMillisecondCounter();
+    hasDeltas = false;
+}
+
+void GraphJournal::collectDeltas()
+{
+    for (auto& slot : slots)
+    {
+        const auto value = slot.parameter != nullptr ? slot.parameter->getValue()
+                                                     : (slot.node->isBypassed() ? 1.0f : 0.0f);
+
+        if (value == slot.lastValue)
+            continue;
+
+        slot.lastValue = value;
+
+        MemoryBlock payload;
+
+        {
+            MemoryOutputStream out (payload, false);
+            out.writeInt ((int) slot.node->nodeID.uid);
+            out.writeInt (slot.parameterIndex);
+            out.writeFloat (value);
+        }
+
+        push (RecordType::parameter, payload);
+    }
+
+    for (auto& p : positions)
+    {
+        const auto x = (double) p.node->properties["x"];
+        const auto y = (double) p.node->properties["y"];
+
+        if (x == p.x && y == p.y)
+            continue;
+
+        p.x = x;
+        p.y = y;
+
+        MemoryBlock payload;
+
+        {
+            MemoryOutputStream out (payload, false);
+            out.writeInt ((int) p.node->nodeID.uid);
+            out.writeDouble (x);
+            out.writeDouble (y);
+        }
+
+        push (RecordType::position, payload);
+    }
+}
+
+void GraphJournal::push (RecordType type, const MemoryBlock& payload)
+{
+    auto data = frame (type, payload);
+
+    if (type != RecordType::document)
+    {
+        bytesSinceDocument += data.getSize();
+        hasDeltas = true;
+    }
+
+    const ScopedLock sl (queueLock);
+
+    // a document supersedes everything that hasn't been written yet
+    if (type == RecordType::document)
+        queue.clear();
+
+    queue.push_back ({ type, std::move (data) });
+}
+
+MemoryBlock GraphJournal::frame (RecordType type, const MemoryBlock& payload)
+{
+    MemoryBlock data (payload.getSize() + frameOverhead);
+    auto* bytes = static_cast<char*> (data.getData());
+
+    ByteOrder::writeLittleEndianInt ((uint32) payload.getSize(), bytes);
+    bytes[4] = (char) type;
+    data.copyFrom (payload.getData(), 5, payload.getSize());
+    ByteOrder::writeLittleEndianInt (checksum (bytes + 4, payload.getSize() + 1), bytes + 5 + payload.getSize());
+
+    return data;
+}
+
+void GraphJournal::timerCallback()
+{
+    if (computeTopologyHash() != topologyHash)
+    {
+        writeDocument();
+        return;
+    }
+
+    collectDeltas();
+
+    if (hasDeltas && (bytesSinceDocument > compactAfterBytes
+                       || Time::getMillisecondCounter() - lastDocumentTime > compactAfterMs))
+    {
+        writeDocument();
+    }
+}
+
+//==============================================================================
+void GraphJournal::run()
+{
+    std::unique_ptr<AppendFile> out;
+    std::vector<Record> batch;
+
+    for (;;)
+    {
+        const auto exiting = threadShouldExit();
+
+        if (! exiting)
+            queueEvent.wait (batchIntervalMs);
+
+        {
+            const ScopedLock sl (queueLock);
+            batch.swap (queue);
+        }
+
+        for (auto it = batch.begin(); it != batch.end();)
+        {
+            if (it->type == RecordType::document)
+            {
+                // compaction: the new file holds the document and the deltas that follow it
+                out.reset();
+
+                const auto temp = file.getSiblingFile (file.getFileName() + ".new");
+                auto newFile = std::make_unique<AppendFile> (temp, true);
+
+                if (newFile->isOpen() && newFile->append (it->data.getData(), it->data.getSize()))
+                {
+                    newFile->sync();
+                    newFile.reset();
+
+                    if (replaceFile (temp, file))
+                        out = std::make_unique<AppendFile> (file, false);
+                }
+
+                ++it;
+                continue;
+            }
+
+            // append all deltas up to the next document in one go
+            MemoryBlock deltas;
+
+            for (; it != batch.end() && it->type != RecordType::document; ++it)
+                deltas.append (it->data.getData(), it->data.getSize());
+
+            if (out != nullptr && out->isOpen() && out->append (deltas.getData(), deltas.getSize()))
+                out->sync();
+        }
+
+        batch.clear();
+
+        if (exiting)
+            return;
+    }
+}
+
+//==============================================================================
+bool GraphJournal::replay (PluginGraph& graph, const File& journalFile)
+{
+    MemoryMappedFile mapped (journalFile, MemoryMappedFile::readOnly);
+
+    if (mapped.getData() == nullptr)
+        return false;
+
+    struct Entry
+    {
+        RecordType type;
+        const char* payload;
+        size_t size;
+    };
+
+    std::vector<Entry> entries;
+    auto* data = static_cast<const char*> (mapped.getData());
+    const auto size = mapped.getSize();
+    size_t position = 0;
+
+    // everything after the first damaged record is dropped
+    while (size - position >= frameOverhead)
+    {
+        const auto payloadSize = (size_t) ByteOrder::littleEndianInt (data + position);
+
+        if (size - position - frameOverhead < payloadSize)
+            break;
+
+        auto* typeAndPayload = data + position + 4;
+
+        if (checksum (typeAndPayload, payloadSize + 1) != ByteOrder::littleEndianInt (typeAndPayload + 1 + payloadSize))
+            break;
+
+        const auto type = (RecordType) (uint8) *typeAndPayload;
+
+        // only the last document matters
+        if (type == RecordType::document)
+            entries.clear();
+
+        entries.push_back ({ type, typeAndPayload + 1, payloadSize });
+        position += payloadSize + frameOverhead;
+    }
+
+    if (entries.empty() || entries.front().type != RecordType::document)
+        return false;
+
+    const auto& document = entries.front();
+
+    if (document.size < 4)
+        return false;
+
+    const auto pathSize = (size_t) ByteOrder::littleEndianInt (document.payload);
+
+    if (document.size - 4 < pathSize)
+        return false;
+
+    auto description = GraphDescription::readBinary (document.payload + 4 + pathSize, document.size - 4 - pathSize);
+
+    if (description == nullptr)
+        return false;
+
+    graph.restore (*description);
+
+    for (size_t i = 1; i < entries.size(); ++i)
+    {
+        const auto& e = entries[i];
+
+        if (e.type == RecordType::parameter && e.size == 12)
+        {
+            MemoryInputStream in (e.payload, e.size, false);
+            const auto uid = (uint32) in.readInt();
+            const auto index = in.readInt();
+            const auto value = in.readFloat();
+
+            if (auto* node = findNode (graph.graph, uid))
+            {
+                if (index < 0)
+                {
+                    node->setBypassed (value != 0.0f);
+                }
+                else if (auto* processor = node->getProcessor())
+                {
+                    const auto& parameters = InternalPluginFormat::getProcessorWithParameters (*processor).getParameters();
+
+                    if (auto* parameter = parameters[index])
+                        parameter->setValueNotifyingHost (value);
+                }
+            }
+        }
+        else if (e.type == RecordType::position && e.size == 20)
+        {
+            MemoryInputStream in (e.payload, e.size, false);
+            const auto uid = (uint32) in.readInt();
+            const auto x = in.readDouble();
+            const auto y = in.readDouble();
+
+            if (auto* node = findNode (graph.graph, uid))
+            {
+                node->properties.set ("x", x);
+                node->properties.set ("y", y);
+            }
+        }
+    }
+
+    // the recovered session still has to be saved by the user
+    graph.setFile (File (String::fromUTF8 (document.payload + 4, (int) pathSize)));
+    graph.setChangedFlag (true);
+
+    return true;
+}
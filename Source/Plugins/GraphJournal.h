@@ -0,0 +1,140 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE framework.
+   Copyright (c) Raw Material Software Limited
+
+   JUCE is an open source framework subject to commercial or open source
+   licensing.
+
+   By downloading, installing, or using the JUCE framework, or combining the
+   JUCE framework with any other source code, object code, content or any other
+   copyrightable work, you agree to the terms of the JUCE End User Licence
+   Agreement, and all incorporated terms including the JUCE Privacy Policy and
+   the JUCE Website Terms of Service, as applicable, which will bind you. If you
+   do not agree to the terms of these agreements, we will not license the JUCE
+   framework to you, and you must discontinue the installation or download
+   process and cease use of the JUCE framework.
+
+   JUCE End User Licence Agreement: https://juce.com/legal/juce-8-licence/
+   JUCE Privacy Policy: https://juce.com/juce-privacy-policy
+   JUCE Website Terms of Service: https://juce.com/juce-website-terms-of-service/
+
+   Or:
+
+   You may also use this code under the terms of the AGPLv3:
+   https://www.gnu.org/licenses/agpl-3.0.en.html
+
+   THE JUCE FRAMEWORK IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL
+   WARRANTIES, WHETHER EXPRESSED OR IMPLIED, INCLUDING WARRANTY OF
+   MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+
+#pragma once
+
+class PluginGraph;
+
+//==============================================================================
+/**
+    A crash-safe autosave of the graph document, as an append-only journal.
+
+    A message-thread timer watches the graph. When the nodes or connections
+    change, a full document record is written; after that, only the parameter,
+    bypass and position changes are appended as small delta records. Every
+    document record starts a new journal file, so this also compacts the
+    journal. A new document is written after a while, or when the deltas have
+    grown, so that non-parameter state gets saved too.
+
+    The records are written by a background thread. Each batch is appended
+    and then synced with a single fsync. A new journal file is written next
+    to the old one, synced, and renamed over it. Every record carries a
+    checksum, so a record that was cut short by a power cut is ignored on
+    replay.
+
+    The audio thread never touches the journal: parameter values are polled,
+    not listened to, because they may be set from the audio thread.
+*/
+class GraphJournal final : private Timer,
+                           private Thread
+{
+public:
+    //==============================================================================
+    /** Starts journaling the graph to the file, replacing what is in it. */
+    GraphJournal (PluginGraph&, const File& journalFile);
+
+    /** Writes out what is still queued. The file is kept. */
+    ~GraphJournal() override;
+
+    /** Where the journal is kept unless told otherwise, next to the settings file. */
+    static File getDefaultFile();
+
+    /** Restores the graph from a journal that was left behind, i.e. the last
+        session didn't shut down cleanly. Returns false if there was nothing to
+        restore. Message thread only.
+    */
+    static bool replay (PluginGraph&, const File& journalFile);
+
+    /** Stops journaling and deletes the file, for a clean shutdown. */
+    void discard();
+
+private:
+    //==============================================================================
+    enum class RecordType : uint8
+    {
+        document  = 'D',
+        parameter = 'P',
+        position  = 'M'
+    };
+
+    struct Record
+    {
+        RecordType type;
+        MemoryBlock data;   // already framed
+    };
+
+    struct Slot
+    {
+        AudioProcessorGraph::Node::Ptr node;
+        AudioProcessorParameter* parameter = nullptr;
+        int parameterIndex = -1;   // -1 for the bypass state
+        float lastValue = 0.0f;
+    };
+
+    struct Position
+    {
+        AudioProcessorGraph::Node::Ptr node;
+        double x = 0.0, y = 0.0;
+    };
+
+    //==============================================================================
+    PluginGraph& owner;
+    const File file;
+
+    std::vector<Slot> slots;
+    std::vector<Position> positions;
+    size_t topologyHash = 0;
+    size_t bytesSinceDocument = 0;
+    uint32 lastDocumentTime = 0;
+    bool hasDeltas = false;
+
+    CriticalSection queueLock;
+    std::vector<Record> queue;
+    WaitableEvent queueEvent;
+
+    //==============================================================================
+    size_t computeTopologyHash() const;
+    void writeDocument();
+    void collectDeltas();
+    void push (RecordType, const MemoryBlock& payload);
+
+    static MemoryBlock frame (RecordType, const MemoryBlock& payload);
+
+    void timerCallback() override;
+    void run() override;
+    void writeBatch (std::vector<Record>&);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GraphJournal)
+};
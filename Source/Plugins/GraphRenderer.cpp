@@ -0,0 +1,1879 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE framework.
+   Copyright (c) Raw Material Software Limited
+
+   JUCE is an open source framework subject to commercial or open source
+   licensing.
+
+   By downloading, installing, or using the JUCE framework, or combining the
+   JUCE framework with any other source code, object code, content or any other
+   copyrightable work, you agree to the terms of the JUCE End User Licence
+   Agreement, and all incorporated terms including the JUCE Privacy Policy and
+   the JUCE Website Terms of Service, as applicable, which will bind you. If you
+   do not agree to the terms of these agreements, we will not license the JUCE
+   framework to you, and you must discontinue the installation or download
+   process and cease use of the JUCE framework.
+
+   JUCE End User Licence Agreement: https://juce.com/legal/juce-8-licence/
+   JUCE Privacy Policy: https://juce.com/juce-privacy-policy
+   JUCE Website Terms of Service: https://juce.com/juce-website-terms-of-service/
+
+   Or:
+
+   You may also use this code under the terms of the AGPLv3:
+   https://www.gnu.org/licenses/agpl-3.0.en.html
+
+   THE JUCE FRAMEWORK IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL
+   WARRANTIES, WHETHER EXPRESSED OR IMPLIED, INCLUDING WARRANTY OF
+   MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "GraphRenderer.h"
+#include "ControlLatencyMeter.h"
+
+#if JUCE_INTEL
+ #include <emmintrin.h>
+#endif
+
+namespace
+{
+    using IOProcessor = AudioProcessorGraph::AudioGraphIOProcessor;
+
+    /** A level is only shared with the workers if the work that moves off the
+        callback thread (everything but the most expensive step) exceeds this.
+    */
+    constexpr float minOffloadedMicros = 40.0f;
+
+    constexpr int spinIterations = 2000;
+
+    /** Pipelining never uses more stages than this, nor more than workers + 1. */
+    constexpr int maxPipelineStages = 4;
+
+    /** Peaks below this (-90 dB) count as silence, for a decaying bypass tail as
+        well as for suspending nodes whose input has gone quiet.
+    */
+    constexpr double silenceThreshold = 3.1622776601683795e-5;
+
+    /** How long a node's output must stay quiet after its input has before it is
+        suspended, at the least; effects don't always report their short internal
+        delays as a tail.
+    */
+    constexpr double minSilenceHangoverSeconds = 0.05;
+
+    template <typename FloatType>
+    bool isSilent (const AudioBuffer<FloatType>& buffer, int numChannels, int numSamples) noexcept
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            if (buffer.getMagnitude (ch, 0, numSamples) >= (FloatType) silenceThreshold)
+                return false;
+
+        return true;
+    }
+
+    /** Counts the samples of an unbroken quiet stretch; true once it has lasted long enough.
+        A required length of INT_MAX stands for an infinite tail and is never reached.
+    */
+    inline bool hasStayedQuiet (int& quietSamples, bool isQuietNow, int numSamples, int requiredSamples) noexcept
+    {
+        if (! isQuietNow)
+        {
+            quietSamples = 0;
+            return false;
+        }
+
+        if (requiredSamples == std::numeric_limits<int>::max())
+            return false;
+
+        quietSamples = jmin (requiredSamples, quietSamples + numSamples);
+        return quietSamples >= requiredSamples;
+    }
+
+    inline void spinPause() noexcept
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #elif JUCE_ARM && (JUCE_GCC || JUCE_CLANG)
+        __asm__ __volatile__ ("yield");
+       #endif
+    }
+}
+
+//==============================================================================
+struct GraphRenderer::NodeStats
+{
+    /** Only the thread that runs the node writes this, so a relaxed update is enough. */
+    void addMeasurement (double micros) noexcept
+    {
+        const auto old = averageMicros.load (std::memory_order_relaxed);
+        averageMicros.store (old + 0.05f * ((float) micros - old), std::memory_order_relaxed);
+    }
+
+    std::atomic<float> averageMicros { 0.0f };
+
+    /** Set on the message thread whenever a plan is created. */
+    int latencyAtOutput = 0;
+
+    /** Where a bypassable node is on its way from running to being skipped. Kept
+        here rather than in the plan so that it survives rebuilds; only the thread
+        that runs the node changes it.
+    */
+    enum BypassState { active, ringing, idle };
+
+    std::atomic<int> bypassState { active };
+    int quietTailSamples = 0;
+
+    /** Set while the node is skipped because its input is silent and its output
+        has decayed; changed only by the thread that runs the node, like the above.
+    */
+    std::atomic<bool> suspended { false };
+    int quietOutputSamples = 0;
+};
+
+//==============================================================================
+struct GraphRenderer::RenderPlan
+{
+    enum class Kind { processor, audioInput, audioOutput, ignored };
+
+    /** One incoming connection of an input channel. */
+    struct Source
+    {
+        int step = 0, channel = 0;
+
+        // set when the source lives in an earlier pipeline stage
+        int boundary = -1, boundaryChannel = 0;
+
+        // delay compensation: samples this connection arrives too early
+        int delay = 0, writePos = 0;
+        std::vector<float> floatDelay;
+        std::vector<double> doubleDelay;
+    };
+
+    struct Step
+    {
+        AudioProcessorGraph::Node::Ptr node;
+        std::shared_ptr<NodeStats> stats;
+        Kind kind = Kind::processor;
+
+        int numInputs = 0, numOutputs = 0, numChannels = 0;
+        int level = 0;
+        int latencyAtOutput = 0;
+        bool processInDouble = false;
+
+        // set for nodes that can be skipped while bypassed; the scratch buffers hold
+        // the dry signal of a fade or the tail rendered from silence
+        BypassableProcessor* bypassable = nullptr;
+        int tailSamples = 0;
+
+        // a node is suspended once its output stays quiet this long after its input went silent;
+        // outputSilent is set for the current block when the step's buffer holds nothing but zeros
+        int silenceHangover = 0;
+        bool outputSilent = false;
+
+        std::vector<std::vector<Source>> inputs;
+        AudioBuffer<float> floatBuffer, floatScratch;
+        AudioBuffer<double> doubleBuffer, doubleScratch;
+        MidiBuffer midi;
+    };
+
+    struct Level
+    {
+        int firstStep = 0, numSteps = 0;
+    };
+
+    /** Single-producer/single-consumer hand-over of one block without locks.
+
+        The producer writes its slot and swaps it with the middle one, the
+        consumer swaps its slot with the middle one when that holds a fresh
+        block. Neither side ever waits; an overrun repeats or drops a block,
+        which acquire() reports by returning false.
+    */
+    template <typename FloatType>
+    struct TripleBuffer
+    {
+        void allocate (int numChannels, int numSamples)
+        {
+            for (auto& b : buffers)
+            {
+                b.setSize (numChannels, numSamples);
+                b.clear();
+            }
+        }
+
+        AudioBuffer<FloatType>& getWriteBuffer() noexcept             { return buffers[(size_t) writeIndex]; }
+        const AudioBuffer<FloatType>& getReadBuffer() const noexcept  { return buffers[(size_t) readIndex]; }
+        int getReadNumSamples() const noexcept                        { return numSamples[(size_t) readIndex]; }
+
+        void publish (int numWritten) noexcept
+        {
+            numSamples[(size_t) writeIndex] = numWritten;
+            writeIndex = middle.exchange (writeIndex | freshBit) & indexMask;
+        }
+
+        bool acquire() noexcept
+        {
+            if ((middle.load() & freshBit) == 0)
+                return false;
+
+            readIndex = middle.exchange (readIndex) & indexMask;
+            return true;
+        }
+
+        static constexpr int freshBit = 4, indexMask = 3;
+
+        std::array<AudioBuffer<FloatType>, 3> buffers;
+        std::array<int, 3> numSamples {};
+        int writeIndex = 0, readIndex = 1;
+        std::atomic<int> middle { 2 };
+    };
+
+    /** The audio crossing from one pipeline stage into the next. */
+    struct Boundary
+    {
+        std::vector<int> sourceSteps, firstChannel;
+        int numChannels = 0;
+
+        TripleBuffer<float> floatSlots;
+        TripleBuffer<double> doubleSlots;
+    };
+
+    struct Pipeline
+    {
+        enum StageState { idle, running, locked };
+
+        struct Stage
+        {
+            int firstLevel = 0, endLevel = 0;
+        };
+
+        Pipeline()
+        {
+            for (auto& s : stageStates)
+                s.store (idle);
+        }
+
+        // boundaries[i] is written by stage i; the last one carries the graph output
+        std::vector<Stage> stages;
+        std::vector<std::unique_ptr<Boundary>> boundaries;
+
+        // a stage's input may only be swapped while the stage is idle
+        std::array<std::atomic<int>, maxPipelineStages> stageStates;
+
+        // chunks rendered so far; from stages.size() on, every callback must find a fresh output
+        int numChunksRendered = 0;
+    };
+
+    std::vector<Step> steps;
+    std::vector<Level> levels;
+    std::unique_ptr<Pipeline> pipeline;
+    int outputStep = -1;
+    int blockSize = 0;
+    int latency = 0, pipelineLatency = 0;
+    int crossfadeSamples = 0;
+    bool useDouble = false;
+    bool bypassSpillover = false;
+
+    // holds the input for, and then the output of, the outgoing plan while this one fades in
+    AudioBuffer<float> floatFade;
+    AudioBuffer<double> doubleFade;
+
+    // the chunk currently being rendered, published to the workers with each level
+    AudioBuffer<float>* floatIO = nullptr;
+    AudioBuffer<double>* doubleIO = nullptr;
+    int startSample = 0, numSamples = 0;
+};
+
+//==============================================================================
+/** Pinned real-time workers that help the callback thread through one level at a time.
+
+    A level's steps are split into one slice per participant (workers plus the
+    callback thread). Each participant claims steps from its own slice with an
+    atomic cursor, then steals from the other slices the same way, so every
+    step is claimed exactly once without locks. Idle workers spin for a while
+    before blocking on an event, which keeps back-to-back levels cheap.
+*/
+class GraphRenderer::WorkerPool
+{
+public:
+    WorkerPool (int numWorkers, double sampleRate, int blockSize)
+        : slices ((size_t) numWorkers + 1)
+    {
+        const auto numCpus = jmax (1, SystemStats::getNumCpus());
+
+        for (int i = 0; i < numWorkers; ++i)
+        {
+            auto* w = workers.add (new Worker (*this, i));
+
+            // leave the first core to the audio callback thread
+            w->setAffinityMask ((uint32) 1 << ((i + 1) % numCpus));
+
+            const auto options = Thread::RealtimeOptions{}.withPriority (8)
+                                                          .withApproximateAudioProcessingTime (blockSize, sampleRate);
+
+            if (! w->startRealtimeThread (options))
+                w->startThread (Thread::Priority::highest);
+        }
+    }
+
+    ~WorkerPool()
+    {
+        for (auto* w : workers)
+            w->signalThreadShouldExit();
+
+        for (auto* w : workers)
+            w->wakeUp.signal();
+
+        for (auto* w : workers)
+            w->stopThread (1000);
+    }
+
+    int getNumWorkers() const noexcept      { return workers.size(); }
+
+    /** Runs a level on all participants; called on the audio callback thread. */
+    void run (RenderPlan& plan, int levelIndex)
+    {
+        const auto& level = plan.levels[(size_t) levelIndex];
+        const auto numParticipants = (int) slices.size();
+
+        currentPlan = &plan;
+
+        for (int p = 0; p < numParticipants; ++p)
+        {
+            auto& s = slices[(size_t) p];
+            s.end = level.firstStep + (level.numSteps * (p + 1)) / numParticipants;
+            s.next.store (level.firstStep + (level.numSteps * p) / numParticipants);
+        }
+
+        remaining.store (level.numSteps);
+        jobOpen.store (true);
+        generation.fetch_add (1);
+
+        for (auto* w : workers)
+            if (w->sleeping.load())
+                w->wakeUp.signal();
+
+        participate (numParticipants - 1);
+
+        while (remaining.load() > 0)
+            spinPause();
+
+        // close the job and make sure nobody still looks at the slices before they are reused
+        jobOpen.store (false);
+
+        while (busy.load() > 0)
+            spinPause();
+    }
+
+    /** Starts every pipeline stage after the first on its own worker and returns
+        straight away; called on the audio callback thread.
+    */
+    void startPipeline (RenderPlan& plan)
+    {
+        currentPlan = &plan;
+        pipelineMode.store (true);
+        jobOpen.store (true);
+        generation.fetch_add (1);
+
+        for (auto* w : workers)
+            if (w->sleeping.load())
+                w->wakeUp.signal();
+    }
+
+    /** Waits until no worker touches the current plan any more, so it can be replaced. */
+    void quiesce()
+    {
+        jobOpen.store (false);
+
+        while (busy.load() > 0)
+            spinPause();
+
+        pipelineMode.store (false);
+    }
+
+private:
+    struct Slice
+    {
+        std::atomic<int> next { 0 };
+        int end = 0;
+    };
+
+    struct Worker final : public Thread
+    {
+        Worker (WorkerPool& p, int i)
+            : Thread ("Graph render worker " + String (i + 1)), pool (p), index (i) {}
+
+        void run() override
+        {
+            auto seen = pool.generation.load();
+
+            while (! threadShouldExit())
+            {
+                int spins = 0;
+
+                for (;;)
+                {
+                    const auto g = pool.generation.load();
+
+                    if (g != seen)
+                    {
+                        seen = g;
+                        break;
+                    }
+
+                    if (threadShouldExit())
+                        return;
+
+                    if (++spins < spinIterations)
+                    {
+                        spinPause();
+                        continue;
+                    }
+
+                    sleeping.store (true);
+
+                    if (pool.generation.load() == seen)
+                        wakeUp.wait (100);
+
+                    sleeping.store (false);
+                    spins = 0;
+                }
+
+                pool.busy.fetch_add (1);
+
+                if (pool.jobOpen.load())
+                {
+                    if (! pool.pipelineMode.load())
+                        pool.participate (index);
+                    else if (index + 1 < (int) pool.currentPlan->pipeline->stages.size())
+                        GraphRenderer::runPipelineStage (*pool.currentPlan, index + 1);
+                }
+
+                pool.busy.fetch_sub (1);
+            }
+        }
+
+        WorkerPool& pool;
+        const int index;
+        std::atomic<bool> sleeping { false };
+        WaitableEvent wakeUp;
+    };
+
+    void participate (int participant)
+    {
+        const ScopedNoDenormals noDenormals;
+        const auto numParticipants = (int) slices.size();
+
+        for (int i = 0; i < numParticipants; ++i)
+        {
+            auto& s = slices[(size_t) ((participant + i) % numParticipants)];
+
+            for (;;)
+            {
+                const auto step = s.next.fetch_add (1);
+
+                if (step >= s.end)
+                    break;
+
+                GraphRenderer::runStep (*currentPlan, step, currentPlan->numSamples);
+                remaining.fetch_sub (1);
+            }
+        }
+    }
+
+    OwnedArray<Worker> workers;
+    std::vector<Slice> slices;
+    RenderPlan* currentPlan = nullptr;
+
+    std::atomic<uint32> generation { 0 };
+    std::atomic<int> remaining { 0 }, busy { 0 };
+    std::atomic<bool> jobOpen { false }, pipelineMode { false };
+
+    JUCE_DECLARE_NON_COPYABLE (WorkerPool)
+};
+
+//==============================================================================
+GraphRenderer::GraphRenderer (AudioProcessorGraph& g)
+    : graph (g)
+{
+    graph.addChangeListener (this);
+}
+
+GraphRenderer::~GraphRenderer()
+{
+    graph.removeChangeListener (this);
+    stopTimer();
+
+    workerPool.reset();
+    activePlan.reset();
+    pendingPlan.reset();
+    retiredPlan.reset();
+    fadingPlan.reset();
+
+    releaseNodes();
+}
+
+//==============================================================================
+void GraphRenderer::setParallelRenderingEnabled (bool shouldBeEnabled) noexcept
+{
+    parallelRenderingEnabled.store (shouldBeEnabled);
+}
+
+bool GraphRenderer::isParallelRenderingEnabled() const noexcept
+{
+    return parallelRenderingEnabled.load();
+}
+
+void GraphRenderer::setPipelinedRenderingEnabled (bool shouldBeEnabled)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (pipelinedRenderingEnabled != shouldBeEnabled)
+    {
+        pipelinedRenderingEnabled = shouldBeEnabled;
+        rebuild();
+    }
+}
+
+bool GraphRenderer::isPipelinedRenderingEnabled() const noexcept
+{
+    return pipelinedRenderingEnabled;
+}
+
+void GraphRenderer::setBypassSpilloverEnabled (bool shouldBeEnabled)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (bypassSpilloverEnabled != shouldBeEnabled)
+    {
+        bypassSpilloverEnabled = shouldBeEnabled;
+        rebuild();
+    }
+}
+
+bool GraphRenderer::isBypassSpilloverEnabled() const noexcept
+{
+    return bypassSpilloverEnabled;
+}
+
+int GraphRenderer::getNumPipelineStages() const noexcept
+{
+    return numPipelineStages.load();
+}
+
+int GraphRenderer::getPipelineLatencySamples() const noexcept
+{
+    return pipelineLatency.load();
+}
+
+int GraphRenderer::getNumPipelineOverruns() const noexcept
+{
+    return pipelineOverruns.load (std::memory_order_relaxed);
+}
+
+void GraphRenderer::setBlockStartListener (BlockStartListener* listener) noexcept
+{
+    blockStartListener.store (listener);
+}
+
+int GraphRenderer::getNumWorkers() const noexcept
+{
+    return workerPool != nullptr ? workerPool->getNumWorkers() : 0;
+}
+
+float GraphRenderer::getAverageNodeCostMicros (AudioProcessorGraph::NodeID nodeID) const
+{
+    const auto it = nodeStats.find (nodeID.uid);
+    return it != nodeStats.end() ? it->second->averageMicros.load (std::memory_order_relaxed) : 0.0f;
+}
+
+GraphRenderer::NodeActivity GraphRenderer::getNodeActivity (AudioProcessorGraph::NodeID nodeID) const
+{
+    const auto it = nodeStats.find (nodeID.uid);
+
+    if (it == nodeStats.end())
+        return NodeActivity::processing;
+
+    const auto& stats = *it->second;
+
+    if (stats.suspended.load (std::memory_order_relaxed))
+        return NodeActivity::silent;
+
+    switch (stats.bypassState.load (std::memory_order_relaxed))
+    {
+        case NodeStats::ringing:    return NodeActivity::ringingOut;
+        case NodeStats::idle:       return NodeActivity::bypassed;
+        default:                    return NodeActivity::processing;
+    }
+}
+
+int GraphRenderer::getNodeLatencyAtOutput (AudioProcessorGraph::NodeID nodeID) const
+{
+    const auto it = nodeStats.find (nodeID.uid);
+    return it != nodeStats.end() ? it->second->latencyAtOutput : 0;
+}
+
+std::shared_ptr<GraphRenderer::NodeStats> GraphRenderer::getStatsFor (AudioProcessorGraph::NodeID nodeID)
+{
+    auto& stats = nodeStats[nodeID.uid];
+
+    if (stats == nullptr)
+        stats = std::make_shared<NodeStats>();
+
+    return stats;
+}
+
+//==============================================================================
+void GraphRenderer::prepareToPlay (double sampleRate, int blockSize)
+{
+    const auto settingsChanged = ! isPrepared
+                              || sampleRate != getSampleRate()
+                              || blockSize != getBlockSize()
+                              || getProcessingPrecision() != preparedPrecision;
+
+    preparedPrecision = getProcessingPrecision();
+
+    setRateAndBufferSizeDetails (sampleRate, blockSize);
+
+    // the graph and its I/O nodes still report the device layout to the editor
+    graph.setPlayConfigDetails (getTotalNumInputChannels(), getTotalNumOutputChannels(), sampleRate, blockSize);
+
+    for (auto* node : graph.getNodes())
+        if (auto* io = dynamic_cast<IOProcessor*> (node->getProcessor()))
+            io->setParentGraph (&graph);
+
+    if (settingsChanged)
+        releaseNodes();
+
+    isPrepared = true;
+
+    const auto numWorkers = jmin (3, SystemStats::getNumCpus() - 1);
+
+    if (workerPool == nullptr && numWorkers > 0)
+        workerPool = std::make_unique<WorkerPool> (numWorkers, sampleRate, blockSize);
+
+    auto plan = createPlan();
+    planCreated (*plan);
+
+    // pipeline stages of the old plan may still be running on the workers
+    if (workerPool != nullptr)
+        workerPool->quiesce();
+
+    const SpinLock::ScopedLockType sl (planLock);
+    activePlan = std::move (plan);
+    pendingPlan.reset();
+    retiredPlan.reset();
+    fadingPlan.reset();
+}
+
+void GraphRenderer::releaseResources()
+{
+    // stop the workers first, a pipeline stage could still be using the active plan
+    workerPool.reset();
+
+    {
+        const SpinLock::ScopedLockType sl (planLock);
+        activePlan.reset();
+        pendingPlan.reset();
+        retiredPlan.reset();
+        fadingPlan.reset();
+    }
+
+    releaseNodes();
+    isPrepared = false;
+}
+
+void GraphRenderer::prepareNode (AudioProcessorGraph::Node& node)
+{
+    auto* proc = node.getProcessor();
+
+    if (proc == nullptr || dynamic_cast<IOProcessor*> (proc) != nullptr)
+        return;
+
+    prepareProcessor (*proc, getSampleRate(), getBlockSize(), getProcessingPrecision());
+}
+
+void GraphRenderer::prepareProcessor (AudioProcessor& proc, double sampleRate, int blockSize, ProcessingPrecision precision)
+{
+    const auto useDouble = precision == doublePrecision && proc.supportsDoublePrecisionProcessing();
+
+    proc.setProcessingPrecision (useDouble ? doublePrecision : singlePrecision);
+    proc.setRateAndBufferSizeDetails (sampleRate, blockSize);
+    proc.prepareToPlay (sampleRate, blockSize);
+}
+
+void GraphRenderer::adoptPreparedNode (AudioProcessorGraph::Node::Ptr node, double sampleRate, int blockSize, ProcessingPrecision precision)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (node == nullptr
+         || ! isPrepared
+         || sampleRate != getSampleRate()
+         || blockSize != getBlockSize()
+         || precision != getProcessingPrecision())
+        return;
+
+    const auto isKnown = std::any_of (preparedNodes.begin(), preparedNodes.end(),
+                                      [&] (const AudioProcessorGraph::Node::Ptr& n) { return n == node; });
+
+    if (! isKnown)
+        preparedNodes.push_back (std::move (node));
+}
+
+void GraphRenderer::releaseNodes()
+{
+    for (auto& node : preparedNodes)
+        if (auto* proc = node->getProcessor())
+            if (dynamic_cast<IOProcessor*> (proc) == nullptr)
+                proc->releaseResources();
+
+    preparedNodes.clear();
+}
+
+//==============================================================================
+void GraphRenderer::changeListenerCallback (ChangeBroadcaster*)
+{
+    rebuild();
+}
+
+void GraphRenderer::rebuild (double crossfadeSeconds)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (! isPrepared)
+        return;
+
+    auto plan = createPlan();
+    planCreated (*plan);
+
+    auto sharesNodesWith = [&] (const RenderPlan* other)
+    {
+        if (other == nullptr)
+            return false;
+
+        for (const auto& a : other->steps)
+            for (const auto& b : plan->steps)
+                if (a.node == b.node)
+                    return true;
+
+        return false;
+    };
+
+    auto hasSameNodesAs = [&] (const RenderPlan& other)
+    {
+        if (other.steps.size() != plan->steps.size())
+            return false;
+
+        for (const auto& a : other.steps)
+            if (std::none_of (plan->steps.begin(), plan->steps.end(), [&] (const auto& b) { return a.node == b.node; }))
+                return false;
+
+        return true;
+    };
+
+    {
+        const SpinLock::ScopedLockType sl (planLock);
+
+        // the plans' step lists never change once created, so they can be compared here.
+        // The graph's own change message for the nodes of a faded-in preset arrives after
+        // the faded rebuild; replacing that plan before it was swapped in keeps its fade.
+        auto crossfadeSamples = 0;
+
+        if (crossfadeSeconds > 0.0 && ! sharesNodesWith (pendingPlan.get()))
+            crossfadeSamples = jmax (1, roundToInt (crossfadeSeconds * getSampleRate()));
+        else if (pendingPlan != nullptr && pendingPlan->crossfadeSamples > 0 && hasSameNodesAs (*pendingPlan))
+            crossfadeSamples = pendingPlan->crossfadeSamples;
+
+        if (crossfadeSamples > 0
+             && plan->pipeline == nullptr
+             && activePlan != nullptr && activePlan->pipeline == nullptr
+             && ! sharesNodesWith (activePlan.get()))
+        {
+            const auto numChannels = jmax (getTotalNumInputChannels(), getTotalNumOutputChannels());
+            plan->crossfadeSamples = crossfadeSamples;
+
+            if (plan->useDouble)
+                plan->doubleFade.setSize (numChannels, plan->blockSize);
+            else
+                plan->floatFade.setSize (numChannels, plan->blockSize);
+        }
+
+        pendingPlan = std::move (plan);
+    }
+
+    startTimer (500);
+}
+
+void GraphRenderer::planCreated (const RenderPlan& plan)
+{
+    numPipelineStages.store (plan.pipeline != nullptr ? (int) plan.pipeline->stages.size() : 1);
+    pipelineLatency.store (plan.pipelineLatency);
+    setLatencySamples (plan.latency + plan.pipelineLatency);
+
+    for (auto& step : plan.steps)
+        if (step.stats != nullptr)
+            step.stats->latencyAtOutput = step.latencyAtOutput;
+
+    if (pipelineNeedsMeasuredCosts)
+        startTimer (500);
+}
+
+void GraphRenderer::timerCallback()
+{
+    std::unique_ptr<RenderPlan> toDelete;
+    bool isSettled = false;
+
+    {
+        const SpinLock::ScopedLockType sl (planLock);
+        toDelete = std::move (retiredPlan);
+        isSettled = pendingPlan == nullptr && fadingPlan == nullptr;
+    }
+
+    // cut points chosen before anything was measured are redone once the nodes have run
+    if (isSettled && pipelineNeedsMeasuredCosts)
+    {
+        const auto hasMeasurements = std::any_of (nodeStats.begin(), nodeStats.end(),
+                                                  [] (const auto& s) { return s.second->averageMicros.load (std::memory_order_relaxed) > 0.0f; });
+
+        if (hasMeasurements)
+        {
+            rebuild();
+            return;
+        }
+    }
+
+    if (isSettled && ! pipelineNeedsMeasuredCosts)
+        stopTimer();
+}
+
+std::unique_ptr<GraphRenderer::RenderPlan> GraphRenderer::createPlan()
+{
+    using Plan = RenderPlan;
+
+    auto plan = std::make_unique<Plan>();
+    plan->blockSize = getBlockSize();
+    plan->useDouble = getProcessingPrecision() == doublePrecision;
+    plan->bypassSpillover = bypassSpilloverEnabled;
+
+    const auto& nodes = graph.getNodes();
+    const auto connections = graph.getConnections();
+    const auto numNodes = nodes.size();
+
+    // forget nodes that have left the graph (the retired plan keeps them alive as long as needed)
+    preparedNodes.erase (std::remove_if (preparedNodes.begin(), preparedNodes.end(),
+                                         [&] (const AudioProcessorGraph::Node::Ptr& n) { return ! nodes.contains (n.get()); }),
+                         preparedNodes.end());
+
+    for (auto it = nodeStats.begin(); it != nodeStats.end();)
+        it = graph.getNodeForId (AudioProcessorGraph::NodeID { it->first }) == nullptr ? nodeStats.erase (it) : std::next (it);
+
+    for (auto* node : nodes)
+    {
+        const auto isPreparedAlready = std::any_of (preparedNodes.begin(), preparedNodes.end(),
+                                                    [node] (const AudioProcessorGraph::Node::Ptr& n) { return n.get() == node; });
+
+        if (! isPreparedAlready)
+        {
+            prepareNode (*node);
+            preparedNodes.emplace_back (node);
+        }
+    }
+
+    // topological levels (Kahn): a node sits one level below its deepest source
+    std::map<uint32, int> indexOfNode;
+
+    for (int i = 0; i < numNodes; ++i)
+        indexOfNode[nodes.getObjectPointerUnchecked (i)->nodeID.uid] = i;
+
+    std::vector<std::vector<int>> dependents ((size_t) numNodes);
+    std::vector<int> numSources ((size_t) numNodes, 0), levelOfNode ((size_t) numNodes, 0);
+
+    for (const auto& c : connections)
+    {
+        if (c.source.isMIDI() || c.destination.isMIDI())
+            continue;
+
+        const auto src = indexOfNode.find (c.source.nodeID.uid);
+        const auto dst = indexOfNode.find (c.destination.nodeID.uid);
+
+        if (src == indexOfNode.end() || dst == indexOfNode.end())
+            continue;
+
+        auto& d = dependents[(size_t) src->second];
+
+        if (std::find (d.begin(), d.end(), dst->second) == d.end())
+        {
+            d.push_back (dst->second);
+            ++numSources[(size_t) dst->second];
+        }
+    }
+
+    std::vector<int> order, ready;
+
+    for (int i = 0; i < numNodes; ++i)
+        if (numSources[(size_t) i] == 0)
+            ready.push_back (i);
+
+    while (! ready.empty())
+    {
+        const auto n = ready.back();
+        ready.pop_back();
+        order.push_back (n);
+
+        for (auto d : dependents[(size_t) n])
+        {
+            levelOfNode[(size_t) d] = jmax (levelOfNode[(size_t) d], levelOfNode[(size_t) n] + 1);
+
+            if (--numSources[(size_t) d] == 0)
+                ready.push_back (d);
+        }
+    }
+
+    // the graph refuses feedback loops, but never drop a node if one sneaks in
+    for (int i = 0; i < numNodes; ++i)
+        if (std::find (order.begin(), order.end(), i) == order.end())
+            order.push_back (i);
+
+    std::stable_sort (order.begin(), order.end(),
+                      [&] (int a, int b) { return levelOfNode[(size_t) a] < levelOfNode[(size_t) b]; });
+
+    std::map<uint32, int> stepOfNode;
+
+    for (auto n : order)
+    {
+        auto* node = nodes.getObjectPointerUnchecked (n);
+        auto* proc = node->getProcessor();
+
+        Plan::Step step;
+        step.node = node;
+        step.stats = getStatsFor (node->nodeID);
+        step.level = levelOfNode[(size_t) n];
+
+        if (auto* io = dynamic_cast<IOProcessor*> (proc))
+        {
+            switch (io->getType())
+            {
+                case IOProcessor::audioInputNode:
+                    step.kind = Plan::Kind::audioInput;
+                    step.numOutputs = getTotalNumInputChannels();
+                    break;
+
+                case IOProcessor::audioOutputNode:
+                    step.kind = Plan::Kind::audioOutput;
+                    step.numInputs = getTotalNumOutputChannels();
+                    plan->outputStep = (int) plan->steps.size();
+                    break;
+
+                case IOProcessor::midiInputNode:
+                case IOProcessor::midiOutputNode:
+                default:
+                    step.kind = Plan::Kind::ignored;
+                    break;
+            }
+        }
+        else if (proc != nullptr)
+        {
+            step.numInputs  = proc->getTotalNumInputChannels();
+            step.numOutputs = proc->getTotalNumOutputChannels();
+            step.processInDouble = plan->useDouble && proc->supportsDoublePrecisionProcessing();
+            step.bypassable = dynamic_cast<BypassableProcessor*> (proc);
+
+            // an infinite (or just very long) tail never decays
+            const auto tailSeconds = proc->getTailLengthSeconds();
+            const auto minHangover = roundToInt (minSilenceHangoverSeconds * getSampleRate());
+
+            if (tailSeconds < 60.0)
+            {
+                step.tailSamples = roundToInt (tailSeconds * getSampleRate());
+                step.silenceHangover = jmax (minHangover, step.tailSamples + proc->getLatencySamples());
+            }
+            else
+            {
+                step.tailSamples = step.silenceHangover = std::numeric_limits<int>::max();
+            }
+        }
+        else
+        {
+            step.kind = Plan::Kind::ignored;
+        }
+
+        step.numChannels = jmax (step.numInputs, step.numOutputs);
+        step.inputs.resize ((size_t) step.numInputs);
+
+        if (plan->useDouble)
+            step.doubleBuffer.setSize (step.numChannels, plan->blockSize);
+
+        if (! plan->useDouble || (step.kind == Plan::Kind::processor && ! step.processInDouble))
+            step.floatBuffer.setSize (step.numChannels, plan->blockSize);
+
+        if (step.bypassable != nullptr)
+        {
+            if (step.processInDouble)
+                step.doubleScratch.setSize (step.numChannels, plan->blockSize);
+            else
+                step.floatScratch.setSize (step.numChannels, plan->blockSize);
+        }
+
+        step.midi.ensureSize (16);
+
+        stepOfNode[node->nodeID.uid] = (int) plan->steps.size();
+        plan->steps.push_back (std::move (step));
+    }
+
+    // wire up the inputs and compensate latency: every input of a step is delayed to
+    // line up with the latest-arriving one
+    for (const auto& c : connections)
+    {
+        if (c.source.isMIDI() || c.destination.isMIDI())
+            continue;
+
+        const auto src = stepOfNode.find (c.source.nodeID.uid);
+        const auto dst = stepOfNode.find (c.destination.nodeID.uid);
+
+        if (src == stepOfNode.end() || dst == stepOfNode.end())
+            continue;
+
+        auto& sourceStep = plan->steps[(size_t) src->second];
+        auto& destStep   = plan->steps[(size_t) dst->second];
+
+        if (c.source.channelIndex >= sourceStep.numOutputs || c.destination.channelIndex >= destStep.numInputs)
+            continue;
+
+        Plan::Source s;
+        s.step = src->second;
+        s.channel = c.source.channelIndex;
+        destStep.inputs[(size_t) c.destination.channelIndex].push_back (std::move (s));
+    }
+
+    for (auto& step : plan->steps)
+    {
+        int arrival = 0;
+
+        for (auto& channelSources : step.inputs)
+            for (auto& s : channelSources)
+                arrival = jmax (arrival, plan->steps[(size_t) s.step].latencyAtOutput);
+
+        for (auto& channelSources : step.inputs)
+        {
+            for (auto& s : channelSources)
+            {
+                s.delay = arrival - plan->steps[(size_t) s.step].latencyAtOutput;
+
+                if (s.delay > 0)
+                {
+                    if (plan->useDouble)
+                        s.doubleDelay.assign ((size_t) s.delay + 1, 0.0);
+                    else
+                        s.floatDelay.assign ((size_t) s.delay + 1, 0.0f);
+                }
+            }
+        }
+
+        const auto ownLatency = step.kind == Plan::Kind::processor ? step.node->getProcessor()->getLatencySamples() : 0;
+        step.latencyAtOutput = arrival + ownLatency;
+    }
+
+    if (plan->outputStep >= 0)
+        plan->latency = plan->steps[(size_t) plan->outputStep].latencyAtOutput;
+
+    for (int i = 0; i < (int) plan->steps.size();)
+    {
+        Plan::Level level;
+        level.firstStep = i;
+
+        while (i < (int) plan->steps.size() && plan->steps[(size_t) i].level == plan->steps[(size_t) level.firstStep].level)
+            ++i;
+
+        level.numSteps = i - level.firstStep;
+        plan->levels.push_back (level);
+    }
+
+    pipelineNeedsMeasuredCosts = false;
+
+    if (pipelinedRenderingEnabled)
+        createPipeline (*plan);
+
+    return plan;
+}
+
+void GraphRenderer::createPipeline (RenderPlan& plan)
+{
+    using Plan = RenderPlan;
+
+    const auto numLevels = (int) plan.levels.size();
+
+    if (plan.outputStep < 0 || workerPool == nullptr)
+        return;
+
+    // the output has to end up in the last stage, so nothing is cut behind it
+    const auto outputLevel = plan.steps[(size_t) plan.outputStep].level;
+
+    // a cut in front of level k is only possible if every connection crossing it
+    // comes straight from level k - 1, so each signal passes each cut exactly once
+    std::vector<bool> canCut ((size_t) numLevels + 1, true);
+
+    for (const auto& step : plan.steps)
+        for (const auto& channelSources : step.inputs)
+            for (const auto& s : channelSources)
+                for (auto k = plan.steps[(size_t) s.step].level + 2; k <= step.level; ++k)
+                    canCut[(size_t) k] = false;
+
+    std::vector<int> candidates;
+
+    for (int k = 1; k <= outputLevel && k < numLevels; ++k)
+        if (canCut[(size_t) k])
+            candidates.push_back (k);
+
+    const auto numStages = jmin ((int) candidates.size() + 1, workerPool->getNumWorkers() + 1, maxPipelineStages);
+
+    if (numStages < 2)
+        return;
+
+    // balance the measured cost; before the first measurement every level counts the same
+    std::vector<float> costBefore ((size_t) numLevels + 1, 0.0f);
+
+    for (int l = 0; l < numLevels; ++l)
+    {
+        const auto& level = plan.levels[(size_t) l];
+        float cost = 0.0f;
+
+        for (int i = level.firstStep; i < level.firstStep + level.numSteps; ++i)
+            cost += plan.steps[(size_t) i].stats->averageMicros.load (std::memory_order_relaxed);
+
+        costBefore[(size_t) l + 1] = costBefore[(size_t) l] + cost;
+    }
+
+    if (costBefore.back() <= 0.0f)
+    {
+        pipelineNeedsMeasuredCosts = true;
+
+        for (int l = 0; l <= numLevels; ++l)
+            costBefore[(size_t) l] = (float) l;
+    }
+
+    std::vector<int> cuts;
+
+    for (int j = 1; j < numStages; ++j)
+    {
+        const auto target = costBefore.back() * (float) j / (float) numStages;
+        auto best = -1;
+
+        for (auto k : candidates)
+        {
+            const auto stagesLeft = numStages - j;
+            const auto cutsLeft = (int) (candidates.end() - std::find (candidates.begin(), candidates.end(), k));
+
+            if ((! cuts.empty() && k <= cuts.back()) || cutsLeft < stagesLeft)
+                continue;
+
+            if (best < 0 || std::abs (costBefore[(size_t) k] - target) < std::abs (costBefore[(size_t) best] - target))
+                best = k;
+        }
+
+        if (best < 0)
+            break;
+
+        cuts.push_back (best);
+    }
+
+    if (cuts.empty())
+        return;
+
+    auto pipeline = std::make_unique<Plan::Pipeline>();
+    std::vector<int> stageOfLevel ((size_t) numLevels, 0);
+
+    for (int i = 0; i <= (int) cuts.size(); ++i)
+    {
+        Plan::Pipeline::Stage stage;
+        stage.firstLevel = i == 0 ? 0 : cuts[(size_t) i - 1];
+        stage.endLevel = i < (int) cuts.size() ? cuts[(size_t) i] : numLevels;
+
+        for (int l = stage.firstLevel; l < stage.endLevel; ++l)
+            stageOfLevel[(size_t) l] = i;
+
+        pipeline->stages.push_back (stage);
+    }
+
+    auto addBoundary = [&] { return pipeline->boundaries.emplace_back (std::make_unique<Plan::Boundary>()).get(); };
+
+    auto addSourceStep = [&] (Plan::Boundary& b, int stepIndex)
+    {
+        const auto it = std::find (b.sourceSteps.begin(), b.sourceSteps.end(), stepIndex);
+
+        if (it != b.sourceSteps.end())
+            return b.firstChannel[(size_t) (it - b.sourceSteps.begin())];
+
+        b.sourceSteps.push_back (stepIndex);
+        b.firstChannel.push_back (b.numChannels);
+        b.numChannels += plan.steps[(size_t) stepIndex].numOutputs;
+        return b.firstChannel.back();
+    };
+
+    for (size_t i = 0; i < cuts.size(); ++i)
+        addBoundary();
+
+    // connections into the first level of a stage now read from the boundary in front of it
+    for (auto& step : plan.steps)
+    {
+        const auto stage = stageOfLevel[(size_t) step.level];
+
+        for (auto& channelSources : step.inputs)
+        {
+            for (auto& s : channelSources)
+            {
+                if (stageOfLevel[(size_t) plan.steps[(size_t) s.step].level] != stage)
+                {
+                    s.boundary = stage - 1;
+                    s.boundaryChannel = addSourceStep (*pipeline->boundaries[(size_t) s.boundary], s.step) + s.channel;
+                }
+            }
+        }
+    }
+
+    auto* output = addBoundary();
+    output->sourceSteps.push_back (plan.outputStep);
+    output->firstChannel.push_back (0);
+    output->numChannels = plan.steps[(size_t) plan.outputStep].numInputs;
+
+    for (auto& b : pipeline->boundaries)
+    {
+        if (plan.useDouble)
+            b->doubleSlots.allocate (b->numChannels, plan.blockSize);
+        else
+            b->floatSlots.allocate (b->numChannels, plan.blockSize);
+    }
+
+    // every stage hands over one block later than the one before it, and the
+    // callback picks the output up at the start of the next one
+    plan.pipelineLatency = (int) pipeline->stages.size() * plan.blockSize;
+    plan.pipeline = std::move (pipeline);
+}
+
+//==============================================================================
+void GraphRenderer::processBlock (AudioBuffer<float>& buffer, MidiBuffer& midi)
+{
+    midi.clear();
+    processBlockImpl (buffer);
+}
+
+void GraphRenderer::processBlock (AudioBuffer<double>& buffer, MidiBuffer& midi)
+{
+    midi.clear();
+    processBlockImpl (buffer);
+}
+
+template <typename FloatType>
+void GraphRenderer::processBlockImpl (AudioBuffer<FloatType>& buffer)
+{
+    {
+        const SpinLock::ScopedTryLockType sl (planLock);
+
+        // the outgoing plan of a finished crossfade is retired like any other
+        if (sl.isLocked() && fadingPlan != nullptr && retiredPlan == nullptr
+             && fadePosition >= activePlan->crossfadeSamples)
+        {
+            retiredPlan = std::move (fadingPlan);
+        }
+
+        // only swap when the previous plan has been collected, so nothing is freed here
+        if (sl.isLocked() && pendingPlan != nullptr && retiredPlan == nullptr && fadingPlan == nullptr)
+        {
+            // a pipelined plan can still be in use by the workers; their stages are short
+            if (workerPool != nullptr && activePlan != nullptr && activePlan->pipeline != nullptr)
+                workerPool->quiesce();
+
+            if (pendingPlan->crossfadeSamples > 0 && activePlan != nullptr && activePlan->pipeline == nullptr)
+            {
+                fadingPlan = std::move (activePlan);
+                fadePosition = 0;
+            }
+            else
+            {
+                retiredPlan = std::move (activePlan);
+            }
+
+            activePlan = std::move (pendingPlan);
+        }
+    }
+
+    // before the listener, so that a snapshot it recalls is measured against this block
+    ControlLatencyMeter::getInstance().beginBlock (getLatencySamples(), getSampleRate());
+
+    if (auto* listener = blockStartListener.load())
+        listener->renderBlockStarting();
+
+    auto* plan = activePlan.get();
+    constexpr auto isDouble = std::is_same_v<FloatType, double>;
+
+    if (plan == nullptr || plan->blockSize <= 0 || plan->useDouble != isDouble)
+    {
+        buffer.clear();
+        return;
+    }
+
+    for (int start = 0; start < buffer.getNumSamples(); start += plan->blockSize)
+    {
+        const auto numSamples = jmin (plan->blockSize, buffer.getNumSamples() - start);
+
+        if (fadingPlan != nullptr && fadePosition < plan->crossfadeSamples)
+            renderCrossfadeChunk (buffer, start, numSamples);
+        else if (plan->pipeline != nullptr && workerPool != nullptr)
+            renderPipelinedChunk (*plan, buffer, start, numSamples);
+        else
+            renderChunk (*plan, buffer, start, numSamples);
+    }
+}
+
+template <typename FloatType>
+void GraphRenderer::renderCrossfadeChunk (AudioBuffer<FloatType>& io, int startSample, int numSamples)
+{
+    auto& fade = [&]() -> AudioBuffer<FloatType>&
+    {
+        if constexpr (std::is_same_v<FloatType, double>)
+            return activePlan->doubleFade;
+        else
+            return activePlan->floatFade;
+    }();
+
+    const auto numFadeChannels = jmin (io.getNumChannels(), fade.getNumChannels());
+
+    for (int ch = 0; ch < fade.getNumChannels(); ++ch)
+    {
+        if (ch < numFadeChannels)
+            fade.copyFrom (ch, 0, io, ch, startSample, numSamples);
+        else
+            fade.clear (ch, 0, numSamples);
+    }
+
+    AudioBuffer<FloatType> fadeView (fade.getArrayOfWritePointers(), fade.getNumChannels(), numSamples);
+    renderChunk (*fadingPlan, fadeView, 0, numSamples);
+    renderChunk (*activePlan, io, startSample, numSamples);
+
+    const auto length = (FloatType) activePlan->crossfadeSamples;
+    const auto startGain = (FloatType) fadePosition / length;
+    const auto endGain = jmin ((FloatType) 1, (FloatType) (fadePosition + numSamples) / length);
+
+    for (int ch = 0; ch < io.getNumChannels(); ++ch)
+    {
+        io.applyGainRamp (ch, startSample, numSamples, startGain, endGain);
+
+        if (ch < numFadeChannels)
+            io.addFromWithRamp (ch, startSample, fade.getReadPointer (ch), numSamples, (FloatType) 1 - startGain, (FloatType) 1 - endGain);
+    }
+
+    fadePosition += numSamples;
+}
+
+template <typename FloatType>
+void GraphRenderer::renderPipelinedChunk (RenderPlan& plan, AudioBuffer<FloatType>& io, int startSample, int numSamples)
+{
+    using Plan = RenderPlan;
+    auto& pipeline = *plan.pipeline;
+
+    auto getSlots = [] (Plan::Boundary& b) -> Plan::TripleBuffer<FloatType>&
+    {
+        if constexpr (std::is_same_v<FloatType, double>)
+            return b.doubleSlots;
+        else
+            return b.floatSlots;
+    };
+
+    // hand every idle stage the block its predecessor finished during the last
+    // callback; a stage that is still busy simply keeps its old input. The
+    // output is taken here as well, before any stage starts, so it is always
+    // the block the last stage finished during the last callback.
+    const auto numStages = (int) pipeline.stages.size();
+    auto& output = getSlots (*pipeline.boundaries.back());
+
+    if (! output.acquire() && pipeline.numChunksRendered >= numStages)
+        pipelineOverruns.fetch_add (1, std::memory_order_relaxed);
+
+    pipeline.numChunksRendered = jmin (pipeline.numChunksRendered + 1, numStages);
+
+    for (int i = 1; i < numStages; ++i)
+    {
+        auto expected = (int) Plan::Pipeline::idle;
+        auto& state = pipeline.stageStates[(size_t) i];
+
+        if (state.compare_exchange_strong (expected, Plan::Pipeline::locked))
+        {
+            getSlots (*pipeline.boundaries[(size_t) i - 1]).acquire();
+            state.store (Plan::Pipeline::idle);
+        }
+    }
+
+    if constexpr (std::is_same_v<FloatType, double>)
+        plan.doubleIO = &io;
+    else
+        plan.floatIO = &io;
+
+    plan.startSample = startSample;
+    plan.numSamples = numSamples;
+
+    workerPool->startPipeline (plan);
+    runPipelineStageImpl<FloatType> (plan, 0, numSamples);
+
+    const auto& outBuffer = output.getReadBuffer();
+    const auto numReady = jmin (numSamples, output.getReadNumSamples());
+
+    for (int ch = 0; ch < io.getNumChannels(); ++ch)
+    {
+        if (ch < outBuffer.getNumChannels())
+        {
+            io.copyFrom (ch, startSample, outBuffer, ch, 0, numReady);
+            io.clear (ch, startSample + numReady, numSamples - numReady);
+        }
+        else
+        {
+            io.clear (ch, startSample, numSamples);
+        }
+    }
+}
+
+template <typename FloatType>
+void GraphRenderer::renderChunk (RenderPlan& plan, AudioBuffer<FloatType>& io, int startSample, int numSamples)
+{
+    if constexpr (std::is_same_v<FloatType, double>)
+        plan.doubleIO = &io;
+    else
+        plan.floatIO = &io;
+
+    plan.startSample = startSample;
+    plan.numSamples = numSamples;
+
+    for (int l = 0; l < (int) plan.levels.size(); ++l)
+        runLevel (plan, l);
+
+    if (plan.outputStep < 0)
+    {
+        io.clear (startSample, numSamples);
+        return;
+    }
+
+    const auto& out = plan.steps[(size_t) plan.outputStep];
+    const auto& outBuffer = [&]() -> const AudioBuffer<FloatType>&
+    {
+        if constexpr (std::is_same_v<FloatType, double>)
+            return out.doubleBuffer;
+        else
+            return out.floatBuffer;
+    }();
+
+    for (int ch = 0; ch < io.getNumChannels(); ++ch)
+    {
+        if (ch < out.numInputs)
+            io.copyFrom (ch, startSample, outBuffer, ch, 0, numSamples);
+        else
+            io.clear (ch, startSample, numSamples);
+    }
+}
+
+void GraphRenderer::runLevel (RenderPlan& plan, int levelIndex)
+{
+    const auto& level = plan.levels[(size_t) levelIndex];
+
+    if (workerPool != nullptr && level.numSteps > 1 && parallelRenderingEnabled.load (std::memory_order_relaxed))
+    {
+        float total = 0.0f, largest = 0.0f;
+
+        for (int i = level.firstStep; i < level.firstStep + level.numSteps; ++i)
+        {
+            const auto cost = plan.steps[(size_t) i].stats->averageMicros.load (std::memory_order_relaxed);
+            total += cost;
+            largest = jmax (largest, cost);
+        }
+
+        if (total - largest >= minOffloadedMicros)
+        {
+            workerPool->run (plan, levelIndex);
+            return;
+        }
+    }
+
+    for (int i = level.firstStep; i < level.firstStep + level.numSteps; ++i)
+        runStep (plan, i, plan.numSamples);
+}
+
+void GraphRenderer::runStep (RenderPlan& plan, int stepIndex, int numSamples)
+{
+    if (plan.useDouble)
+        runStepImpl<double> (plan, stepIndex, numSamples);
+    else
+        runStepImpl<float> (plan, stepIndex, numSamples);
+}
+
+void GraphRenderer::runPipelineStage (RenderPlan& plan, int stageIndex)
+{
+    using Plan = RenderPlan;
+    auto& state = plan.pipeline->stageStates[(size_t) stageIndex];
+
+    for (auto expected = (int) Plan::Pipeline::idle;
+         ! state.compare_exchange_weak (expected, Plan::Pipeline::running);
+         expected = (int) Plan::Pipeline::idle)
+    {
+        spinPause();
+    }
+
+    const ScopedNoDenormals noDenormals;
+    auto& input = *plan.pipeline->boundaries[(size_t) stageIndex - 1];
+
+    if (plan.useDouble)
+        runPipelineStageImpl<double> (plan, stageIndex, input.doubleSlots.getReadNumSamples());
+    else
+        runPipelineStageImpl<float> (plan, stageIndex, input.floatSlots.getReadNumSamples());
+
+    state.store (Plan::Pipeline::idle);
+}
+
+template <typename FloatType>
+void GraphRenderer::runPipelineStageImpl (RenderPlan& plan, int stageIndex, int numSamples)
+{
+    using Plan = RenderPlan;
+
+    // nothing has reached this stage yet
+    if (numSamples <= 0)
+        return;
+
+    const auto& stage = plan.pipeline->stages[(size_t) stageIndex];
+
+    for (int l = stage.firstLevel; l < stage.endLevel; ++l)
+    {
+        const auto& level = plan.levels[(size_t) l];
+
+        for (int i = level.firstStep; i < level.firstStep + level.numSteps; ++i)
+            runStepImpl<FloatType> (plan, i, numSamples);
+    }
+
+    auto& boundary = *plan.pipeline->boundaries[(size_t) stageIndex];
+    auto& slots = [&]() -> Plan::TripleBuffer<FloatType>&
+    {
+        if constexpr (std::is_same_v<FloatType, double>)
+            return boundary.doubleSlots;
+        else
+            return boundary.floatSlots;
+    }();
+
+    auto& dest = slots.getWriteBuffer();
+
+    for (size_t i = 0; i < boundary.sourceSteps.size(); ++i)
+    {
+        auto& source = plan.steps[(size_t) boundary.sourceSteps[i]];
+        const auto& sourceBuffer = [&]() -> const AudioBuffer<FloatType>&
+        {
+            if constexpr (std::is_same_v<FloatType, double>)
+                return source.doubleBuffer;
+            else
+                return source.floatBuffer;
+        }();
+
+        const auto numChannels = i + 1 < boundary.sourceSteps.size() ? boundary.firstChannel[i + 1] - boundary.firstChannel[i]
+                                                                      : boundary.numChannels - boundary.firstChannel[i];
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            dest.copyFrom (boundary.firstChannel[i] + ch, 0, sourceBuffer, ch, 0, numSamples);
+    }
+
+    slots.publish (numSamples);
+}
+
+template <typename FloatType>
+void GraphRenderer::runStepImpl (RenderPlan& plan, int stepIndex, int numSamples)
+{
+    using Plan = RenderPlan;
+    constexpr auto isDouble = std::is_same_v<FloatType, double>;
+
+    auto getBuffer = [] (Plan::Step& s) -> AudioBuffer<FloatType>&
+    {
+        if constexpr (isDouble)
+            return s.doubleBuffer;
+        else
+            return s.floatBuffer;
+    };
+
+    auto& step = plan.steps[(size_t) stepIndex];
+
+    if (step.kind == Plan::Kind::ignored)
+        return;
+
+    const auto startTicks = Time::getHighResolutionTicks();
+    auto& buffer = getBuffer (step);
+    step.outputSilent = false;
+
+    if (step.kind == Plan::Kind::audioInput)
+    {
+        auto* io = [&]
+        {
+            if constexpr (isDouble)
+                return plan.doubleIO;
+            else
+                return plan.floatIO;
+        }();
+
+        for (int ch = 0; ch < step.numOutputs; ++ch)
+        {
+            if (io != nullptr && ch < io->getNumChannels())
+                buffer.copyFrom (ch, 0, *io, ch, plan.startSample, numSamples);
+            else
+                buffer.clear (ch, 0, numSamples);
+        }
+    }
+    else
+    {
+        // inputs fed only by suspended nodes are known to be silent without looking at them
+        const auto inputKnownSilent = std::all_of (step.inputs.begin(), step.inputs.end(), [&] (const std::vector<Plan::Source>& sources)
+        {
+            return std::all_of (sources.begin(), sources.end(), [&] (const Plan::Source& s)
+            {
+                return s.boundary < 0 && s.delay == 0 && plan.steps[(size_t) s.step].outputSilent;
+            });
+        });
+
+        // gather inputs, delaying the connections that arrive early
+        for (int ch = 0; ch < step.numInputs; ++ch)
+        {
+            auto* dest = buffer.getWritePointer (ch);
+            auto& sources = step.inputs[(size_t) ch];
+
+            if (sources.empty() || inputKnownSilent)
+            {
+                FloatVectorOperations::clear (dest, numSamples);
+                continue;
+            }
+
+            for (size_t i = 0; i < sources.size(); ++i)
+            {
+                auto& s = sources[i];
+                const auto* in = [&]
+                {
+                    if (s.boundary < 0)
+                        return getBuffer (plan.steps[(size_t) s.step]).getReadPointer (s.channel);
+
+                    auto& boundary = *plan.pipeline->boundaries[(size_t) s.boundary];
+
+                    if constexpr (isDouble)
+                        return boundary.doubleSlots.getReadBuffer().getReadPointer (s.boundaryChannel);
+                    else
+                        return boundary.floatSlots.getReadBuffer().getReadPointer (s.boundaryChannel);
+                }();
+                const auto add = i > 0;
+
+                if (s.delay == 0)
+                {
+                    if (add)
+                        FloatVectorOperations::add (dest, in, numSamples);
+                    else
+                        FloatVectorOperations::copy (dest, in, numSamples);
+
+                    continue;
+                }
+
+                auto& line = [&]() -> std::vector<FloatType>&
+                {
+                    if constexpr (isDouble)
+                        return s.doubleDelay;
+                    else
+                        return s.floatDelay;
+                }();
+
+                const auto size = (int) line.size();
+                auto w = s.writePos;
+
+                for (int n = 0; n < numSamples; ++n)
+                {
+                    line[(size_t) w] = in[n];
+
+                    if (++w == size)
+                        w = 0;
+
+                    // with size == delay + 1 the next write slot holds the oldest sample
+                    const auto delayed = line[(size_t) w];
+                    dest[n] = add ? dest[n] + delayed : delayed;
+                }
+
+                s.writePos = w;
+            }
+        }
+
+        if (step.kind == Plan::Kind::processor)
+        {
+            for (int ch = step.numInputs; ch < step.numChannels; ++ch)
+                buffer.clear (ch, 0, numSamples);
+
+            auto* proc = step.node->getProcessor();
+            auto& stats = *step.stats;
+
+            // a node with silent input keeps running until its own output has decayed, then sleeps
+            // until signal returns; nodes without inputs (generators) are never suspended
+            const auto inputIsSilent = step.numInputs > 0
+                                        && (inputKnownSilent || isSilent (buffer, step.numInputs, numSamples));
+
+            if (! inputIsSilent)
+            {
+                stats.quietOutputSamples = 0;
+                stats.suspended.store (false, std::memory_order_relaxed);
+            }
+            else if (stats.suspended.load (std::memory_order_relaxed))
+            {
+                // a footswitch is still followed while the node sleeps
+                if (step.bypassable != nullptr)
+                    step.bypassable->isBypassedForRendering();
+
+                buffer.clear (0, numSamples);
+                step.midi.clear();
+                step.outputSilent = true;
+
+                const auto elapsed = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+                stats.addMeasurement (elapsed * 1.0e6);
+                return;
+            }
+
+            const ScopedLock sl (proc->getCallbackLock());
+
+            auto process = [&] (auto& view)
+            {
+                if (proc->isSuspended())
+                    view.clear();
+                else if (step.bypassable != nullptr && proc->getLatencySamples() == 0)
+                    processBypassable (plan, stepIndex, view);
+                else if (step.node->isBypassed())
+                    proc->processBlockBypassed (view, step.midi);
+                else
+                    proc->processBlock (view, step.midi);
+
+                step.midi.clear();
+            };
+
+            if (isDouble && ! step.processInDouble)
+            {
+                for (int ch = 0; ch < step.numChannels; ++ch)
+                    for (int n = 0; n < numSamples; ++n)
+                        step.floatBuffer.setSample (ch, n, (float) buffer.getSample (ch, n));
+
+                AudioBuffer<float> view (step.floatBuffer.getArrayOfWritePointers(), step.numChannels, numSamples);
+                process (view);
+
+                for (int ch = 0; ch < step.numChannels; ++ch)
+                    for (int n = 0; n < numSamples; ++n)
+                        buffer.setSample (ch, n, (FloatType) step.floatBuffer.getSample (ch, n));
+            }
+            else
+            {
+                AudioBuffer<FloatType> view (buffer.getArrayOfWritePointers(), step.numChannels, numSamples);
+                process (view);
+            }
+
+            if (inputIsSilent && hasStayedQuiet (stats.quietOutputSamples, isSilent (buffer, step.numOutputs, numSamples),
+                                                 numSamples, step.silenceHangover))
+                stats.suspended.store (true, std::memory_order_relaxed);
+        }
+    }
+
+    const auto elapsed = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+    step.stats->addMeasurement (elapsed * 1.0e6);
+}
+
+template <typename FloatType>
+void GraphRenderer::processBypassable (RenderPlan& plan, int stepIndex, AudioBuffer<FloatType>& io)
+{
+    using Stats = NodeStats;
+
+    auto& step = plan.steps[(size_t) stepIndex];
+    auto& stats = *step.stats;
+    auto* proc = step.node->getProcessor();
+    auto& bypassable = *step.bypassable;
+
+    const auto numChannels = io.getNumChannels();
+    const auto numSamples = io.getNumSamples();
+
+    auto& scratchBuffer = [&]() -> AudioBuffer<FloatType>&
+    {
+        if constexpr (std::is_same_v<FloatType, double>)
+            return step.doubleScratch;
+        else
+            return step.floatScratch;
+    }();
+
+    AudioBuffer<FloatType> scratch (scratchBuffer.getArrayOfWritePointers(), numChannels, numSamples);
+
+    auto copyToScratch = [&]
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            scratch.copyFrom (ch, 0, io, ch, 0, numSamples);
+    };
+
+    // the scratch buffer's share of the output goes from startGain to endGain over the block
+    auto mixWithScratch = [&] (FloatType startGain, FloatType endGain)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            io.applyGainRamp (ch, 0, numSamples, (FloatType) 1 - startGain, (FloatType) 1 - endGain);
+            io.addFromWithRamp (ch, 0, scratch.getReadPointer (ch), numSamples, startGain, endGain);
+        }
+    };
+
+    // asked every block, so that a footswitch keeps being read while the node is skipped
+    const auto wantsBypass = bypassable.isBypassedForRendering() || step.node->isBypassed();
+    auto state = stats.bypassState.load (std::memory_order_relaxed);
+
+    if (! wantsBypass)
+    {
+        if (state == Stats::idle)
+        {
+            // fade back in from the dry signal that was passing through
+            copyToScratch();
+            proc->processBlock (io, step.midi);
+            mixWithScratch (1, 0);
+        }
+        else
+        {
+            proc->processBlock (io, step.midi);
+        }
+
+        stats.bypassState.store (Stats::active, std::memory_order_relaxed);
+        return;
+    }
+
+    if (state == Stats::active)
+    {
+        if (plan.bypassSpillover && step.tailSamples > 0)
+        {
+            state = Stats::ringing;
+            stats.quietTailSamples = 0;
+        }
+        else
+        {
+            // fade out to the dry signal; an effect that can't render past its bypass just switches
+            copyToScratch();
+
+            if (bypassable.processIgnoringBypass (io))
+                mixWithScratch (0, 1);
+
+            state = Stats::idle;
+        }
+    }
+
+    if (state == Stats::ringing)
+    {
+        // the tail is the effect's response to silence, on top of the dry signal
+        scratch.clear();
+
+        if (bypassable.processIgnoringBypass (scratch))
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+                io.addFrom (ch, 0, scratch, ch, 0, numSamples);
+
+            if (hasStayedQuiet (stats.quietTailSamples, isSilent (scratch, numChannels, numSamples), numSamples, step.tailSamples))
+                state = Stats::idle;
+        }
+        else
+        {
+            state = Stats::idle;
+        }
+    }
+
+    // idle: the processor isn't called at all and the gathered input passes through
+    stats.bypassState.store (state, std::memory_order_relaxed);
+}
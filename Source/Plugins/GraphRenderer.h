@@ -0,0 +1,277 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE framework.
+   Copyright (c) Raw Material Software Limited
+
+   JUCE is an open source framework subject to commercial or open source
+   licensing.
+
+   By downloading, installing, or using the JUCE framework, or combining the
+   JUCE framework with any other source code, object code, content or any other
+   copyrightable work, you agree to the terms of the JUCE End User Licence
+   Agreement, and all incorporated terms including the JUCE Privacy Policy and
+   the JUCE Website Terms of Service, as applicable, which will bind you. If you
+   do not agree to the terms of these agreements, we will not license the JUCE
+   framework to you, and you must discontinue the installation or download
+   process and cease use of the JUCE framework.
+
+   JUCE End User Licence Agreement: https://juce.com/legal/juce-8-licence/
+   JUCE Privacy Policy: https://juce.com/juce-privacy-policy
+   JUCE Website Terms of Service: https://juce.com/juce-website-terms-of-service/
+
+   Or:
+
+   You may also use this code under the terms of the AGPLv3:
+   https://www.gnu.org/licenses/agpl-3.0.en.html
+
+   THE JUCE FRAMEWORK IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL
+   WARRANTIES, WHETHER EXPRESSED OR IMPLIED, INCLUDING WARRANTY OF
+   MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+//==============================================================================
+/**
+    Renders an AudioProcessorGraph in place of the graph's own serial render
+    sequence, so that independent branches can run on several cores.
+
+    Whenever the graph's topology changes, the nodes are flattened on the message
+    thread into a render plan: steps are sorted into topological levels, each
+    step owns its output buffer, and connections that need delay compensation
+    get their own delay line. The plan is handed to the audio thread without
+    locking it, and retired plans are freed back on the message thread.
+
+    On the audio thread every level is either run inline by the callback thread
+    or, when it holds enough independent work, shared with a pool of pinned
+    real-time workers. The workers take steps from their own slice of the level
+    first and then steal from the others; the callback thread joins in as one
+    more worker. Levels whose measured cost is too small to be worth the
+    hand-off fall back to serial execution.
+
+    Serial chains give the level scheduler nothing to share, so they can
+    optionally be pipelined instead: the levels are cut into up to four stages
+    at points chosen from the measured node costs, each stage runs on its own
+    core one block behind the previous one, and the stages hand their audio over
+    through lock-free triple buffers. This trades one block of extra latency per
+    stage for throughput and is therefore off unless asked for.
+
+    When a whole new set of nodes replaces the old one (loading a preset), the
+    new plan can be faded in: for the length of the crossfade both plans are
+    rendered and mixed on the audio thread, then the old one is retired and its
+    nodes are freed on the message thread.
+
+    A node whose processor reports a bypass through BypassableProcessor is not
+    called at all while it is bypassed: after fading out it is skipped and its
+    input passes straight through. With the optional spillover, an effect with a
+    tail keeps being rendered from silent input on top of the dry signal until
+    its tail has decayed, and only then goes idle.
+
+    Silence is tracked the same way: a node whose input has stayed below -90 dB
+    keeps running until its own output has decayed too (for at least its tail
+    length plus latency), and is then suspended until signal returns. Its output
+    is cleared, which lets the nodes downstream skip looking at their input.
+
+    The graph itself is never prepared; this class prepares the node processors.
+*/
+class GraphRenderer final : public AudioProcessor,
+                            private ChangeListener,
+                            private Timer
+{
+public:
+    //==============================================================================
+    explicit GraphRenderer (AudioProcessorGraph&);
+    ~GraphRenderer() override;
+
+    //==============================================================================
+    /** Re-flattens the graph. Called automatically when the topology changes.
+
+        A crossfade is only used when the new plan shares no node with the one
+        it replaces and neither is pipelined; otherwise the switch is immediate.
+        A plain rebuild of the same nodes keeps a crossfade that is still pending.
+    */
+    void rebuild (double crossfadeSeconds = 0.0);
+
+    /** Prepares a processor the way the renderer would, so that this can be
+        done on a loader thread before the node is added to the graph.
+    */
+    static void prepareProcessor (AudioProcessor&, double sampleRate, int blockSize, ProcessingPrecision);
+
+    /** Takes over a node that was prepared with prepareProcessor(). If the
+        settings no longer match, the node is prepared again when needed.
+    */
+    void adoptPreparedNode (AudioProcessorGraph::Node::Ptr, double sampleRate, int blockSize, ProcessingPrecision);
+
+    void setParallelRenderingEnabled (bool shouldBeEnabled) noexcept;
+    bool isParallelRenderingEnabled() const noexcept;
+
+    /** Opt-in: splits the graph into stages that run on separate cores, each
+        adding one block of latency. Rebuilds the plan when changed.
+    */
+    void setPipelinedRenderingEnabled (bool shouldBeEnabled);
+    bool isPipelinedRenderingEnabled() const noexcept;
+
+    /** Opt-in: lets a bypassed effect's tail ring out instead of cutting it
+        off. Rebuilds the plan when changed.
+    */
+    void setBypassSpilloverEnabled (bool shouldBeEnabled);
+    bool isBypassSpilloverEnabled() const noexcept;
+
+    /** The number of pipeline stages in the current plan, or 1 when not pipelined. */
+    int getNumPipelineStages() const noexcept;
+
+    /** The latency that pipelining adds on top of the graph's own, in samples. */
+    int getPipelineLatencySamples() const noexcept;
+
+    /** How often the last pipeline stage hadn't finished its block when the
+        callback came to pick it up, so that a block was repeated. Stays at
+        zero as long as every stage fits into one block.
+    */
+    int getNumPipelineOverruns() const noexcept;
+
+    /** Receives a call on the audio thread at the start of every block, before
+        any node is rendered.
+    */
+    struct BlockStartListener
+    {
+        virtual ~BlockStartListener() = default;
+        virtual void renderBlockStarting() = 0;
+    };
+
+    void setBlockStartListener (BlockStartListener*) noexcept;
+
+    /** Implemented by node processors that can report their own bypass state, so
+        that a bypassed node can be skipped instead of being called only to pass
+        its input through. Nodes that report latency are always rendered, to keep
+        the delay compensation of the other paths lined up.
+    */
+    struct BypassableProcessor
+    {
+        virtual ~BypassableProcessor() = default;
+
+        /** Called on the audio thread once per block, whether the node is skipped or not. */
+        virtual bool isBypassedForRendering() = 0;
+
+        /** Renders the effect as if it were not bypassed, for the fade-out and for
+            the tail. Returns false, leaving the buffer untouched, if it can't.
+        */
+        virtual bool processIgnoringBypass (AudioBuffer<float>&) = 0;
+        virtual bool processIgnoringBypass (AudioBuffer<double>&) = 0;
+    };
+
+    /** The number of worker threads besides the audio callback thread. */
+    int getNumWorkers() const noexcept;
+
+    /** Running average of a node's processing time per block, in microseconds. */
+    float getAverageNodeCostMicros (AudioProcessorGraph::NodeID) const;
+
+    enum class NodeActivity
+    {
+        processing,
+        ringingOut,     // bypassed, but its tail is still being rendered
+        bypassed,       // skipped while bypassed
+        silent          // suspended until its input carries signal again
+    };
+
+    /** What the renderer last did with a node; may lag by one block. */
+    NodeActivity getNodeActivity (AudioProcessorGraph::NodeID) const;
+
+    /** The latency from the graph's input to a node's output in the current plan,
+        including the compensation delays in front of it, in samples. The total,
+        including pipelining, is getLatencySamples().
+    */
+    int getNodeLatencyAtOutput (AudioProcessorGraph::NodeID) const;
+
+    //==============================================================================
+    const String getName() const override                   { return "Graph Renderer"; }
+    void prepareToPlay (double, int) override;
+    void releaseResources() override;
+
+    void processBlock (AudioBuffer<float>&, MidiBuffer&) override;
+    void processBlock (AudioBuffer<double>&, MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
+
+    double getTailLengthSeconds() const override            { return 0.0; }
+    bool acceptsMidi() const override                       { return false; }
+    bool producesMidi() const override                      { return false; }
+
+    bool hasEditor() const override                         { return false; }
+    AudioProcessorEditor* createEditor() override           { return nullptr; }
+
+    int getNumPrograms() override                           { return 1; }
+    int getCurrentProgram() override                        { return 0; }
+    void setCurrentProgram (int) override                   {}
+    const String getProgramName (int) override              { return {}; }
+    void changeProgramName (int, const String&) override    {}
+
+    void getStateInformation (MemoryBlock&) override        {}
+    void setStateInformation (const void*, int) override    {}
+
+private:
+    //==============================================================================
+    struct NodeStats;
+    struct RenderPlan;
+    class WorkerPool;
+
+    AudioProcessorGraph& graph;
+
+    std::map<uint32, std::shared_ptr<NodeStats>> nodeStats;
+    std::vector<AudioProcessorGraph::Node::Ptr> preparedNodes;
+    bool isPrepared = false;
+    ProcessingPrecision preparedPrecision = singlePrecision;
+
+    std::unique_ptr<WorkerPool> workerPool;
+    std::atomic<bool> parallelRenderingEnabled { true };
+    bool pipelinedRenderingEnabled = false;
+    bool pipelineNeedsMeasuredCosts = false;
+    bool bypassSpilloverEnabled = false;
+    std::atomic<int> numPipelineStages { 1 }, pipelineLatency { 0 }, pipelineOverruns { 0 };
+    std::atomic<BlockStartListener*> blockStartListener { nullptr };
+
+    // the audio thread owns activePlan; pendingPlan and retiredPlan are exchanged under planLock,
+    // and fadingPlan (the outgoing plan of a crossfade) only changes under it
+    SpinLock planLock;
+    std::unique_ptr<RenderPlan> activePlan, pendingPlan, retiredPlan, fadingPlan;
+    int fadePosition = 0;
+
+    //==============================================================================
+    std::unique_ptr<RenderPlan> createPlan();
+    void createPipeline (RenderPlan&);
+    void planCreated (const RenderPlan&);
+    void prepareNode (AudioProcessorGraph::Node&);
+    void releaseNodes();
+    std::shared_ptr<NodeStats> getStatsFor (AudioProcessorGraph::NodeID);
+
+    template <typename FloatType>
+    void processBlockImpl (AudioBuffer<FloatType>&);
+
+    template <typename FloatType>
+    void renderChunk (RenderPlan&, AudioBuffer<FloatType>&, int startSample, int numSamples);
+
+    template <typename FloatType>
+    void renderCrossfadeChunk (AudioBuffer<FloatType>&, int startSample, int numSamples);
+
+    template <typename FloatType>
+    void renderPipelinedChunk (RenderPlan&, AudioBuffer<FloatType>&, int startSample, int numSamples);
+
+    void runLevel (RenderPlan&, int levelIndex);
+    static void runStep (RenderPlan&, int stepIndex, int numSamples);
+    static void runPipelineStage (RenderPlan&, int stageIndex);
+
+    template <typename FloatType>
+    static void runStepImpl (RenderPlan&, int stepIndex, int numSamples);
+
+    template <typename FloatType>
+    static void processBypassable (RenderPlan&, int stepIndex, AudioBuffer<FloatType>&);
+
+    template <typename FloatType>
+    static void runPipelineStageImpl (RenderPlan&, int stageIndex, int numSamples);
+
+    void changeListenerCallback (ChangeBroadcaster*) override;
+    void timerCallback() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GraphRenderer)
+};
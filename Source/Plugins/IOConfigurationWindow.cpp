@@ -468,20 +468,20 @@ IOConfigurationWindow::IOConfigurationWindow (AudioProcessor& p)
 
 IOConfigurationWindow::~IOConfigurationWindow()
 {
-    if (auto* graph = getGraph())
+    if (auto* renderer = getRenderer())
     {
         if (auto* p = getAudioProcessor())
         {
-            ScopedLock renderLock (graph->getCallbackLock());
+            ScopedLock renderLock (renderer->getCallbackLock());
 
-            graph->suspendProcessing (true);
-            graph->releaseResources();
+            renderer->suspendProcessing (true);
+            renderer->releaseResources();
 
-            p->prepareToPlay (graph->getSampleRate(), graph->getBlockSize());
+            // re-preparing the renderer prepares every node again with its new layout
             p->suspendProcessing (false);
 
-            graph->prepareToPlay (graph->getSampleRate(), graph->getBlockSize());
-            graph->suspendProcessing (false);
+            renderer->prepareToPlay (renderer->getSampleRate(), renderer->getBlockSize());
+            renderer->suspendProcessing (false);
         }
     }
 }
@@ -547,6 +547,15 @@ GraphDocumentComponent* IOConfigurationWindow::getGraphEditor() const
     return nullptr;
 }
 
+GraphRenderer* IOConfigurationWindow::getRenderer() const
+{
+    if (auto* graphEditor = getGraphEditor())
+        if (auto* panel = graphEditor->graph.get())
+            return &panel->renderer;
+
+    return nullptr;
+}
+
 AudioProcessorGraph* IOConfigurationWindow::getGraph() const
 {
     if (auto* graphEditor = getGraphEditor())
@@ -36,6 +36,7 @@
 
 class MainHostWindow;
 class GraphDocumentComponent;
+class GraphRenderer;
 
 
 //==============================================================================
@@ -62,6 +63,7 @@ private:
     MainHostWindow* getMainWindow() const;
     GraphDocumentComponent* getGraphEditor() const;
     AudioProcessorGraph* getGraph() const;
+    GraphRenderer* getRenderer() const;
     AudioProcessorGraph::NodeID getNodeID() const;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (IOConfigurationWindow)
@@ -38,6 +38,7 @@
 
 #include "InternalPlugins.h"
 #include "PluginGraph.h"
+#include "ControlLatencyMeter.h"
 
 #include "./Fx/RatDistortion.h"
 #include "./Fx/BigMuffFuzz.h"
@@ -50,11 +51,113 @@
 
 
 //==============================================================================
-class InternalPlugin final : public AudioPluginInstance
+/** Keeps the Fx processors of deleted internal plug-ins, reset to their defaults
+    and still prepared, so that a new plug-in of the same type with the same
+    settings can take one over instead of constructing and allocating its own.
+    Never used on the audio thread.
+*/
+class InternalProcessorPool
+{
+public:
+    struct Prepared
+    {
+        std::unique_ptr<AudioProcessor> processor;
+        double sampleRate = 0.0;
+        int blockSize = 0;
+        AudioProcessor::ProcessingPrecision precision = AudioProcessor::singlePrecision;
+    };
+
+    /** Resets and prepares the processor on the pool's own thread, then keeps it.
+        The last reference to a node can be dropped anywhere, e.g. when the renderer
+        frees a retired plan, so the deleting thread doesn't do this work itself.
+    */
+    void recycle (Prepared p)
+    {
+        recycler.addJob (new RecycleJob (*this, std::move (p)), true);
+    }
+
+    std::optional<Prepared> take (const String& name, double sampleRate, int blockSize)
+    {
+        const ScopedLock sl (lock);
+
+        const auto it = std::find_if (entries.begin(), entries.end(), [&] (const Prepared& e)
+        {
+            return e.sampleRate == sampleRate
+                && e.blockSize == blockSize
+                && name.equalsIgnoreCase (e.processor->getName());
+        });
+
+        if (it == entries.end())
+            return {};
+
+        auto result = std::move (*it);
+        entries.erase (it);
+        return result;
+    }
+
+private:
+    class RecycleJob final : public ThreadPoolJob
+    {
+    public:
+        RecycleJob (InternalProcessorPool& o, Prepared p)
+            : ThreadPoolJob ("Recycle " + p.processor->getName()),
+              owner (o),
+              prepared (std::move (p))
+        {}
+
+        JobStatus runJob() override
+        {
+            auto& processor = *prepared.processor;
+
+            // back to the state of a new instance: default parameters and cleared DSP state.
+            // Preparing again with the same settings reuses the buffers that are already there.
+            for (auto* parameter : processor.getParameters())
+                parameter->setValue (parameter->getDefaultValue());
+
+            processor.prepareToPlay (prepared.sampleRate, prepared.blockSize);
+
+            owner.add (std::move (prepared));
+            return jobHasFinished;
+        }
+
+    private:
+        InternalProcessorPool& owner;
+        Prepared prepared;
+    };
+
+    void add (Prepared p)
+    {
+        const ScopedLock sl (lock);
+
+        const auto name = p.processor->getName();
+        const auto numOfType = std::count_if (entries.begin(), entries.end(),
+                                              [&] (const Prepared& e) { return e.processor->getName() == name; });
+
+        if (numOfType < maxPerType)
+            entries.push_back (std::move (p));
+    }
+
+    static constexpr std::ptrdiff_t maxPerType = 4;
+
+    CriticalSection lock;
+    std::vector<Prepared> entries;
+
+    // declared last, so that it is stopped before the entries go
+    ThreadPool recycler { ThreadPoolOptions{}.withThreadName ("Fx recycler")
+                                             .withNumberOfThreads (1)
+                                             .withDesiredThreadPriority (Thread::Priority::low) };
+};
+
+//==============================================================================
+class InternalPlugin final : public AudioPluginInstance,
+                             public GraphRenderer::BypassableProcessor,
+                             private AudioProcessorListener
 {
 public:
-    explicit InternalPlugin (std::unique_ptr<AudioProcessor> innerIn)
-        : inner (std::move (innerIn))
+    explicit InternalPlugin (std::unique_ptr<AudioProcessor> innerIn,
+                             std::shared_ptr<InternalProcessorPool> poolIn = {})
+        : inner (std::move (innerIn)),
+          pool (std::move (poolIn))
     {
         jassert (inner != nullptr);
 
@@ -62,6 +165,36 @@ public:
             matchChannels (isInput);
 
         setBusesLayout (inner->getBusesLayout());
+        setLatencySamples (inner->getLatencySamples());
+        initialLayout = inner->getBusesLayout();
+
+        innerBypass = dynamic_cast<AudioParameterBool*> (inner->getBypassParameter());
+        tailRenderer = dynamic_cast<FxCommon::TailRenderer*> (inner.get());
+
+        // Some Fx change their latency at runtime (e.g. the PitchShifter's FFT size),
+        // so keep the wrapper's reported latency in sync for the graph's compensation.
+        inner->addListener (this);
+    }
+
+    /** Takes over a processor from the pool, which is already reset and prepared. */
+    InternalPlugin (InternalProcessorPool::Prepared recycled, std::shared_ptr<InternalProcessorPool> poolIn)
+        : InternalPlugin (std::move (recycled.processor), std::move (poolIn))
+    {
+        preparedRate = recycled.sampleRate;
+        preparedBlockSize = recycled.blockSize;
+        preparedPrecision = recycled.precision;
+        innerIsReset = true;
+    }
+
+    ~InternalPlugin() override
+    {
+        inner->removeListener (this);
+
+        // a recycled processor keeps its address, which is its runtime ID
+        FxCommon::forgetRuntimeNode (inner.get());
+
+        if (pool != nullptr && preparedRate > 0.0 && inner->getBusesLayout() == initialLayout)
+            pool->recycle ({ std::move (inner), preparedRate, preparedBlockSize, preparedPrecision });
     }
 
     //==============================================================================
@@ -88,12 +221,29 @@ public:
 
     void prepareToPlay (double sr, int bs) override
     {
+        const auto canSkip = innerIsReset
+                              && sr == preparedRate
+                              && bs == preparedBlockSize
+                              && getProcessingPrecision() == preparedPrecision;
+
         inner->setProcessingPrecision (getProcessingPrecision());
         inner->setRateAndBufferSizeDetails (sr, bs);
-        inner->prepareToPlay (sr, bs);
+
+        if (! canSkip)
+            inner->prepareToPlay (sr, bs);
+
+        innerIsReset = false;
+        preparedRate = sr;
+        preparedBlockSize = bs;
+        preparedPrecision = getProcessingPrecision();
+        setLatencySamples (inner->getLatencySamples());
     }
 
-    void releaseResources() override                                              { inner->releaseResources(); }
+    void releaseResources() override
+    {
+        inner->releaseResources();
+        preparedRate = 0.0;
+    }
     void memoryWarningReceived() override                                         { inner->memoryWarningReceived(); }
 
     // MIDI removed: incoming MidiBuffer is ignored and not forwarded to inner
@@ -118,6 +268,27 @@ public:
         inner->processBlockBypassed (a, emptyMidi);
     }
 
+    AudioProcessorParameter* getBypassParameter() const override                  { return inner->getBypassParameter(); }
+
+    //==============================================================================
+    // the footswitch mapping is resolved here too, so a skipped Fx still follows its switch
+    bool isBypassedForRendering() override
+    {
+        const auto bypassed = FxCommon::applyMappedBypassFromHardware (inner.get(), innerBypass);
+
+        // the audio thread is where a footswitch press finally changes the sound
+        if (lastRenderedBypass >= 0 && bypassed != (lastRenderedBypass != 0))
+            ControlLatencyMeter::getInstance().changeTookEffect (ControlLatencyMeter::Path::footswitchToBypass,
+                                                                 FxCommon::getHardwareSwitchChangeSeconds());
+
+        lastRenderedBypass = bypassed ? 1 : 0;
+        return bypassed;
+    }
+
+    bool processIgnoringBypass (AudioBuffer<float>& a) override                   { return processTail (a); }
+    bool processIgnoringBypass (AudioBuffer<double>& a) override                  { return processTail (a); }
+
+    //==============================================================================
     bool supportsDoublePrecisionProcessing() const override                       { return inner->supportsDoublePrecisionProcessing(); }
     bool supportsMPE() const override                                             { return false; } // MPE depends on MIDI  disable
     void reset() override                                                         { inner->reset(); }
@@ -140,7 +311,21 @@ public:
         description = getPluginDescription (*inner);
     }
 
+    AudioProcessor& getInnerProcessor() noexcept                                  { return *inner; }
+
+    /** The processor goes back to this pool when the plug-in is deleted. */
+    void setPool (std::shared_ptr<InternalProcessorPool> p)                       { pool = std::move (p); }
+
 private:
+    //==============================================================================
+    void audioProcessorParameterChanged (AudioProcessor*, int, float) override {}
+
+    void audioProcessorChanged (AudioProcessor*, const ChangeDetails& details) override
+    {
+        if (details.latencyChanged)
+            setLatencySamples (inner->getLatencySamples());
+    }
+
     static PluginDescription getPluginDescription (const AudioProcessor& proc)
     {
         const auto ins                  = proc.getTotalNumInputChannels();
@@ -167,6 +352,16 @@ private:
         return descr;
     }
 
+    template <typename FloatType>
+    bool processTail (AudioBuffer<FloatType>& a)
+    {
+        if (tailRenderer == nullptr)
+            return false;
+
+        tailRenderer->processIgnoringBypass (a);
+        return true;
+    }
+
     void matchChannels (bool isInput)
     {
         const auto inBuses = inner->getBusCount (isInput);
@@ -179,6 +374,17 @@ private:
     }
 
     std::unique_ptr<AudioProcessor> inner;
+    std::shared_ptr<InternalProcessorPool> pool;
+    BusesLayout initialLayout;
+    AudioParameterBool* innerBypass = nullptr;
+    int lastRenderedBypass = -1;
+    FxCommon::TailRenderer* tailRenderer = nullptr;
+
+    // what the inner processor was last prepared with, so that it can be pooled
+    double preparedRate = 0.0;
+    int preparedBlockSize = 0;
+    ProcessingPrecision preparedPrecision = singlePrecision;
+    bool innerIsReset = false;
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (InternalPlugin)
@@ -223,20 +429,30 @@ InternalPluginFormat::InternalPluginFormat()
         [] { return std::make_unique<InternalPlugin>(std::make_unique<Phase90Processor>()); },
         [] { return std::make_unique<InternalPlugin>(std::make_unique<ChromaticTuner>()); },
         [] { return std::make_unique<InternalPlugin>(std::make_unique<GainBoostProcessor>()); }
-    }
+    },
+    pool (std::make_shared<InternalProcessorPool>())
 {
 }
 
-std::unique_ptr<AudioPluginInstance> InternalPluginFormat::createInstance (const String& name)
+std::unique_ptr<AudioPluginInstance> InternalPluginFormat::createInstance (const String& name, double sampleRate, int blockSize)
 {
-    return factory.createInstance (name);
+    // a processor left over from a deleted node saves the construction and the allocations of prepareToPlay()
+    if (auto recycled = pool->take (name, sampleRate, blockSize))
+        return std::make_unique<InternalPlugin> (std::move (*recycled), pool);
+
+    auto instance = factory.createInstance (name);
+
+    if (auto* internal = dynamic_cast<InternalPlugin*> (instance.get()))
+        internal->setPool (pool);
+
+    return instance;
 }
 
 void InternalPluginFormat::createPluginInstance (const PluginDescription& desc,
-                                                 double /*initialSampleRate*/, int /*initialBufferSize*/,
+                                                 double initialSampleRate, int initialBufferSize,
                                                  PluginCreationCallback callback)
 {
-    if (auto p = createInstance (desc.name))
+    if (auto p = createInstance (desc.name, initialSampleRate, initialBufferSize))
         callback (std::move (p), {});
     else
         callback (nullptr, NEEDS_TRANS ("Invalid internal plugin name"));
@@ -251,3 +467,11 @@ const std::vector<PluginDescription>& InternalPluginFormat::getAllTypes() const
 {
     return factory.getDescriptions();
 }
+
+AudioProcessor& InternalPluginFormat::getProcessorWithParameters (AudioProcessor& processor)
+{
+    if (auto* internal = dynamic_cast<InternalPlugin*> (&processor))
+        return internal->getInnerProcessor();
+
+    return processor;
+}
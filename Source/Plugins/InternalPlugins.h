@@ -36,6 +36,7 @@
 
 #include "PluginGraph.h"
 
+class InternalProcessorPool;
 
 //==============================================================================
 /**
@@ -50,6 +51,17 @@ public:
     //==============================================================================
     const std::vector<PluginDescription>& getAllTypes() const;
 
+    /** Internal plug-ins wrap the actual Fx processor, which owns the parameters.
+        Returns that processor, or the given one for everything else.
+    */
+    static AudioProcessor& getProcessorWithParameters (AudioProcessor&);
+
+    /** Creates an internal plug-in on the calling thread, or returns nullptr for an
+        unknown name. Unlike createInstanceFromDescription(), this never waits for the
+        message thread, so a background thread can call it.
+    */
+    std::unique_ptr<AudioPluginInstance> createInstance (const String& name, double sampleRate, int blockSize);
+
     //==============================================================================
     static String getIdentifier()                                                       { return "Internal"; }
     String getName() const override                                                     { return getIdentifier(); }
@@ -85,9 +97,8 @@ private:
                                double initialSampleRate, int initialBufferSize,
                                PluginCreationCallback) override;
 
-    std::unique_ptr<AudioPluginInstance> createInstance (const String& name);
-
     bool requiresUnblockedMessageThreadDuringCreation (const PluginDescription&) const override;
 
     InternalPluginFactory factory;
+    std::shared_ptr<InternalProcessorPool> pool;
 };
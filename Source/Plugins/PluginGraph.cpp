@@ -35,6 +35,7 @@
 #include <JuceHeader.h>
 #include "../UI/MainHostWindow.h"
 #include "PluginGraph.h"
+#include "GraphJournal.h"
 #include "InternalPlugins.h"
 #include "../UI/GraphEditorPanel.h"
 
@@ -44,6 +45,118 @@ static std::unique_ptr<ScopedDPIAwarenessDisabler> makeDPIAwarenessDisablerForPl
                                         : nullptr;
 }
 
+static void restoreState (AudioProcessor& processor, const GraphDescription::Node& node)
+{
+    if (node.getStateSize() > 0)
+        processor.setStateInformation (node.getStateData(), (int) node.getStateSize());
+}
+
+static void readBusLayoutFromXml (AudioProcessor::BusesLayout&, AudioProcessor&, const XmlElement&, bool isInput);
+
+static void restoreBusLayout (AudioPluginInstance& instance, const GraphDescription::Node& node)
+{
+    if (node.layout == nullptr)
+        return;
+
+    auto layout = instance.getBusesLayout();
+
+    readBusLayoutFromXml (layout, instance, *node.layout, true);
+    readBusLayoutFromXml (layout, instance, *node.layout, false);
+
+    instance.setBusesLayout (layout);
+}
+
+//==============================================================================
+/** Creates, restores and prepares the internal plug-ins of a graph document on a
+    background thread. Other formats may need the message thread to create their
+    instances, so those are left to finishLoading(), which then swaps all the new
+    nodes into the graph at once.
+
+    The internal plug-ins are created through InternalPluginFormat directly: the
+    format manager would post the creation to the message thread and wait for it,
+    which deadlocks when the message thread is the one stopping the loader.
+*/
+class PluginGraph::PresetLoader final : private Thread,
+                                        private AsyncUpdater
+{
+public:
+    PresetLoader (PluginGraph& g, std::unique_ptr<GraphDescription> d)
+        : Thread ("Preset loader"),
+          owner (g),
+          document (std::move (d)),
+          sampleRate (g.renderer.getSampleRate()),
+          blockSize (g.renderer.getBlockSize()),
+          precision (g.renderer.getProcessingPrecision())
+    {
+        for (auto* format : g.formatManager.getFormats())
+            if (auto* internal = dynamic_cast<InternalPluginFormat*> (format))
+                internalFormat = internal;
+
+        for (auto& node : document->nodes)
+            nodes.push_back ({ &node, nullptr });
+
+        startThread (Thread::Priority::low);
+    }
+
+    ~PresetLoader() override
+    {
+        // run() never waits for the message thread, so this returns after the plug-in being created
+        stopThread (10000);
+        cancelPendingUpdate();
+    }
+
+    struct LoadedNode
+    {
+        const GraphDescription::Node* description = nullptr;
+
+        // already restored and prepared, or null if it is created on the message thread
+        std::unique_ptr<AudioPluginInstance> instance;
+    };
+
+    PluginGraph& owner;
+    const std::unique_ptr<GraphDescription> document;
+    const double sampleRate;
+    const int blockSize;
+    const AudioProcessor::ProcessingPrecision precision;
+    std::vector<LoadedNode> nodes;
+
+private:
+    void run() override
+    {
+        for (auto& n : nodes)
+        {
+            if (threadShouldExit())
+                return;
+
+            if (internalFormat == nullptr
+                || n.description->description.pluginFormatName != InternalPluginFormat::getIdentifier())
+                continue;
+
+            if (auto instance = internalFormat->createInstance (n.description->description.name, sampleRate, blockSize))
+            {
+                restoreBusLayout (*instance, *n.description);
+                restoreState (*instance, *n.description);
+
+                if (sampleRate > 0.0 && blockSize > 0)
+                    GraphRenderer::prepareProcessor (*instance, sampleRate, blockSize, precision);
+
+                n.instance = std::move (instance);
+            }
+        }
+
+        triggerAsyncUpdate();
+    }
+
+    void handleAsyncUpdate() override
+    {
+        owner.finishLoading();
+    }
+
+    InternalPluginFormat* internalFormat = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE (PresetLoader)
+};
+
 //==============================================================================
 PluginGraph::PluginGraph (AudioPluginFormatManager& fm, KnownPluginList& kpl)
     : FileBasedDocument (getFilenameSuffix(),
@@ -55,10 +168,20 @@ PluginGraph::PluginGraph (AudioPluginFormatManager& fm, KnownPluginList& kpl)
 {
     newDocument();
     graph.addListener (this);
+    renderer.setBlockStartListener (&snapshots);
 }
 
 PluginGraph::~PluginGraph()
 {
+    journal.reset();
+    presetLoader.reset();
+    renderer.setBlockStartListener (nullptr);
+    cancelPendingUpdate();
+
+    for (auto* node : graph.getNodes())
+        if (auto* p = node->getProcessor())
+            p->removeListener (this);
+
     graph.removeListener (this);
     graph.removeChangeListener (this);
     graph.clear();
@@ -79,6 +202,23 @@ void PluginGraph::changeListenerCallback (ChangeBroadcaster*)
             activePluginWindows.remove (i);
 }
 
+void PluginGraph::audioProcessorChanged (AudioProcessor* processor, const ChangeDetails& details)
+{
+    if (processor != &graph && details.latencyChanged)
+    {
+        // may arrive from prepareToPlay, so rebuild the render plan later on the message thread
+        triggerAsyncUpdate();
+        return;
+    }
+
+    changed();
+}
+
+void PluginGraph::handleAsyncUpdate()
+{
+    renderer.rebuild();
+}
+
 AudioProcessorGraph::Node::Ptr PluginGraph::getNodeForName (const String& name) const
 {
     for (auto* node : graph.getNodes())
@@ -94,8 +234,8 @@ void PluginGraph::addPlugin (const PluginDescriptionAndPreference& desc, Point<d
     std::shared_ptr<ScopedDPIAwarenessDisabler> dpiDisabler = makeDPIAwarenessDisablerForPlugin (desc.pluginDescription);
 
     formatManager.createPluginInstanceAsync (desc.pluginDescription,
-                                             graph.getSampleRate(),
-                                             graph.getBlockSize(),
+                                             renderer.getSampleRate(),
+                                             renderer.getBlockSize(),
                                              [this, pos, dpiDisabler, useARA = desc.useARA] (std::unique_ptr<AudioPluginInstance> instance, const String& error)
                                              {
                                                  addPluginCallback (std::move (instance), error, pos, useARA);
@@ -128,6 +268,9 @@ void PluginGraph::addPluginCallback (std::unique_ptr<AudioPluginInstance> instan
 
         if (auto node = graph.addNode (std::move (instance)))
         {
+            // watch the node so that runtime latency changes (e.g. a new FFT size) get compensated
+            node->getProcessor()->addListener (this);
+
             node->properties.set ("x", pos.x);
             node->properties.set ("y", pos.y);
             node->properties.set ("useARA", useARA == PluginDescriptionAndPreference::UseARA::yes);
@@ -157,8 +300,11 @@ Point<double> PluginGraph::getNodePosition (NodeID nodeID) const
 //==============================================================================
 void PluginGraph::clear()
 {
+    // a preset that is still loading must not be swapped in afterwards
+    presetLoader.reset();
     closeAnyOpenPluginWindows();
     graph.clear();
+    snapshots.clear();
     changed();
 }
 
@@ -258,31 +404,27 @@ void PluginGraph::newDocument()
 
 Result PluginGraph::loadDocument (const File& file)
 {
-    if (auto xml = parseXMLIfTagMatches (file, "FILTERGRAPH"))
-    {
-        graph.removeChangeListener (this);
-        restoreFromXml (*xml);
+    std::unique_ptr<GraphDescription> description;
 
-        MessageManager::callAsync ([this]
-        {
-            setChangedFlag (false);
-            graph.addChangeListener (this);
-        });
+    // older documents are XML, newer ones are binary
+    if (GraphDescription::isBinaryFile (file))
+        description = GraphDescription::loadBinary (file);
+    else if (auto xml = parseXMLIfTagMatches (file, "FILTERGRAPH"))
+        description = GraphDescription::fromXml (*xml);
 
-        return Result::ok();
-    }
+    if (description == nullptr)
+        return Result::fail ("Not a valid graph file");
 
-    return Result::fail ("Not a valid graph file");
+    // the change listener is added back once the loader has swapped in the new nodes
+    graph.removeChangeListener (this);
+    restoreAsync (std::move (description));
+
+    return Result::ok();
 }
 
 Result PluginGraph::saveDocument (const File& file)
 {
-    auto xml = createXml();
-
-    if (! xml->writeTo (file, {}))
-        return Result::fail ("Couldn't write to the file");
-
-    return Result::ok();
+    return createDescription()->saveBinary (file);
 }
 
 File PluginGraph::getLastDocumentOpened()
@@ -367,68 +509,44 @@ static XmlElement* createBusLayoutXml (const AudioProcessor::BusesLayout& layout
     return xml;
 }
 
-static XmlElement* createNodeXml (AudioProcessorGraph::Node* const node) noexcept
+static GraphDescription::Node createNodeDescription (AudioProcessorGraph::Node& node, AudioPluginInstance& plugin)
 {
-    if (auto* plugin = dynamic_cast<AudioPluginInstance*> (node->getProcessor()))
-    {
-        auto e = new XmlElement ("FILTER");
+    GraphDescription::Node d;
 
-        e->setAttribute ("uid",      (int) node->nodeID.uid);
-        e->setAttribute ("x",        node->properties ["x"].toString());
-        e->setAttribute ("y",        node->properties ["y"].toString());
-        e->setAttribute ("useARA",   node->properties ["useARA"].toString());
+    d.uid = node.nodeID.uid;
+    d.useARA = node.properties ["useARA"];
+    d.properties.set ("x", node.properties ["x"]);
+    d.properties.set ("y", node.properties ["y"]);
 
-        for (int i = 0; i < (int) PluginWindow::Type::numTypes; ++i)
-        {
-            auto type = (PluginWindow::Type) i;
-
-            if (node->properties.contains (PluginWindow::getOpenProp (type)))
-            {
-                e->setAttribute (PluginWindow::getLastXProp (type), node->properties[PluginWindow::getLastXProp (type)].toString());
-                e->setAttribute (PluginWindow::getLastYProp (type), node->properties[PluginWindow::getLastYProp (type)].toString());
-                e->setAttribute (PluginWindow::getOpenProp (type),  node->properties[PluginWindow::getOpenProp (type)].toString());
-            }
-        }
-
-        {
-            PluginDescription pd;
-            plugin->fillInPluginDescription (pd);
-            e->addChildElement (pd.createXml().release());
-        }
+    for (int i = 0; i < (int) PluginWindow::Type::numTypes; ++i)
+    {
+        auto type = (PluginWindow::Type) i;
 
+        if (node.properties.contains (PluginWindow::getOpenProp (type)))
         {
-            MemoryBlock m;
-            node->getProcessor()->getStateInformation (m);
-            e->createNewChildElement ("STATE")->addTextElement (m.toBase64Encoding());
+            d.properties.set (PluginWindow::getLastXProp (type), node.properties[PluginWindow::getLastXProp (type)]);
+            d.properties.set (PluginWindow::getLastYProp (type), node.properties[PluginWindow::getLastYProp (type)]);
+            d.properties.set (PluginWindow::getOpenProp (type),  node.properties[PluginWindow::getOpenProp (type)]);
         }
+    }
 
-        auto layout = plugin->getBusesLayout();
+    plugin.fillInPluginDescription (d.description);
+    plugin.getStateInformation (d.ownedState);
 
-        auto layouts = e->createNewChildElement ("LAYOUT");
-        layouts->addChildElement (createBusLayoutXml (layout, true));
-        layouts->addChildElement (createBusLayoutXml (layout, false));
+    auto layout = plugin.getBusesLayout();
 
-        return e;
-    }
+    d.layout = std::make_unique<XmlElement> ("LAYOUT");
+    d.layout->addChildElement (createBusLayoutXml (layout, true));
+    d.layout->addChildElement (createBusLayoutXml (layout, false));
 
-    jassertfalse;
-    return nullptr;
+    return d;
 }
 
-void PluginGraph::createNodeFromXml (const XmlElement& xml)
+std::unique_ptr<AudioPluginInstance> PluginGraph::createInstance (const GraphDescription::Node& node) const
 {
-    PluginDescriptionAndPreference pd;
-    const auto nodeUsesARA = xml.getBoolAttribute ("useARA");
-
-    for (auto* e : xml.getChildIterator())
-    {
-        if (pd.pluginDescription.loadFromXml (*e))
-        {
-            pd.useARA = nodeUsesARA ? PluginDescriptionAndPreference::UseARA::yes
-                                    : PluginDescriptionAndPreference::UseARA::no;
-            break;
-        }
-    }
+    PluginDescriptionAndPreference pd { node.description,
+                                        node.useARA ? PluginDescriptionAndPreference::UseARA::yes
+                                                    : PluginDescriptionAndPreference::UseARA::no };
 
     auto createInstanceWithFallback = [&]() -> std::unique_ptr<AudioPluginInstance>
     {
@@ -439,8 +557,8 @@ void PluginGraph::createNodeFromXml (const XmlElement& xml)
             auto localDpiDisabler = makeDPIAwarenessDisablerForPlugin (description.pluginDescription);
 
             auto instance = formatManager.createPluginInstance (description.pluginDescription,
-                                                                graph.getSampleRate(),
-                                                                graph.getBlockSize(),
+                                                                renderer.getSampleRate(),
+                                                                renderer.getBlockSize(),
                                                                 errorMessage);
 
            #if JUCE_PLUGINHOST_ARA && (JUCE_MAC || JUCE_WINDOWS || JUCE_LINUX)
@@ -475,92 +593,175 @@ void PluginGraph::createNodeFromXml (const XmlElement& xml)
         return createInstance (PluginDescriptionAndPreference { *matchingPlugin });
     };
 
-    if (auto instance = createInstanceWithFallback())
-    {
-        if (auto* layoutEntity = xml.getChildByName ("LAYOUT"))
-        {
-            auto layout = instance->getBusesLayout();
+    auto instance = createInstanceWithFallback();
 
-            readBusLayoutFromXml (layout, *instance, *layoutEntity, true);
-            readBusLayoutFromXml (layout, *instance, *layoutEntity, false);
+    if (instance != nullptr)
+        restoreBusLayout (*instance, node);
 
-            instance->setBusesLayout (layout);
-        }
+    return instance;
+}
 
-        if (auto node = graph.addNode (std::move (instance), NodeID ((uint32) xml.getIntAttribute ("uid"))))
-        {
-            if (auto* state = xml.getChildByName ("STATE"))
-            {
-                MemoryBlock m;
-                m.fromBase64Encoding (state->getAllSubText());
+AudioProcessorGraph::Node::Ptr PluginGraph::addNode (std::unique_ptr<AudioPluginInstance> instance,
+                                                    const GraphDescription::Node& description,
+                                                    bool restoreState)
+{
+    if (instance == nullptr)
+        return nullptr;
 
-                node->getProcessor()->setStateInformation (m.getData(), (int) m.getSize());
-            }
+    auto node = graph.addNode (std::move (instance), NodeID (description.uid));
+
+    if (node == nullptr)
+        return nullptr;
 
-            node->properties.set ("x", xml.getDoubleAttribute ("x"));
-            node->properties.set ("y", xml.getDoubleAttribute ("y"));
-            node->properties.set ("useARA", xml.getBoolAttribute ("useARA"));
+    node->getProcessor()->addListener (this);
 
-            for (int i = 0; i < (int) PluginWindow::Type::numTypes; ++i)
+    if (restoreState)
+        ::restoreState (*node->getProcessor(), description);
+
+    node->properties.set ("x", (double) description.properties.getWithDefault ("x", 0.0));
+    node->properties.set ("y", (double) description.properties.getWithDefault ("y", 0.0));
+    node->properties.set ("useARA", description.useARA);
+
+    for (int i = 0; i < (int) PluginWindow::Type::numTypes; ++i)
+    {
+        auto type = (PluginWindow::Type) i;
+
+        if (description.properties.contains (PluginWindow::getOpenProp (type)))
+        {
+            node->properties.set (PluginWindow::getLastXProp (type), (int) description.properties[PluginWindow::getLastXProp (type)]);
+            node->properties.set (PluginWindow::getLastYProp (type), (int) description.properties[PluginWindow::getLastYProp (type)]);
+            node->properties.set (PluginWindow::getOpenProp  (type), (int) description.properties[PluginWindow::getOpenProp (type)]);
+
+            if (node->properties[PluginWindow::getOpenProp (type)])
             {
-                auto type = (PluginWindow::Type) i;
-
-                if (xml.hasAttribute (PluginWindow::getOpenProp (type)))
-                {
-                    node->properties.set (PluginWindow::getLastXProp (type), xml.getIntAttribute (PluginWindow::getLastXProp (type)));
-                    node->properties.set (PluginWindow::getLastYProp (type), xml.getIntAttribute (PluginWindow::getLastYProp (type)));
-                    node->properties.set (PluginWindow::getOpenProp  (type), xml.getIntAttribute (PluginWindow::getOpenProp (type)));
-
-                    if (node->properties[PluginWindow::getOpenProp (type)])
-                    {
-                        jassert (node->getProcessor() != nullptr);
-
-                        if (auto w = getOrCreateWindowFor (node, type))
-                            w->toFront (true);
-                    }
-                }
+                jassert (node->getProcessor() != nullptr);
+
+                if (auto w = getOrCreateWindowFor (node.get(), type))
+                    w->toFront (true);
             }
         }
     }
+
+    return node;
 }
 
-std::unique_ptr<XmlElement> PluginGraph::createXml() const
+std::unique_ptr<GraphDescription> PluginGraph::createDescription() const
 {
-    auto xml = std::make_unique<XmlElement> ("FILTERGRAPH");
+    auto description = std::make_unique<GraphDescription>();
 
     for (auto* node : graph.getNodes())
-        xml->addChildElement (createNodeXml (node));
+    {
+        if (auto* plugin = dynamic_cast<AudioPluginInstance*> (node->getProcessor()))
+            description->nodes.push_back (createNodeDescription (*node, *plugin));
+        else
+            jassertfalse;
+    }
 
     for (auto& connection : graph.getConnections())
     {
-        auto e = xml->createNewChildElement ("CONNECTION");
-
-        e->setAttribute ("srcFilter", (int) connection.source.nodeID.uid);
-        e->setAttribute ("srcChannel", connection.source.channelIndex);
-        e->setAttribute ("dstFilter", (int) connection.destination.nodeID.uid);
-        e->setAttribute ("dstChannel", connection.destination.channelIndex);
+        description->connections.push_back ({ connection.source.nodeID.uid, connection.source.channelIndex,
+                                              connection.destination.nodeID.uid, connection.destination.channelIndex });
     }
 
-    return xml;
+    description->snapshots = snapshots.createXml();
+    return description;
 }
 
-void PluginGraph::restoreFromXml (const XmlElement& xml)
+void PluginGraph::restore (const GraphDescription& description)
 {
     clear();
 
-    for (auto* e : xml.getChildWithTagNameIterator ("FILTER"))
+    for (auto& node : description.nodes)
     {
-        createNodeFromXml (*e);
+        addNode (createInstance (node), node, true);
         changed();
     }
 
-    for (auto* e : xml.getChildWithTagNameIterator ("CONNECTION"))
+    addConnections (description);
+    snapshots.restoreFromXml (description.snapshots.get());
+}
+
+void PluginGraph::addConnections (const GraphDescription& description)
+{
+    for (auto& c : description.connections)
+        graph.addConnection ({ { NodeID (c.sourceNode), c.sourceChannel }, { NodeID (c.destNode), c.destChannel } });
+
+    graph.removeIllegalConnections();
+}
+
+void PluginGraph::restoreAsync (std::unique_ptr<GraphDescription> description)
+{
+    presetLoader.reset();
+    presetLoader = std::make_unique<PresetLoader> (*this, std::move (description));
+}
+
+std::unique_ptr<XmlElement> PluginGraph::createXml() const
+{
+    return createDescription()->toXml();
+}
+
+void PluginGraph::restoreFromXml (const XmlElement& xml)
+{
+    restore (*GraphDescription::fromXml (xml));
+}
+
+static double getPresetCrossfadeSeconds()
+{
+    if (auto* props = getAppProperties().getUserSettings())
+        return props->getIntValue ("presetCrossfadeMs", 25) / 1000.0;
+
+    return 0.0;
+}
+
+void PluginGraph::finishLoading()
+{
+    const auto loader = std::move (presetLoader);
+
+    // the active render plan keeps the old nodes alive and playing until the new plan has faded in
+    closeAnyOpenPluginWindows();
+    graph.clear();
+
+    for (auto& n : loader->nodes)
     {
-        graph.addConnection ({ { NodeID ((uint32) e->getIntAttribute ("srcFilter")), e->getIntAttribute ("srcChannel") },
-                               { NodeID ((uint32) e->getIntAttribute ("dstFilter")), e->getIntAttribute ("dstChannel") } });
+        if (n.instance == nullptr)
+        {
+            addNode (createInstance (*n.description), *n.description, true);
+        }
+        else if (auto node = addNode (std::move (n.instance), *n.description, false))
+        {
+            renderer.adoptPreparedNode (node, loader->sampleRate, loader->blockSize, loader->precision);
+        }
     }
 
-    graph.removeIllegalConnections();
+    addConnections (*loader->document);
+    snapshots.restoreFromXml (loader->document->snapshots.get());
+    renderer.rebuild (getPresetCrossfadeSeconds());
+    changed();
+
+    MessageManager::callAsync ([this]
+    {
+        setChangedFlag (false);
+        graph.addChangeListener (this);
+    });
+}
+
+//==============================================================================
+bool PluginGraph::startJournal (const File& journalFile)
+{
+    journal.reset();
+
+    const auto restored = GraphJournal::replay (*this, journalFile);
+    journal = std::make_unique<GraphJournal> (*this, journalFile);
+
+    return restored;
+}
+
+void PluginGraph::discardJournal()
+{
+    if (journal != nullptr)
+        journal->discard();
+
+    journal.reset();
 }
 
 File PluginGraph::getDefaultGraphDocumentOnMobile()
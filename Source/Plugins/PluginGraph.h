@@ -35,6 +35,11 @@
 #pragma once
 
 #include "../UI/PluginWindow.h"
+#include "GraphDescription.h"
+#include "GraphRenderer.h"
+#include "SnapshotBank.h"
+
+class GraphJournal;
 
 //==============================================================================
 /** A type that encapsulates a PluginDescription and some preferences regarding
@@ -66,7 +71,8 @@ struct PluginDescriptionAndPreference
 */
 class PluginGraph final : public FileBasedDocument,
                           public AudioProcessorListener,
-                          private ChangeListener
+                          private ChangeListener,
+                          private AsyncUpdater
 {
 public:
     //==============================================================================
@@ -93,9 +99,17 @@ public:
 
     //==============================================================================
     void audioProcessorParameterChanged (AudioProcessor*, int, float) override {}
-    void audioProcessorChanged (AudioProcessor*, const ChangeDetails&) override { changed(); }
+    void audioProcessorChanged (AudioProcessor*, const ChangeDetails&) override;
 
     //==============================================================================
+    std::unique_ptr<GraphDescription> createDescription() const;
+    void restore (const GraphDescription&);
+
+    /** Like restore(), but builds and prepares the new nodes on a background
+        thread and fades them in, so that the audio keeps running. Returns straight away.
+    */
+    void restoreAsync (std::unique_ptr<GraphDescription>);
+
     std::unique_ptr<XmlElement> createXml() const;
     void restoreFromXml (const XmlElement&);
 
@@ -112,9 +126,24 @@ public:
 
     static File getDefaultGraphDocumentOnMobile();
 
+    //==============================================================================
+    /** Starts the crash-safe autosave journal (see GraphJournal). If the last session
+        left a journal behind, the graph is restored from it first, and true is returned.
+    */
+    bool startJournal (const File& journalFile);
+
+    /** Stops the journal and deletes it; for a clean shutdown. */
+    void discardJournal();
+
     //==============================================================================
     AudioProcessorGraph graph;
 
+    /** Plays the graph (instead of the graph's own serial render sequence). */
+    GraphRenderer renderer { graph };
+
+    /** Parameter snapshots of this graph, saved with the document. */
+    SnapshotBank snapshots { graph };
+
 private:
     //==============================================================================
     AudioPluginFormatManager& formatManager;
@@ -125,12 +154,21 @@ private:
     NodeID lastUID;
     NodeID getNextUID() noexcept;
 
-    void createNodeFromXml (const XmlElement&);
+    class PresetLoader;
+    std::unique_ptr<PresetLoader> presetLoader;
+
+    std::unique_ptr<GraphJournal> journal;
+
+    std::unique_ptr<AudioPluginInstance> createInstance (const GraphDescription::Node&) const;
+    AudioProcessorGraph::Node::Ptr addNode (std::unique_ptr<AudioPluginInstance>, const GraphDescription::Node&, bool restoreState);
+    void addConnections (const GraphDescription&);
+    void finishLoading();
     void addPluginCallback (std::unique_ptr<AudioPluginInstance>,
                             const String& error,
                             Point<double>,
                             PluginDescriptionAndPreference::UseARA useARA);
     void changeListenerCallback (ChangeBroadcaster*) override;
+    void handleAsyncUpdate() override;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginGraph)
 };
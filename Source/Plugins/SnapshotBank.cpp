@@ -0,0 +1,350 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE framework.
+   Copyright (c) Raw Material Software Limited
+
+   JUCE is an open source framework subject to commercial or open source
+   licensing.
+
+   By downloading, installing, or using the JUCE framework, or combining the
+   JUCE framework with any other source code, object code, content or any other
+   copyrightable work, you agree to the terms of the JUCE End User Licence
+   Agreement, and all incorporated terms including the JUCE Privacy Policy and
+   the JUCE Website Terms of Service, as applicable, which will bind you. If you
+   do not agree to the terms of these agreements, we will not license the JUCE
+   framework to you, and you must discontinue the installation or download
+   process and cease use of the JUCE framework.
+
+   JUCE End User Licence Agreement: https://juce.com/legal/juce-8-licence/
+   JUCE Privacy Policy: https://juce.com/juce-privacy-policy
+   JUCE Website Terms of Service: https://juce.com/juce-website-terms-of-service/
+
+   Or:
+
+   You may also use this code under the terms of the AGPLv3:
+   https://www.gnu.org/licenses/agpl-3.0.en.html
+
+   THE JUCE FRAMEWORK IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL
+   WARRANTIES, WHETHER EXPRESSED OR IMPLIED, INCLUDING WARRANTY OF
+   MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+
+#include <JuceHeader.h>
+#include "SnapshotBank.h"
+#include "InternalPlugins.h"
+#include "ControlLatencyMeter.h"
+#include "Fx/FxCommon.h"
+
+//==============================================================================
+SnapshotBank::SnapshotBank (AudioProcessorGraph& g)
+    : graph (g)
+{
+    for (auto& s : stored)
+        s.store (false);
+
+    relayout();
+    graph.addChangeListener (this);
+}
+
+SnapshotBank::~SnapshotBank()
+{
+    graph.removeChangeListener (this);
+}
+
+//==============================================================================
+void SnapshotBank::changeListenerCallback (ChangeBroadcaster*)
+{
+    relayout();
+}
+
+void SnapshotBank::relayout()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    auto newLayout = std::make_unique<Layout>();
+
+    for (auto* node : graph.getNodes())
+    {
+        auto* proc = node->getProcessor();
+
+        if (proc == nullptr || dynamic_cast<AudioProcessorGraph::AudioGraphIOProcessor*> (proc) != nullptr)
+            continue;
+
+        newLayout->slots.push_back ({ node, nullptr, node->nodeID.uid, -1 });
+
+        const auto& parameters = InternalPluginFormat::getProcessorWithParameters (*proc).getParameters();
+
+        for (int i = 0; i < parameters.size(); ++i)
+            newLayout->slots.push_back ({ node, parameters.getUnchecked (i), node->nodeID.uid, i });
+    }
+
+    const auto numSlots = newLayout->slots.size();
+    newLayout->values.assign ((size_t) numSnapshots * numSlots, std::numeric_limits<float>::quiet_NaN());
+
+    // carry the captured values over for every slot that still exists
+    if (layout != nullptr && ! layout->slots.empty())
+    {
+        std::map<std::pair<uint32, int>, size_t> oldSlots;
+
+        for (size_t i = 0; i < layout->slots.size(); ++i)
+            oldSlots[{ layout->slots[i].nodeID, layout->slots[i].parameterIndex }] = i;
+
+        for (size_t i = 0; i < numSlots; ++i)
+        {
+            const auto it = oldSlots.find ({ newLayout->slots[i].nodeID, newLayout->slots[i].parameterIndex });
+
+            if (it == oldSlots.end())
+                continue;
+
+            for (int s = 0; s < numSnapshots; ++s)
+                newLayout->getSnapshot (s)[i] = layout->getSnapshot (s)[it->second];
+        }
+    }
+
+    {
+        const SpinLock::ScopedLockType sl (layoutLock);
+        std::swap (layout, newLayout);
+    }
+
+    // the old layout (and the last references to removed nodes) goes away here, on the message thread
+}
+
+//==============================================================================
+void SnapshotBank::store (int index)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (! isPositiveAndBelow (index, numSnapshots) || layout == nullptr)
+        return;
+
+    {
+        const SpinLock::ScopedLockType sl (layoutLock);
+        auto* values = layout->getSnapshot (index);
+
+        for (size_t i = 0; i < layout->slots.size(); ++i)
+        {
+            const auto& slot = layout->slots[i];
+            values[i] = slot.parameter != nullptr ? slot.parameter->getValue()
+                                                  : (slot.node->isBypassed() ? 1.0f : 0.0f);
+        }
+    }
+
+    stored[(size_t) index].store (true);
+}
+
+void SnapshotBank::erase (int index)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (! isPositiveAndBelow (index, numSnapshots) || layout == nullptr)
+        return;
+
+    stored[(size_t) index].store (false);
+
+    const SpinLock::ScopedLockType sl (layoutLock);
+    auto* values = layout->getSnapshot (index);
+    std::fill (values, values + layout->slots.size(), std::numeric_limits<float>::quiet_NaN());
+}
+
+void SnapshotBank::clear()
+{
+    for (int i = 0; i < numSnapshots; ++i)
+        erase (i);
+
+    lastRecalled.store (-1);
+}
+
+bool SnapshotBank::isStored (int index) const noexcept
+{
+    return isPositiveAndBelow (index, numSnapshots) && stored[(size_t) index].load();
+}
+
+//==============================================================================
+void SnapshotBank::recall (int index)
+{
+    if (isPositiveAndBelow (index, numSnapshots))
+        pushCommand (index);
+}
+
+void SnapshotBank::recallNext()
+{
+    pushCommand (nextStoredCommand);
+}
+
+void SnapshotBank::setFootswitch (int footswitchNumber) noexcept
+{
+    footswitch.store (jlimit (0, FxCommon::maxHardwareControls, footswitchNumber));
+}
+
+void SnapshotBank::pushCommand (int command)
+{
+    // several threads may queue recalls; only the audio thread reads the queue
+    const SpinLock::ScopedLockType sl (producerLock);
+    const auto scope = commandFifo.write (1);
+
+    if (scope.blockSize1 > 0)
+        commands[(size_t) scope.startIndex1] = command;
+}
+
+int SnapshotBank::findNextStored (int after) const noexcept
+{
+    for (int i = 1; i <= numSnapshots; ++i)
+    {
+        const auto candidate = (after + i + numSnapshots) % numSnapshots;
+
+        if (stored[(size_t) candidate].load())
+            return candidate;
+    }
+
+    return -1;
+}
+
+//==============================================================================
+void SnapshotBank::renderBlockStarting()
+{
+    if (const auto fs = footswitch.load (std::memory_order_relaxed); fs > 0)
+    {
+        const auto isDown = FxCommon::getHardwareSourceNormalised (FxCommon::ModulationSource::footswitch (fs - 1)) >= 0.5f;
+
+        if (isDown && ! footswitchWasDown)
+            ++pendingFootswitchSteps;
+
+        footswitchWasDown = isDown;
+    }
+
+    if (pendingFootswitchSteps == 0 && commandFifo.getNumReady() == 0)
+        return;
+
+    // if the message thread is busy with the layout, the commands simply wait for the next block
+    const SpinLock::ScopedTryLockType sl (layoutLock);
+
+    if (! sl.isLocked() || layout == nullptr)
+        return;
+
+    for (; pendingFootswitchSteps > 0; --pendingFootswitchSteps)
+    {
+        if (const auto next = findNextStored (lastRecalled.load()); next >= 0)
+        {
+            apply (*layout, next);
+            ControlLatencyMeter::getInstance().changeTookEffect (ControlLatencyMeter::Path::footswitchToSnapshot,
+                                                                 FxCommon::getHardwareSwitchChangeSeconds());
+        }
+    }
+
+    const auto numReady = commandFifo.getNumReady();
+    const auto scope = commandFifo.read (numReady);
+
+    auto run = [&] (int start, int size)
+    {
+        for (int i = start; i < start + size; ++i)
+        {
+            const auto command = commands[(size_t) i];
+            const auto index = command == nextStoredCommand ? findNextStored (lastRecalled.load()) : command;
+
+            if (index >= 0 && stored[(size_t) index].load())
+                apply (*layout, index);
+        }
+    };
+
+    run (scope.startIndex1, scope.blockSize1);
+    run (scope.startIndex2, scope.blockSize2);
+}
+
+void SnapshotBank::apply (Layout& l, int index)
+{
+    const auto* values = l.getSnapshot (index);
+
+    for (size_t i = 0; i < l.slots.size(); ++i)
+    {
+        const auto value = values[i];
+
+        if (std::isnan (value))
+            continue;
+
+        auto& slot = l.slots[i];
+
+        if (slot.parameter == nullptr)
+            slot.node->setBypassed (value >= 0.5f);
+        else if (slot.parameter->getValue() != value)
+            slot.parameter->setValueNotifyingHost (value);
+    }
+
+    lastRecalled.store (index);
+}
+
+//==============================================================================
+std::unique_ptr<XmlElement> SnapshotBank::createXml() const
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (layout == nullptr || std::none_of (stored.begin(), stored.end(), [] (const auto& s) { return s.load(); }))
+        return nullptr;
+
+    auto xml = std::make_unique<XmlElement> ("SNAPSHOTS");
+
+    for (int s = 0; s < numSnapshots; ++s)
+    {
+        if (! stored[(size_t) s].load())
+            continue;
+
+        auto* snapshot = xml->createNewChildElement ("SNAPSHOT");
+        snapshot->setAttribute ("index", s);
+
+        const auto* values = layout->getSnapshot (s);
+
+        for (size_t i = 0; i < layout->slots.size(); ++i)
+        {
+            if (std::isnan (values[i]))
+                continue;
+
+            auto* e = snapshot->createNewChildElement ("VALUE");
+            e->setAttribute ("node", (int) layout->slots[i].nodeID);
+            e->setAttribute ("parameter", layout->slots[i].parameterIndex);
+            e->setAttribute ("value", values[i]);
+        }
+    }
+
+    return xml;
+}
+
+void SnapshotBank::restoreFromXml (const XmlElement* xml)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    clear();
+    relayout();
+
+    if (xml == nullptr || layout == nullptr)
+        return;
+
+    std::map<std::pair<uint32, int>, size_t> slotIndices;
+
+    for (size_t i = 0; i < layout->slots.size(); ++i)
+        slotIndices[{ layout->slots[i].nodeID, layout->slots[i].parameterIndex }] = i;
+
+    const SpinLock::ScopedLockType sl (layoutLock);
+
+    for (auto* snapshot : xml->getChildWithTagNameIterator ("SNAPSHOT"))
+    {
+        const auto s = snapshot->getIntAttribute ("index", -1);
+
+        if (! isPositiveAndBelow (s, numSnapshots))
+            continue;
+
+        auto* values = layout->getSnapshot (s);
+
+        for (auto* e : snapshot->getChildWithTagNameIterator ("VALUE"))
+        {
+            const auto it = slotIndices.find ({ (uint32) e->getIntAttribute ("node"), e->getIntAttribute ("parameter", -1) });
+
+            if (it != slotIndices.end())
+                values[it->second] = (float) e->getDoubleAttribute ("value");
+        }
+
+        stored[(size_t) s].store (true);
+    }
+}
@@ -0,0 +1,140 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE framework.
+   Copyright (c) Raw Material Software Limited
+
+   JUCE is an open source framework subject to commercial or open source
+   licensing.
+
+   By downloading, installing, or using the JUCE framework, or combining the
+   JUCE framework with any other source code, object code, content or any other
+   copyrightable work, you agree to the terms of the JUCE End User Licence
+   Agreement, and all incorporated terms including the JUCE Privacy Policy and
+   the JUCE Website Terms of Service, as applicable, which will bind you. If you
+   do not agree to the terms of these agreements, we will not license the JUCE
+   framework to you, and you must discontinue the installation or download
+   process and cease use of the JUCE framework.
+
+   JUCE End User Licence Agreement: https://juce.com/legal/juce-8-licence/
+   JUCE Privacy Policy: https://juce.com/juce-privacy-policy
+   JUCE Website Terms of Service: https://juce.com/juce-website-terms-of-service/
+
+   Or:
+
+   You may also use this code under the terms of the AGPLv3:
+   https://www.gnu.org/licenses/agpl-3.0.en.html
+
+   THE JUCE FRAMEWORK IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL
+   WARRANTIES, WHETHER EXPRESSED OR IMPLIED, INCLUDING WARRANTY OF
+   MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+
+#pragma once
+
+#include "GraphRenderer.h"
+
+//==============================================================================
+/**
+    Up to 128 parameter snapshots of the current graph, for instant recall.
+
+    Every parameter of every node, plus the node's bypass state, gets a slot in
+    a layout that is rebuilt on the message thread whenever the graph changes.
+    The values of all snapshots live in one flat, preallocated array of
+    numSnapshots * numSlots floats, so nothing is allocated on recall.
+
+    Recalls can be requested from any thread. They go through a lock-free queue
+    and are applied by the audio thread at the start of the next block, writing
+    the values straight into the parameters rather than going through
+    setStateInformation().
+*/
+class SnapshotBank final : public GraphRenderer::BlockStartListener,
+                           private ChangeListener
+{
+public:
+    //==============================================================================
+    static constexpr int numSnapshots = 128;
+
+    explicit SnapshotBank (AudioProcessorGraph&);
+    ~SnapshotBank() override;
+
+    //==============================================================================
+    /** Captures the current parameter values and bypass states. Message thread only. */
+    void store (int index);
+    void erase (int index);
+    void clear();
+
+    bool isStored (int index) const noexcept;
+
+    /** Queues a recall to be applied at the start of the next block. */
+    void recall (int index);
+
+    /** Queues a recall of the next stored snapshot after the last recalled one. */
+    void recallNext();
+
+    /** The most recently applied snapshot, or -1. */
+    int getLastRecalled() const noexcept        { return lastRecalled.load(); }
+
+    /** A hardware footswitch (numbered from 1, or 0 for none) that steps through the stored snapshots. */
+    void setFootswitch (int footswitchNumber) noexcept;
+
+    //==============================================================================
+    /** Returns nullptr if no snapshot is stored. */
+    std::unique_ptr<XmlElement> createXml() const;
+
+    /** Restores from a SNAPSHOTS element (or clears the bank if there is none);
+        the nodes must already exist.
+    */
+    void restoreFromXml (const XmlElement* snapshotsXml);
+
+    //==============================================================================
+    void renderBlockStarting() override;
+
+private:
+    //==============================================================================
+    struct Slot
+    {
+        AudioProcessorGraph::Node::Ptr node;
+        AudioProcessorParameter* parameter = nullptr;   // nullptr for the node's bypass state
+        uint32 nodeID = 0;
+        int parameterIndex = -1;
+    };
+
+    struct Layout
+    {
+        std::vector<Slot> slots;
+        std::vector<float> values;                      // NaN: not captured, left alone on recall
+
+        float* getSnapshot (int index) noexcept     { return values.data() + (size_t) index * slots.size(); }
+    };
+
+    static constexpr int nextStoredCommand = -1;
+
+    AudioProcessorGraph& graph;
+
+    // the message thread writes the layout and values under this lock, the audio thread only tries it
+    SpinLock layoutLock;
+    std::unique_ptr<Layout> layout;
+    std::array<std::atomic<bool>, numSnapshots> stored;
+
+    SpinLock producerLock;
+    AbstractFifo commandFifo { 64 };
+    std::array<int, 64> commands {};
+
+    std::atomic<int> lastRecalled { -1 }, footswitch { 0 };
+    bool footswitchWasDown = false;
+    int pendingFootswitchSteps = 0;
+
+    //==============================================================================
+    void relayout();
+    void pushCommand (int);
+    void apply (Layout&, int index);
+    int findNextStored (int after) const noexcept;
+
+    void changeListenerCallback (ChangeBroadcaster*) override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SnapshotBank)
+};
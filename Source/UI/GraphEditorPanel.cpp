@@ -259,6 +259,9 @@ struct GraphEditorPanel::PluginComponent final : public Component,
             // Fixed for 800x480 touchscreen - larger font and component
             font = FontOptions { 18.0f, Font::bold };
             setSize (220, 150);
+
+            if (! isEssentialNode())
+                addAndMakeVisible (cpuMeter);
         }
 
         PluginComponent (const PluginComponent&) = delete;
@@ -400,6 +403,8 @@ struct GraphEditorPanel::PluginComponent final : public Component,
 
         void resized() override
         {
+            cpuMeter.setBounds (getLocalBounds().reduced (4, pinSize).removeFromBottom (16));
+
             if (auto f = graph.graph.getNodeForId (pluginID))
             {
                 if (auto* processor = f->getProcessor())
@@ -638,9 +643,52 @@ struct GraphEditorPanel::PluginComponent final : public Component,
             fileChooser->launchAsync (FileBrowserComponent::openMode | FileBrowserComponent::canSelectFiles, onChosen);
         }
 
+        //==============================================================================
+        /** The node's processing time per block, or why it currently isn't being processed. */
+        struct CpuMeter final : public Component,
+                                private Timer
+        {
+            CpuMeter (const GraphRenderer& r, AudioProcessorGraph::NodeID id)  : renderer (r), nodeID (id)
+            {
+                setInterceptsMouseClicks (false, false);
+                startTimer (250);
+            }
+
+            void paint (Graphics& g) override
+            {
+                g.setColour (findColour (TextEditor::textColourId).withAlpha (0.6f));
+                g.setFont (FontOptions (12.0f));
+                g.drawText (text, getLocalBounds(), Justification::centred, false);
+            }
+
+            void timerCallback() override
+            {
+                String newText;
+
+                switch (renderer.getNodeActivity (nodeID))
+                {
+                    case GraphRenderer::NodeActivity::silent:      newText = "silent"; break;
+                    case GraphRenderer::NodeActivity::bypassed:    newText = "bypassed"; break;
+                    case GraphRenderer::NodeActivity::ringingOut:  newText = "tail, " + String (roundToInt (renderer.getAverageNodeCostMicros (nodeID))) + " us"; break;
+                    case GraphRenderer::NodeActivity::processing:  newText = String (roundToInt (renderer.getAverageNodeCostMicros (nodeID))) + " us"; break;
+                }
+
+                if (newText != text)
+                {
+                    text = newText;
+                    repaint();
+                }
+            }
+
+            const GraphRenderer& renderer;
+            const AudioProcessorGraph::NodeID nodeID;
+            String text;
+        };
+
         GraphEditorPanel& panel;
         PluginGraph& graph;
         const AudioProcessorGraph::NodeID pluginID;
+        CpuMeter cpuMeter { graph.renderer, pluginID };
         OwnedArray<PinComponent> pins;
         int numInputs = 0, numOutputs = 0;
         // Fixed larger pin size for 800x480 touchscreen
@@ -1380,7 +1428,8 @@ void GraphEditorPanel::toggleDeleteMode()
 struct GraphDocumentComponent::TooltipBar final : public Component,
                                                   private Timer
 {
-    TooltipBar()
+    explicit TooltipBar (const GraphRenderer& r)
+        : renderer (r)
     {
         startTimer (100);
     }
@@ -1390,6 +1439,9 @@ struct GraphDocumentComponent::TooltipBar final : public Component,
         g.setFont (FontOptions ((float) getHeight() * 0.75f, Font::bold));
         g.setColour (Colours::black);
         g.drawFittedText (tip, 12, 0, getWidth() - 16, getHeight(), Justification::centredLeft, 1);
+
+        if (status.isNotEmpty())
+            g.drawFittedText (status, 12, 0, getWidth() - 24, getHeight(), Justification::centredRight, 1);
     }
 
     void timerCallback() override
@@ -1401,18 +1453,104 @@ struct GraphDocumentComponent::TooltipBar final : public Component,
                 if (! (underMouse->isMouseButtonDown() || underMouse->isCurrentlyBlockedByAnotherModalComponent()))
                     newTip = ttc->getTooltip();
 
-        if (newTip != tip)
+        String newStatus;
+        const auto numStages = renderer.getNumPipelineStages();
+
+        if (numStages > 1 && renderer.getSampleRate() > 0)
+            newStatus = "Pipelined: " + String (numStages) + " stages, +"
+                      + String (renderer.getPipelineLatencySamples() * 1000.0 / renderer.getSampleRate(), 1) + " ms";
+
+        if (numStages > 1 && renderer.getNumPipelineOverruns() > 0)
+            newStatus << ", " << renderer.getNumPipelineOverruns() << " overruns";
+
+        if (newTip != tip || newStatus != status)
         {
             tip = newTip;
+            status = newStatus;
             repaint();
         }
     }
 
-    String tip;
+    const GraphRenderer& renderer;
+    String tip, status;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TooltipBar)
 };
 
+//==============================================================================
+/** Selects one of the graph's snapshots to store or recall; follows footswitch recalls. */
+struct GraphDocumentComponent::SnapshotBar final : public Component,
+                                                   private Timer
+{
+    explicit SnapshotBar (SnapshotBank& b)
+        : bank (b)
+    {
+        for (auto* c : { &previousButton, &nextButton, &storeButton, &recallButton })
+            addAndMakeVisible (c);
+
+        addAndMakeVisible (label);
+        label.setJustificationType (Justification::centred);
+
+        previousButton.onClick = [this] { select (selected - 1); };
+        nextButton.onClick     = [this] { select (selected + 1); };
+        storeButton.onClick    = [this] { bank.store (selected); update(); };
+        recallButton.onClick   = [this] { bank.recall (selected); };
+
+        startTimer (100);
+        update();
+    }
+
+    void resized() override
+    {
+        auto r = getLocalBounds().reduced (2);
+
+        previousButton.setBounds (r.removeFromLeft (24));
+        label.setBounds (r.removeFromLeft (120));
+        nextButton.setBounds (r.removeFromLeft (24));
+        r.removeFromLeft (4);
+        storeButton.setBounds (r.removeFromLeft (56));
+        r.removeFromLeft (4);
+        recallButton.setBounds (r.removeFromLeft (56));
+    }
+
+    void timerCallback() override
+    {
+        const auto recalled = bank.getLastRecalled();
+
+        if (recalled != lastRecalled)
+        {
+            lastRecalled = recalled;
+
+            if (recalled >= 0)
+                selected = recalled;
+        }
+
+        update();
+    }
+
+    void select (int index)
+    {
+        selected = (index + SnapshotBank::numSnapshots) % SnapshotBank::numSnapshots;
+        update();
+    }
+
+    void update()
+    {
+        const auto isStored = bank.isStored (selected);
+
+        label.setText ("Snapshot " + String (selected + 1) + (isStored ? String() : " (empty)"), dontSendNotification);
+        recallButton.setEnabled (isStored);
+    }
+
+    SnapshotBank& bank;
+    int selected = 0, lastRecalled = -1;
+
+    TextButton previousButton { "<" }, nextButton { ">" }, storeButton { "Store" }, recallButton { "Recall" };
+    Label label;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SnapshotBar)
+};
+
 class GraphDocumentComponent::PluginListBoxModel final : public ListBoxModel,
                                                           public ChangeListener,
                                                           public MouseListener
@@ -1495,9 +1633,10 @@ GraphDocumentComponent::~GraphDocumentComponent()
     if (graph)
         graph->closeAnyOpenPluginWindows();
 
+    statusBar.reset();
+    snapshotBar.reset();
     graph.reset();
     pluginListBoxModel.reset();
-    statusBar.reset();
     graphPanel.reset();
 }
 
@@ -1521,11 +1660,18 @@ void GraphDocumentComponent::init()
 {
     graphPanel.reset (new GraphEditorPanel (*graph));
     addAndMakeVisible (graphPanel.get());
-    graphPlayer.setProcessor (&graph->graph);
+    graph->renderer.setParallelRenderingEnabled (getAppProperties().getUserSettings()->getBoolValue ("parallelRendering", true));
+    graph->renderer.setPipelinedRenderingEnabled (getAppProperties().getUserSettings()->getBoolValue ("pipelinedRendering", false));
+    graph->renderer.setBypassSpilloverEnabled (getAppProperties().getUserSettings()->getBoolValue ("bypassSpillover", false));
+    graphPlayer.setProcessor (&graph->renderer);
 
-    statusBar.reset (new TooltipBar());
+    statusBar.reset (new TooltipBar (graph->renderer));
     addAndMakeVisible (statusBar.get());
 
+    graph->snapshots.setFootswitch (getAppProperties().getUserSettings()->getIntValue ("snapshotFootswitch", 0));
+    snapshotBar.reset (new SnapshotBar (graph->snapshots));
+    addAndMakeVisible (snapshotBar.get());
+
     graphPanel->updateComponents();
 
     pluginListBoxModel.reset (new PluginListBoxModel (pluginListBox, pluginList));
@@ -1556,7 +1702,9 @@ void GraphDocumentComponent::resized()
 
     const int statusHeight = 26;
 
-    statusBar->setBounds (r.removeFromBottom (statusHeight));
+    auto statusArea = r.removeFromBottom (statusHeight);
+    snapshotBar->setBounds (statusArea.removeFromLeft (300));
+    statusBar->setBounds (statusArea);
     graphPanel->setBounds (r);
 
     checkAvailableWidth();
@@ -1593,7 +1741,25 @@ void GraphDocumentComponent::createNewPlugin (const PluginDescriptionAndPreferen
 void GraphDocumentComponent::setDoublePrecision (bool)
 {
     graphPlayer.setProcessor (nullptr);
-    graphPlayer.setProcessor (&graph->graph);
+    graphPlayer.setProcessor (&graph->renderer);
+}
+
+void GraphDocumentComponent::setParallelRendering (bool shouldBeEnabled)
+{
+    if (graph)
+        graph->renderer.setParallelRenderingEnabled (shouldBeEnabled);
+}
+
+void GraphDocumentComponent::setPipelinedRendering (bool shouldBeEnabled)
+{
+    if (graph)
+        graph->renderer.setPipelinedRenderingEnabled (shouldBeEnabled);
+}
+
+void GraphDocumentComponent::setBypassSpillover (bool shouldBeEnabled)
+{
+    if (graph)
+        graph->renderer.setBypassSpilloverEnabled (shouldBeEnabled);
 }
 
 bool GraphDocumentComponent::closeAnyOpenPluginWindows()
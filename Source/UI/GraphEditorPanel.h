@@ -147,6 +147,9 @@ public:
     //==============================================================================
     void createNewPlugin (const PluginDescriptionAndPreference&, Point<int> position);
     void setDoublePrecision (bool doublePrecision);
+    void setParallelRendering (bool shouldBeEnabled);
+    void setPipelinedRendering (bool shouldBeEnabled);
+    void setBypassSpillover (bool shouldBeEnabled);
     bool closeAnyOpenPluginWindows();
 
     //==============================================================================
@@ -180,6 +183,9 @@ private:
     struct TooltipBar;
     std::unique_ptr<TooltipBar> statusBar;
 
+    struct SnapshotBar;
+    std::unique_ptr<SnapshotBar> snapshotBar;
+
     //==============================================================================
     struct PluginListBoxModel;
     std::unique_ptr<PluginListBoxModel> pluginListBoxModel;
@@ -0,0 +1,186 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE framework.
+   Copyright (c) Raw Material Software Limited
+
+   JUCE is an open source framework subject to commercial or open source
+   licensing.
+
+   By downloading, installing, or using the JUCE framework, or combining the
+   JUCE framework with any other source code, object code, content or any other
+   copyrightable work, you agree to the terms of the JUCE End User Licence
+   Agreement, and all incorporated terms including the JUCE Privacy Policy and
+   the JUCE Website Terms of Service, as applicable, which will bind you. If you
+   do not agree to the terms of these agreements, we will not license the JUCE
+   framework to you, and you must discontinue the installation or download
+   process and cease use of the JUCE framework.
+
+   JUCE End User Licence Agreement: https://juce.com/legal/juce-8-licence/
+   JUCE Privacy Policy: https://juce.com/juce-privacy-policy
+   JUCE Website Terms of Service: https://juce.com/juce-website-terms-of-service/
+
+   Or:
+
+   You may also use this code under the terms of the AGPLv3:
+   https://www.gnu.org/licenses/agpl-3.0.en.html
+
+   THE JUCE FRAMEWORK IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL
+   WARRANTIES, WHETHER EXPRESSED OR IMPLIED, INCLUDING WARRANTY OF
+   MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+
+#include <JuceHeader.h>
+#include "LatencyInspector.h"
+
+namespace
+{
+    enum ColumnIds
+    {
+        nameColumn = 1,
+        ownSamplesColumn,
+        ownMsColumn,
+        atOutputSamplesColumn,
+        atOutputMsColumn
+    };
+
+    constexpr int summaryHeight = 40;
+}
+
+//==============================================================================
+LatencyInspector::LatencyInspector (PluginGraph& g, AudioDeviceManager& dm)
+    : graph (g),
+      deviceManager (dm)
+{
+    auto& header = table.getHeader();
+    header.addColumn ("Stage",             nameColumn,            200, 100, 400, TableHeaderComponent::notSortable);
+    header.addColumn ("Own (samples)",     ownSamplesColumn,      90,  60,  150, TableHeaderComponent::notSortable);
+    header.addColumn ("Own (ms)",          ownMsColumn,           70,  50,  150, TableHeaderComponent::notSortable);
+    header.addColumn ("Total (samples)",   atOutputSamplesColumn, 90,  60,  150, TableHeaderComponent::notSortable);
+    header.addColumn ("Total (ms)",        atOutputMsColumn,      70,  50,  150, TableHeaderComponent::notSortable);
+
+    table.setModel (this);
+    addAndMakeVisible (table);
+
+    refresh();
+    startTimer (500);
+}
+
+LatencyInspector::~LatencyInspector()
+{
+    table.setModel (nullptr);
+}
+
+//==============================================================================
+void LatencyInspector::refresh()
+{
+    rows.clear();
+
+    auto* device = deviceManager.getCurrentAudioDevice();
+    sampleRate = device != nullptr ? device->getCurrentSampleRate() : graph.renderer.getSampleRate();
+
+    // the device's latencies include the driver's (e.g. ALSA's) buffering
+    const auto inputLatency  = device != nullptr ? device->getInputLatencyInSamples() : 0;
+    const auto blockSize     = device != nullptr ? device->getCurrentBufferSizeSamples() : graph.renderer.getBlockSize();
+    const auto outputLatency = device != nullptr ? device->getOutputLatencyInSamples() : 0;
+
+    // one block is always spent between reading the input and writing the output
+    const auto graphStart = inputLatency + blockSize;
+
+    rows.push_back ({ "Audio input (device buffer)", inputLatency, inputLatency });
+    rows.push_back ({ "Processing block",            blockSize,    graphStart });
+
+    std::vector<AudioProcessorGraph::Node*> nodes (graph.graph.getNodes().begin(), graph.graph.getNodes().end());
+
+    std::stable_sort (nodes.begin(), nodes.end(), [this] (auto* a, auto* b)
+    {
+        return graph.renderer.getNodeLatencyAtOutput (a->nodeID) < graph.renderer.getNodeLatencyAtOutput (b->nodeID);
+    });
+
+    for (auto* node : nodes)
+        if (auto* processor = node->getProcessor())
+            rows.push_back ({ processor->getName(),
+                              processor->getLatencySamples(),
+                              graphStart + graph.renderer.getNodeLatencyAtOutput (node->nodeID) });
+
+    const auto pipelineLatency = graph.renderer.getPipelineLatencySamples();
+
+    if (pipelineLatency > 0)
+        rows.push_back ({ "Pipelined rendering", pipelineLatency, graphStart + graph.renderer.getLatencySamples() });
+
+    totalLatency = graphStart + graph.renderer.getLatencySamples() + outputLatency;
+    rows.push_back ({ "Audio output (device buffer)", outputLatency, totalLatency });
+
+    table.updateContent();
+    repaint();
+}
+
+String LatencyInspector::toMs (int samples) const
+{
+    return sampleRate > 0.0 ? String (samples * 1000.0 / sampleRate, 2) : String ("-");
+}
+
+//==============================================================================
+void LatencyInspector::paint (Graphics& g)
+{
+    g.fillAll (getLookAndFeel().findColour (ResizableWindow::backgroundColourId));
+
+    const auto totalMs = sampleRate > 0.0 ? totalLatency * 1000.0 / sampleRate : 0.0;
+    const auto withinBudget = totalMs <= budgetMs;
+
+    g.setColour (withinBudget ? Colours::lightgreen : Colours::orangered);
+    g.setFont (FontOptions (16.0f, Font::bold));
+    g.drawFittedText ("Round trip: " + String (totalLatency) + " samples, " + toMs (totalLatency) + " ms"
+                        + (withinBudget ? " (within " : " (over ") + String (budgetMs, 0) + " ms budget)",
+                      getLocalBounds().removeFromBottom (summaryHeight).reduced (8, 0),
+                      Justification::centredLeft, 1);
+}
+
+void LatencyInspector::resized()
+{
+    table.setBounds (getLocalBounds().withTrimmedBottom (summaryHeight));
+}
+
+int LatencyInspector::getNumRows()
+{
+    return (int) rows.size();
+}
+
+void LatencyInspector::paintRowBackground (Graphics& g, int row, int, int, bool)
+{
+    const auto base = getLookAndFeel().findColour (ListBox::backgroundColourId);
+    g.fillAll (row % 2 == 0 ? base : base.brighter (0.05f));
+}
+
+void LatencyInspector::paintCell (Graphics& g, int row, int columnId, int width, int height, bool)
+{
+    if (! isPositiveAndBelow (row, (int) rows.size()))
+        return;
+
+    const auto& r = rows[(size_t) row];
+
+    String text;
+
+    switch (columnId)
+    {
+        case nameColumn:            text = r.name; break;
+        case ownSamplesColumn:      text = String (r.ownLatency); break;
+        case ownMsColumn:           text = toMs (r.ownLatency); break;
+        case atOutputSamplesColumn: text = String (r.latencyAtOutput); break;
+        case atOutputMsColumn:      text = toMs (r.latencyAtOutput); break;
+        default: break;
+    }
+
+    g.setColour (getLookAndFeel().findColour (ListBox::textColourId));
+    g.setFont (FontOptions ((float) height * 0.6f));
+    g.drawText (text, 4, 0, width - 8, height,
+                columnId == nameColumn ? Justification::centredLeft : Justification::centredRight, true);
+}
+
+void LatencyInspector::timerCallback()
+{
+    refresh();
+}
@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE framework.
+   Copyright (c) Raw Material Software Limited
+
+   JUCE is an open source framework subject to commercial or open source
+   licensing.
+
+   By downloading, installing, or using the JUCE framework, or combining the
+   JUCE framework with any other source code, object code, content or any other
+   copyrightable work, you agree to the terms of the JUCE End User Licence
+   Agreement, and all incorporated terms including the JUCE Privacy Policy and
+   the JUCE Website Terms of Service, as applicable, which will bind you. If you
+   do not agree to the terms of these agreements, we will not license the JUCE
+   framework to you, and you must discontinue the installation or download
+   process and cease use of the JUCE framework.
+
+   JUCE End User Licence Agreement: https://juce.com/legal/juce-8-licence/
+   JUCE Privacy Policy: https://juce.com/juce-privacy-policy
+   JUCE Website Terms of Service: https://juce.com/juce-website-terms-of-service/
+
+   Or:
+
+   You may also use this code under the terms of the AGPLv3:
+   https://www.gnu.org/licenses/agpl-3.0.en.html
+
+   THE JUCE FRAMEWORK IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL
+   WARRANTIES, WHETHER EXPRESSED OR IMPLIED, INCLUDING WARRANTY OF
+   MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+
+#pragma once
+
+#include "../Plugins/PluginGraph.h"
+
+//==============================================================================
+/**
+    Lists the latency of every node and the whole signal path, from the audio
+    device's input buffer through the graph to its output buffer, in samples
+    and milliseconds, against a round-trip budget.
+*/
+class LatencyInspector final : public Component,
+                               private TableListBoxModel,
+                               private Timer
+{
+public:
+    //==============================================================================
+    LatencyInspector (PluginGraph&, AudioDeviceManager&);
+    ~LatencyInspector() override;
+
+    /** The round trip that a board should stay below. */
+    static constexpr double budgetMs = 5.0;
+
+    //==============================================================================
+    void paint (Graphics&) override;
+    void resized() override;
+
+private:
+    //==============================================================================
+    struct Row
+    {
+        String name;
+        int ownLatency = 0;
+        int latencyAtOutput = 0;
+    };
+
+    PluginGraph& graph;
+    AudioDeviceManager& deviceManager;
+
+    TableListBox table;
+    std::vector<Row> rows;
+    int totalLatency = 0;
+    double sampleRate = 0.0;
+
+    void refresh();
+    String toMs (int samples) const;
+
+    int getNumRows() override;
+    void paintRowBackground (Graphics&, int row, int width, int height, bool selected) override;
+    void paintCell (Graphics&, int row, int columnId, int width, int height, bool selected) override;
+    void timerCallback() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LatencyInspector)
+};
@@ -35,6 +35,9 @@
 #include <JuceHeader.h>
 #include "MainHostWindow.h"
 #include "../Plugins/InternalPlugins.h"
+#include "../Plugins/ControlLatencyMeter.h"
+#include "LatencyInspector.h"
+#include "../Plugins/Fx/FxCommon.h"
 
 constexpr const char* scanModeKey = "pluginScanMode";
 
@@ -308,6 +311,44 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginListWindow)
 };
 
+//==============================================================================
+class MainHostWindow::LatencyInspectorWindow final : public DocumentWindow
+{
+public:
+    LatencyInspectorWindow (MainHostWindow& mw, PluginGraph& graph)
+        : DocumentWindow ("Latency Inspector",
+                          LookAndFeel::getDefaultLookAndFeel().findColour (ResizableWindow::backgroundColourId),
+                          DocumentWindow::minimiseButton | DocumentWindow::closeButton),
+          owner (mw)
+    {
+        setContentOwned (new LatencyInspector (graph, owner.deviceManager), false);
+
+        setResizable (true, false);
+        setResizeLimits (400, 200, 1000, 1200);
+        setSize (560, 400);
+        setTopLeftPosition (80, 80);
+
+        restoreWindowStateFromString (getAppProperties().getUserSettings()->getValue ("latencyWindowPos"));
+        setVisible (true);
+    }
+
+    ~LatencyInspectorWindow() override
+    {
+        getAppProperties().getUserSettings()->setValue ("latencyWindowPos", getWindowStateAsString());
+        clearContentComponent();
+    }
+
+    void closeButtonPressed() override
+    {
+        owner.latencyInspectorWindow = nullptr;
+    }
+
+private:
+    MainHostWindow& owner;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LatencyInspectorWindow)
+};
+
 //==============================================================================
 MainHostWindow::MainHostWindow()
     : DocumentWindow (JUCEApplication::getInstance()->getApplicationName(),
@@ -349,6 +390,9 @@ MainHostWindow::MainHostWindow()
 
     setContentNonOwned (graphHolder.get(), false);
 
+    if (isOpenGLRenderingEnabled())
+        setOpenGLRendering (true);
+
     setUsingNativeTitleBar (true);
 
     restoreWindowStateFromString (getAppProperties().getUserSettings()->getValue ("mainWindowPos"));
@@ -388,13 +432,34 @@ MainHostWindow::MainHostWindow()
 
     getCommandManager().setFirstCommandTarget (this);
 
-    hardwareInputService = std::make_unique<HardwareInputService>();
+    // the pedal's wiring comes from hardware.json next to the settings, unless the settings name another file
+    auto* userSettings = getAppProperties().getUserSettings();
+    const File hardwareConfigFile (userSettings->getValue ("hardwareConfigFile",
+                                                           userSettings->getFile().getSiblingFile ("hardware.json").getFullPathName()));
+
+    HardwareInputService::Settings hardwareSettings;
+
+    if (hardwareConfigFile.existsAsFile())
+    {
+        if (const auto result = HardwareConfig::load (hardwareConfigFile, hardwareSettings); result.failed())
+        {
+            DBG ("Ignoring the hardware config: " << result.getErrorMessage());
+            hardwareSettings = {};
+        }
+    }
+
+    hardwareInputService = std::make_unique<HardwareInputService> (hardwareSettings);
     hardwareInputService->start();
+
+    hardwareConfigWatcher = std::make_unique<HardwareConfig::FileWatcher> (*hardwareInputService, hardwareConfigFile);
 }
 
 MainHostWindow::~MainHostWindow()
 {
     pluginListWindow = nullptr;
+    latencyInspectorWindow = nullptr;
+
+    hardwareConfigWatcher = nullptr;
 
     if (hardwareInputService != nullptr)
         hardwareInputService->stop();
@@ -406,6 +471,7 @@ MainHostWindow::~MainHostWindow()
         g->removeChangeListener (this);
 
     getAppProperties().getUserSettings()->setValue ("mainWindowPos", getWindowStateAsString());
+    setOpenGLRendering (false);
     clearContentComponent();
 
   #if ! (JUCE_ANDROID || JUCE_IOS)
@@ -461,6 +527,12 @@ void MainHostWindow::tryToQuitApplication()
     {
         auto releaseAndQuit = [this]
         {
+            // a clean shutdown leaves nothing to recover
+            if (graphHolder->graph != nullptr)
+                graphHolder->graph->discardJournal();
+
+            latencyInspectorWindow = nullptr;
+
             // Some plug-ins do not want [NSApp stop] to be called
             // before the plug-ins are not deallocated.
             graphHolder->releaseGraph();
@@ -548,6 +620,7 @@ PopupMenu MainHostWindow::getMenuForIndex (int topLevelMenuIndex, const String&
        #if ! (JUCE_IOS || JUCE_ANDROID)
         menu.addCommandItem (&getCommandManager(), CommandIDs::save);
         menu.addCommandItem (&getCommandManager(), CommandIDs::saveAs);
+        menu.addCommandItem (&getCommandManager(), CommandIDs::exportXml);
        #endif
 
         menu.addSeparator();
@@ -579,6 +652,30 @@ PopupMenu MainHostWindow::getMenuForIndex (int topLevelMenuIndex, const String&
         menu.addSeparator();
         menu.addCommandItem (&getCommandManager(), CommandIDs::showAudioSettings);
         menu.addCommandItem (&getCommandManager(), CommandIDs::toggleDoublePrecision);
+        menu.addCommandItem (&getCommandManager(), CommandIDs::toggleParallelRendering);
+        menu.addCommandItem (&getCommandManager(), CommandIDs::togglePipelinedRendering);
+        menu.addCommandItem (&getCommandManager(), CommandIDs::toggleBypassSpillover);
+        menu.addCommandItem (&getCommandManager(), CommandIDs::toggleOpenGLRendering);
+
+        const auto crossfadeMs = getAppProperties().getUserSettings()->getIntValue ("presetCrossfadeMs", 25);
+
+        PopupMenu crossfadeMenu;
+        crossfadeMenu.addItem (210, "No Crossfade",  true, crossfadeMs == 0);
+        crossfadeMenu.addItem (211, "10 ms",         true, crossfadeMs == 10);
+        crossfadeMenu.addItem (212, "25 ms",         true, crossfadeMs == 25);
+        crossfadeMenu.addItem (213, "50 ms",         true, crossfadeMs == 50);
+        crossfadeMenu.addItem (214, "100 ms",        true, crossfadeMs == 100);
+        menu.addSubMenu ("Preset Crossfade", crossfadeMenu);
+
+        const auto snapshotFootswitch = getAppProperties().getUserSettings()->getIntValue ("snapshotFootswitch", 0);
+
+        PopupMenu snapshotFootswitchMenu;
+        snapshotFootswitchMenu.addItem (215, "None", true, snapshotFootswitch == 0);
+
+        for (int i = 1; i <= FxCommon::getHardwareLayout().numSwitches; ++i)
+            snapshotFootswitchMenu.addItem (215 + i, "Footswitch " + String (i), true, snapshotFootswitch == i);
+
+        menu.addSubMenu ("Next Snapshot Footswitch", snapshotFootswitchMenu);
 
         if (autoScaleOptionAvailable)
             menu.addCommandItem (&getCommandManager(), CommandIDs::autoScalePluginWindows);
@@ -589,6 +686,10 @@ PopupMenu MainHostWindow::getMenuForIndex (int topLevelMenuIndex, const String&
     else if (topLevelMenuIndex == 3)
     {
         menu.addCommandItem (&getCommandManager(), CommandIDs::allWindowsForward);
+        menu.addCommandItem (&getCommandManager(), CommandIDs::showLatencyInspector);
+        menu.addSeparator();
+        menu.addCommandItem (&getCommandManager(), CommandIDs::toggleControlLatencyMeasurement);
+        menu.addCommandItem (&getCommandManager(), CommandIDs::exportControlLatency);
     }
 
     return menu;
@@ -638,6 +739,23 @@ void MainHostWindow::menuItemSelected (int menuItemID, int /*topLevelMenuIndex*/
 
         menuItemsChanged();
     }
+    else if (menuItemID >= 210 && menuItemID < 215)
+    {
+        static constexpr int crossfadeTimes[] { 0, 10, 25, 50, 100 };
+        getAppProperties().getUserSettings()->setValue ("presetCrossfadeMs", crossfadeTimes[menuItemID - 210]);
+
+        menuItemsChanged();
+    }
+    else if (menuItemID >= 215 && menuItemID <= 215 + FxCommon::maxHardwareControls)
+    {
+        getAppProperties().getUserSettings()->setValue ("snapshotFootswitch", menuItemID - 215);
+
+        if (graphHolder != nullptr)
+            if (auto* graph = graphHolder->graph.get())
+                graph->snapshots.setFootswitch (menuItemID - 215);
+
+        menuItemsChanged();
+    }
     else
     {
         if (const auto chosen = getChosenType (menuItemID))
@@ -765,12 +883,20 @@ void MainHostWindow::getAllCommands (Array<CommandID>& commands)
                               CommandIDs::open,
                               CommandIDs::save,
                               CommandIDs::saveAs,
+                              CommandIDs::exportXml,
                              #endif
                               CommandIDs::showPluginListEditor,
                               CommandIDs::showAudioSettings,
                               CommandIDs::toggleDoublePrecision,
+                              CommandIDs::toggleParallelRendering,
+                              CommandIDs::togglePipelinedRendering,
+                              CommandIDs::toggleBypassSpillover,
                               CommandIDs::aboutBox,
                               CommandIDs::allWindowsForward,
+                              CommandIDs::showLatencyInspector,
+                              CommandIDs::toggleControlLatencyMeasurement,
+                              CommandIDs::exportControlLatency,
+                              CommandIDs::toggleOpenGLRendering,
                               CommandIDs::autoScalePluginWindows
                             };
 
@@ -805,6 +931,12 @@ void MainHostWindow::getCommandInfo (const CommandID commandID, ApplicationComma
                         category, 0);
         result.defaultKeypresses.add (KeyPress ('s', ModifierKeys::shiftModifier | ModifierKeys::commandModifier, 0));
         break;
+
+    case CommandIDs::exportXml:
+        result.setInfo ("Export as XML...",
+                        "Saves a copy of the current graph in the older XML format",
+                        category, 0);
+        break;
    #endif
 
     case CommandIDs::showPluginListEditor:
@@ -821,6 +953,22 @@ void MainHostWindow::getCommandInfo (const CommandID commandID, ApplicationComma
         updatePrecisionMenuItem (result);
         break;
 
+    case CommandIDs::toggleParallelRendering:
+        updateParallelRenderingMenuItem (result);
+        break;
+
+    case CommandIDs::togglePipelinedRendering:
+        updatePipelinedRenderingMenuItem (result);
+        break;
+
+    case CommandIDs::toggleBypassSpillover:
+        updateBypassSpilloverMenuItem (result);
+        break;
+
+    case CommandIDs::toggleOpenGLRendering:
+        updateOpenGLRenderingMenuItem (result);
+        break;
+
     case CommandIDs::aboutBox:
         result.setInfo ("About...", {}, category, 0);
         break;
@@ -834,6 +982,22 @@ void MainHostWindow::getCommandInfo (const CommandID commandID, ApplicationComma
         updateAutoScaleMenuItem (result);
         break;
 
+    case CommandIDs::showLatencyInspector:
+        result.setInfo ("Show Latency Inspector", "Shows the latency of every node and of the whole signal path", category, 0);
+        result.addDefaultKeypress ('l', ModifierKeys::commandModifier);
+        break;
+
+    case CommandIDs::toggleControlLatencyMeasurement:
+        updateControlLatencyMenuItem (result);
+        break;
+
+    case CommandIDs::exportControlLatency:
+        result.setInfo ("Export Control Latency Histogram...",
+                        "Saves the measured press-to-sound latencies as CSV",
+                        category, 0);
+        result.setActive (ControlLatencyMeter::getInstance().isEnabled());
+        break;
+
     default:
         break;
     }
@@ -883,6 +1047,10 @@ bool MainHostWindow::perform (const InvocationInfo& info)
         if (graphHolder != nullptr && graphHolder->graph != nullptr)
             graphHolder->graph->saveAsAsync ({}, true, true, true, nullptr);
         break;
+
+    case CommandIDs::exportXml:
+        exportGraphAsXml();
+        break;
    #endif
 
     case CommandIDs::showPluginListEditor:
@@ -911,6 +1079,65 @@ bool MainHostWindow::perform (const InvocationInfo& info)
         }
         break;
 
+    case CommandIDs::toggleParallelRendering:
+        if (auto* props = getAppProperties().getUserSettings())
+        {
+            auto newIsParallel = ! isParallelRenderingEnabled();
+            props->setValue ("parallelRendering", var (newIsParallel));
+
+            ApplicationCommandInfo cmdInfo (info.commandID);
+            updateParallelRenderingMenuItem (cmdInfo);
+            menuItemsChanged();
+
+            if (graphHolder != nullptr)
+                graphHolder->setParallelRendering (newIsParallel);
+        }
+        break;
+
+    case CommandIDs::togglePipelinedRendering:
+        if (auto* props = getAppProperties().getUserSettings())
+        {
+            auto newIsPipelined = ! isPipelinedRenderingEnabled();
+            props->setValue ("pipelinedRendering", var (newIsPipelined));
+
+            ApplicationCommandInfo cmdInfo (info.commandID);
+            updatePipelinedRenderingMenuItem (cmdInfo);
+            menuItemsChanged();
+
+            if (graphHolder != nullptr)
+                graphHolder->setPipelinedRendering (newIsPipelined);
+        }
+        break;
+
+    case CommandIDs::toggleBypassSpillover:
+        if (auto* props = getAppProperties().getUserSettings())
+        {
+            auto newIsSpillover = ! isBypassSpilloverEnabled();
+            props->setValue ("bypassSpillover", var (newIsSpillover));
+
+            ApplicationCommandInfo cmdInfo (info.commandID);
+            updateBypassSpilloverMenuItem (cmdInfo);
+            menuItemsChanged();
+
+            if (graphHolder != nullptr)
+                graphHolder->setBypassSpillover (newIsSpillover);
+        }
+        break;
+
+    case CommandIDs::toggleOpenGLRendering:
+        if (auto* props = getAppProperties().getUserSettings())
+        {
+            auto newIsOpenGL = ! isOpenGLRenderingEnabled();
+            props->setValue ("openGLRendering", var (newIsOpenGL));
+
+            ApplicationCommandInfo cmdInfo (info.commandID);
+            updateOpenGLRenderingMenuItem (cmdInfo);
+            menuItemsChanged();
+
+            setOpenGLRendering (newIsOpenGL);
+        }
+        break;
+
     case CommandIDs::autoScalePluginWindows:
         if (auto* props = getAppProperties().getUserSettings())
         {
@@ -927,6 +1154,38 @@ bool MainHostWindow::perform (const InvocationInfo& info)
         // TODO
         break;
 
+    case CommandIDs::toggleControlLatencyMeasurement:
+    {
+        auto& meter = ControlLatencyMeter::getInstance();
+
+        if (! meter.isEnabled())
+        {
+            // the audio callback can't see how long the driver takes to play a block
+            auto* device = deviceManager.getCurrentAudioDevice();
+            meter.setOutputLatency (device != nullptr ? device->getOutputLatencyInSamples() : 0);
+            meter.reset();
+        }
+
+        meter.setEnabled (! meter.isEnabled());
+
+        ApplicationCommandInfo cmdInfo (info.commandID);
+        updateControlLatencyMenuItem (cmdInfo);
+        menuItemsChanged();
+        break;
+    }
+
+    case CommandIDs::exportControlLatency:
+        exportControlLatencyHistogram();
+        break;
+
+    case CommandIDs::showLatencyInspector:
+        if (latencyInspectorWindow == nullptr && graphHolder != nullptr && graphHolder->graph != nullptr)
+            latencyInspectorWindow = std::make_unique<LatencyInspectorWindow> (*this, *graphHolder->graph);
+
+        if (latencyInspectorWindow != nullptr)
+            latencyInspectorWindow->toFront (true);
+        break;
+
     case CommandIDs::allWindowsForward:
     {
         auto& desktop = Desktop::getInstance();
@@ -981,6 +1240,102 @@ void MainHostWindow::showAudioSettings()
                          }), true);
 }
 
+void MainHostWindow::exportGraphAsXml()
+{
+    if (graphHolder == nullptr || graphHolder->graph == nullptr)
+        return;
+
+    const auto current = graphHolder->graph->getFile();
+    const auto initial = current.existsAsFile() ? current.withFileExtension (".xml")
+                                                : File::getSpecialLocation (File::userDocumentsDirectory);
+
+    exportChooser = std::make_unique<FileChooser> ("Export the graph as XML", initial, "*.xml");
+
+    exportChooser->launchAsync (FileBrowserComponent::saveMode
+                                  | FileBrowserComponent::canSelectFiles
+                                  | FileBrowserComponent::warnAboutOverwriting,
+                                [safeThis = SafePointer<MainHostWindow> (this)] (const FileChooser& fc)
+    {
+        const auto file = fc.getResult();
+
+        if (safeThis == nullptr || file == File() || safeThis->graphHolder == nullptr || safeThis->graphHolder->graph == nullptr)
+            return;
+
+        if (! safeThis->graphHolder->graph->createXml()->writeTo (file, {}))
+            AlertWindow::showMessageBoxAsync (MessageBoxIconType::WarningIcon,
+                                              "Export failed",
+                                              "Couldn't write to " + file.getFullPathName());
+    });
+}
+
+void MainHostWindow::exportControlLatencyHistogram()
+{
+    exportChooser = std::make_unique<FileChooser> ("Export the control latency histogram",
+                                                   File::getSpecialLocation (File::userDocumentsDirectory).getChildFile ("control-latency.csv"),
+                                                   "*.csv");
+
+    exportChooser->launchAsync (FileBrowserComponent::saveMode
+                                  | FileBrowserComponent::canSelectFiles
+                                  | FileBrowserComponent::warnAboutOverwriting,
+                                [] (const FileChooser& fc)
+    {
+        const auto file = fc.getResult();
+
+        if (file == File())
+            return;
+
+        if (! ControlLatencyMeter::getInstance().writeCsv (file))
+            AlertWindow::showMessageBoxAsync (MessageBoxIconType::WarningIcon,
+                                              "Export failed",
+                                              "Couldn't write to " + file.getFullPathName());
+    });
+}
+
+void MainHostWindow::setOpenGLRendering (bool shouldUseOpenGL)
+{
+    if (shouldUseOpenGL == (openGLContext != nullptr) || graphHolder == nullptr)
+        return;
+
+    if (! shouldUseOpenGL)
+    {
+        openGLContext->detach();
+        openGLContext = nullptr;
+        return;
+    }
+
+    // The components keep painting themselves as before, JUCE just renders them on the GPU:
+    // through Mesa that's VideoCore (vc4/v3d) on the Pi, and llvmpipe on a machine without a GPU
+    // (LIBGL_ALWAYS_SOFTWARE=1 under Xvfb), which is how the GL path can be tried headless.
+    openGLContextCreated.store (false);
+    openGLContext = std::make_unique<OpenGLContext>();
+    openGLContext->setRenderer (this);
+    openGLContext->setComponentPaintingEnabled (true);
+    openGLContext->setContinuousRepainting (false);
+    openGLContext->setSwapInterval (1);
+    openGLContext->attachTo (*graphHolder);
+
+    // the context is created on its own thread; if there's no usable driver it never calls
+    // newOpenGLContextCreated(), and the window goes back to the software renderer
+    Timer::callAfterDelay (3000, [safeThis = SafePointer<MainHostWindow> (this)]
+    {
+        if (safeThis == nullptr || safeThis->openGLContext == nullptr || safeThis->openGLContextCreated.load())
+            return;
+
+        DBG ("OpenGL isn't available, drawing the window in software");
+        safeThis->setOpenGLRendering (false);
+
+        if (auto* props = getAppProperties().getUserSettings())
+            props->setValue ("openGLRendering", var (false));
+
+        safeThis->menuItemsChanged();
+    });
+}
+
+void MainHostWindow::newOpenGLContextCreated()
+{
+    openGLContextCreated.store (true);
+}
+
 bool MainHostWindow::isInterestedInFileDrag (const StringArray&)
 {
     return true;
@@ -1005,7 +1360,8 @@ void MainHostWindow::filesDropped (const StringArray& files, int x, int y)
        #if ! (JUCE_ANDROID || JUCE_IOS)
         File firstFile { files[0] };
 
-        if (files.size() == 1 && firstFile.hasFileExtension (PluginGraph::getFilenameSuffix()))
+        // exported XML graphs can be dropped in as well
+        if (files.size() == 1 && firstFile.hasFileExtension (String (PluginGraph::getFilenameSuffix()) + ";xml"))
         {
             if (auto* g = graphHolder->graph.get())
             {
@@ -1043,6 +1399,38 @@ bool MainHostWindow::isDoublePrecisionProcessingEnabled()
     return false;
 }
 
+bool MainHostWindow::isParallelRenderingEnabled()
+{
+    if (auto* props = getAppProperties().getUserSettings())
+        return props->getBoolValue ("parallelRendering", true);
+
+    return true;
+}
+
+bool MainHostWindow::isPipelinedRenderingEnabled()
+{
+    if (auto* props = getAppProperties().getUserSettings())
+        return props->getBoolValue ("pipelinedRendering", false);
+
+    return false;
+}
+
+bool MainHostWindow::isBypassSpilloverEnabled()
+{
+    if (auto* props = getAppProperties().getUserSettings())
+        return props->getBoolValue ("bypassSpillover", false);
+
+    return false;
+}
+
+bool MainHostWindow::isOpenGLRenderingEnabled()
+{
+    if (auto* props = getAppProperties().getUserSettings())
+        return props->getBoolValue ("openGLRendering", false);
+
+    return false;
+}
+
 bool MainHostWindow::isAutoScalePluginWindowsEnabled()
 {
     if (auto* props = getAppProperties().getUserSettings())
@@ -1057,6 +1445,36 @@ void MainHostWindow::updatePrecisionMenuItem (ApplicationCommandInfo& info)
     info.setTicked (isDoublePrecisionProcessingEnabled());
 }
 
+void MainHostWindow::updateParallelRenderingMenuItem (ApplicationCommandInfo& info)
+{
+    info.setInfo ("Multi-Core Graph Rendering", {}, "General", 0);
+    info.setTicked (isParallelRenderingEnabled());
+}
+
+void MainHostWindow::updatePipelinedRenderingMenuItem (ApplicationCommandInfo& info)
+{
+    info.setInfo ("Pipelined Rendering (adds one block of latency per stage)", {}, "General", 0);
+    info.setTicked (isPipelinedRenderingEnabled());
+}
+
+void MainHostWindow::updateBypassSpilloverMenuItem (ApplicationCommandInfo& info)
+{
+    info.setInfo ("Let Delay Tails Ring Out When Bypassed", {}, "General", 0);
+    info.setTicked (isBypassSpilloverEnabled());
+}
+
+void MainHostWindow::updateControlLatencyMenuItem (ApplicationCommandInfo& info)
+{
+    info.setInfo ("Measure Footswitch and Pot Latency", {}, "General", 0);
+    info.setTicked (ControlLatencyMeter::getInstance().isEnabled());
+}
+
+void MainHostWindow::updateOpenGLRenderingMenuItem (ApplicationCommandInfo& info)
+{
+    info.setInfo ("Draw the Window with OpenGL", {}, "General", 0);
+    info.setTicked (isOpenGLRenderingEnabled());
+}
+
 void MainHostWindow::updateAutoScaleMenuItem (ApplicationCommandInfo& info)
 {
     info.setInfo ("Auto-Scale Plug-in Windows", {}, "General", 0);
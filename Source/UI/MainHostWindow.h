@@ -37,6 +37,7 @@
 #include "../Plugins/PluginGraph.h"
 #include "GraphEditorPanel.h"
 #include "../HardwareInputService.h"
+#include "../HardwareConfig.h"
 
 
 //==============================================================================
@@ -47,6 +48,7 @@ namespace CommandIDs
     static const int save                   = 0x30001;
     static const int saveAs                 = 0x30002;
     static const int newFile                = 0x30003;
+    static const int exportXml              = 0x30004;
    #endif
     static const int showPluginListEditor   = 0x30100;
     static const int showAudioSettings      = 0x30200;
@@ -54,6 +56,13 @@ namespace CommandIDs
     static const int allWindowsForward      = 0x30400;
     static const int toggleDoublePrecision  = 0x30500;
     static const int autoScalePluginWindows = 0x30600;
+    static const int toggleParallelRendering = 0x30700;
+    static const int togglePipelinedRendering = 0x30800;
+    static const int showLatencyInspector   = 0x30900;
+    static const int toggleBypassSpillover  = 0x30A00;
+    static const int toggleControlLatencyMeasurement = 0x30B00;
+    static const int exportControlLatency   = 0x30C00;
+    static const int toggleOpenGLRendering  = 0x30D00;
 }
 
 //==============================================================================
@@ -88,7 +97,8 @@ class MainHostWindow final : public DocumentWindow,
                              public MenuBarModel,
                              public ApplicationCommandTarget,
                              public ChangeListener,
-                             public FileDragAndDropTarget
+                             public FileDragAndDropTarget,
+                             private OpenGLRenderer
 {
 public:
     //==============================================================================
@@ -132,11 +142,27 @@ private:
     //==============================================================================
     static bool isDoublePrecisionProcessingEnabled();
     static bool isAutoScalePluginWindowsEnabled();
+    static bool isParallelRenderingEnabled();
+    static bool isPipelinedRenderingEnabled();
+    static bool isBypassSpilloverEnabled();
+    static bool isOpenGLRenderingEnabled();
 
     static void updatePrecisionMenuItem (ApplicationCommandInfo& info);
+    static void updateParallelRenderingMenuItem (ApplicationCommandInfo& info);
+    static void updatePipelinedRenderingMenuItem (ApplicationCommandInfo& info);
+    static void updateBypassSpilloverMenuItem (ApplicationCommandInfo& info);
     static void updateAutoScaleMenuItem (ApplicationCommandInfo& info);
+    static void updateControlLatencyMenuItem (ApplicationCommandInfo& info);
+    static void updateOpenGLRenderingMenuItem (ApplicationCommandInfo& info);
 
     void showAudioSettings();
+    void exportGraphAsXml();
+    void exportControlLatencyHistogram();
+    void setOpenGLRendering (bool shouldUseOpenGL);
+
+    void newOpenGLContextCreated() override;
+    void renderOpenGL() override {}
+    void openGLContextClosing() override {}
 
     //==============================================================================
     AudioDeviceManager deviceManager;
@@ -146,9 +172,21 @@ private:
     Array<PluginDescriptionAndPreference> pluginDescriptionsAndPreference;
 
     std::unique_ptr<HardwareInputService> hardwareInputService;
+    std::unique_ptr<HardwareConfig::FileWatcher> hardwareConfigWatcher;
 
     class PluginListWindow;
     std::unique_ptr<PluginListWindow> pluginListWindow;
 
+    class LatencyInspectorWindow;
+    std::unique_ptr<LatencyInspectorWindow> latencyInspectorWindow;
+
+    std::unique_ptr<FileChooser> exportChooser;
+
+    // only exists while the window content is drawn through OpenGL
+    std::unique_ptr<OpenGLContext> openGLContext;
+
+    // set on the GL thread once the context works; isActive() only answers for the calling thread
+    std::atomic<bool> openGLContextCreated { false };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainHostWindow)
 };
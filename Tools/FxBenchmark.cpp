@@ -0,0 +1,245 @@
+/*
+  ==============================================================================
+
+    FxBenchmark.cpp
+    Created: 17 Oct 2026 10:12:40am
+    Author:  motzi
+
+    Times the PitchShifter DSP per audio block, so changes to the filter
+    bank or the spectral engine can be checked on the Pi itself, and the
+    time it takes to load a graph document as XML and as binary:
+
+        FxBenchmark [sampleRate] [seconds]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "Fx/PitchShifter.h"
+#include "GraphDescription.h"
+
+#include <cstdio>
+#include <functional>
+#include <limits>
+
+namespace
+{
+    // keeps the optimiser from dropping the processing
+    volatile float sink = 0.0f;
+
+    struct Result
+    {
+        double microsPerBlock = 0.0;
+        double percentOfBudget = 0.0;
+    };
+
+    // A clean open chord (E2, B2, E3) plus a little noise, like a DI guitar
+    std::vector<float> createTestSignal (double sampleRate, int numSamples)
+    {
+        std::vector<float> signal ((size_t) numSamples);
+        juce::Random random (0x5eed);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto t = (double) i / sampleRate;
+            const auto chord = std::sin (juce::MathConstants<double>::twoPi * 82.41 * t)
+                             + 0.7 * std::sin (juce::MathConstants<double>::twoPi * 123.47 * t)
+                             + 0.5 * std::sin (juce::MathConstants<double>::twoPi * 164.81 * t);
+
+            signal[(size_t) i] = (float) (0.25 * chord) + 0.001f * (random.nextFloat() - 0.5f);
+        }
+
+        return signal;
+    }
+
+    // Runs processBlock over the whole signal once to warm up, then again
+    // under the timer. The best of a few runs hides scheduler noise.
+    Result timeBlocks (const std::vector<float>& signal, int blockSize, double sampleRate,
+                       const std::function<void (const float*, int)>& processBlock)
+    {
+        const auto numBlocks = (int) signal.size() / blockSize;
+
+        auto runOnce = [&]
+        {
+            const auto start = juce::Time::getHighResolutionTicks();
+
+            for (int b = 0; b < numBlocks; ++b)
+                processBlock (signal.data() + (size_t) b * (size_t) blockSize, blockSize);
+
+            return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+        };
+
+        runOnce();
+
+        auto best = std::numeric_limits<double>::max();
+
+        for (int run = 0; run < 3; ++run)
+            best = juce::jmin (best, runOnce());
+
+        Result result;
+        result.microsPerBlock = best * 1.0e6 / numBlocks;
+        result.percentOfBudget = 100.0 * result.microsPerBlock / (1.0e6 * blockSize / sampleRate);
+        return result;
+    }
+
+    void printResult (const char* name, int blockSize, const Result& result)
+    {
+        std::printf ("  %-32s %4d  %9.2f us  %6.2f %%\n", name, blockSize, result.microsPerBlock, result.percentOfBudget);
+    }
+
+    // A pedalboard of numNodes plug-ins, each with a state of stateSize random bytes
+    GraphDescription createTestGraph (int numNodes, size_t stateSize)
+    {
+        GraphDescription graph;
+        juce::Random random (0x5eed);
+
+        for (int i = 0; i < numNodes; ++i)
+        {
+            GraphDescription::Node node;
+            node.uid = (juce::uint32) i + 1;
+            node.description.name = "Fx " + juce::String (i + 1);
+            node.description.pluginFormatName = "Internal";
+            node.description.fileOrIdentifier = node.description.name;
+            node.description.numInputChannels = 2;
+            node.description.numOutputChannels = 2;
+            node.properties.set ("x", 0.1 + 0.05 * i);
+            node.properties.set ("y", 0.5);
+
+            node.ownedState.setSize (stateSize);
+            random.fillBitsRandomly (node.ownedState.getData(), stateSize);
+
+            graph.nodes.push_back (std::move (node));
+
+            if (i > 0)
+                for (int channel = 0; channel < 2; ++channel)
+                    graph.connections.push_back ({ (juce::uint32) i, channel, (juce::uint32) i + 1, channel });
+        }
+
+        return graph;
+    }
+
+    // Reads every state byte, as setStateInformation() would
+    juce::uint32 touchStates (const GraphDescription& graph)
+    {
+        juce::uint32 sum = 0;
+
+        for (const auto& node : graph.nodes)
+        {
+            const auto* data = static_cast<const juce::uint8*> (node.getStateData());
+
+            for (size_t i = 0; i < node.getStateSize(); ++i)
+                sum += data[i];
+        }
+
+        return sum;
+    }
+
+    // Best of a few loads in milliseconds; the files are in the page cache after the first one
+    double timeLoads (const std::function<std::unique_ptr<GraphDescription>()>& load)
+    {
+        auto best = std::numeric_limits<double>::max();
+
+        for (int run = 0; run < 5; ++run)
+        {
+            const auto start = juce::Time::getHighResolutionTicks();
+
+            if (auto graph = load())
+                sink += (float) touchStates (*graph);
+
+            best = juce::jmin (best, juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start));
+        }
+
+        return best * 1.0e3;
+    }
+
+    // The same two paths PluginGraph::loadDocument() takes
+    void benchmarkGraphLoading()
+    {
+        std::printf ("\nLoading a graph document\n");
+        std::printf ("  %-32s %10s  %10s  %10s\n", "", "size", "XML", "binary");
+
+        const juce::TemporaryFile xmlFile (".filtergraph"), binaryFile (".filtergraph");
+
+        for (auto stateSize : { (size_t) 2048, (size_t) 65536, (size_t) 1048576 })
+        {
+            const auto graph = createTestGraph (12, stateSize);
+
+            graph.toXml()->writeTo (xmlFile.getFile());
+            graph.saveBinary (binaryFile.getFile());
+
+            const auto xmlMillis = timeLoads ([&]() -> std::unique_ptr<GraphDescription>
+            {
+                if (auto xml = juce::parseXMLIfTagMatches (xmlFile.getFile(), "FILTERGRAPH"))
+                    return GraphDescription::fromXml (*xml);
+
+                return nullptr;
+            });
+
+            const auto binaryMillis = timeLoads ([&] { return GraphDescription::loadBinary (binaryFile.getFile()); });
+
+            const auto name = "12 nodes, " + juce::File::descriptionOfSizeInBytes ((juce::int64) stateSize) + " states";
+
+            std::printf ("  %-32s %10s  %7.2f ms  %7.2f ms\n", name.toRawUTF8(),
+                         juce::File::descriptionOfSizeInBytes (binaryFile.getFile().getSize()).toRawUTF8(),
+                         xmlMillis, binaryMillis);
+        }
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    const auto sampleRate = argc > 1 ? juce::String (argv[1]).getDoubleValue() : 48000.0;
+    const auto seconds = argc > 2 ? juce::String (argv[2]).getDoubleValue() : 10.0;
+
+    const auto signal = createTestSignal (sampleRate, (int) (sampleRate * seconds));
+
+    std::printf ("%.0f Hz, %.0f s of audio per run\n", sampleRate, seconds);
+    std::printf ("  %-32s %4s  %12s  %8s\n", "", "block", "per block", "budget");
+
+    for (auto blockSize : { 64, 128, 256 })
+    {
+        PolyOctaveFilterBank filterBank;
+        filterBank.prepare (sampleRate);
+
+        printResult ("PolyOctaveFilterBank", blockSize,
+                     timeBlocks (signal, blockSize, sampleRate, [&] (const float* in, int n)
+                     {
+                         for (int i = 0; i < n; ++i)
+                         {
+                             float down1 = 0.0f, down2 = 0.0f;
+                             filterBank.processSample (in[i], down1, down2);
+                             sink += down1 + down2;
+                         }
+                     }));
+
+        // octave mode with all four buttons, and the two harmony voices
+        const SpectralPitchEngine::Ratios octaves { 4.0, 2.0, 0.5, 0.25, 0.0, 0.0 };
+        const SpectralPitchEngine::Ratios harmony { 0.0, 0.0, 0.0, 0.0, 1.259921, 1.498307 };
+
+        for (auto order : { 10, 11 })
+        {
+            for (const auto* ratios : { &octaves, &harmony })
+            {
+                SpectralPitchEngine engine;
+                engine.prepare (order);
+
+                const auto name = juce::String ("SpectralPitchEngine ") + juce::String (1 << order)
+                                + (ratios == &octaves ? ", 4 voices" : ", 2 voices");
+
+                printResult (name.toRawUTF8(), blockSize,
+                             timeBlocks (signal, blockSize, sampleRate, [&] (const float* in, int n)
+                             {
+                                 for (int i = 0; i < n; ++i)
+                                 {
+                                     float dry = 0.0f;
+                                     sink += engine.processSample (in[i], *ratios, true, dry) + dry;
+                                 }
+                             }));
+            }
+        }
+    }
+
+    benchmarkGraphLoading();
+
+    return 0;
+}
@@ -0,0 +1,147 @@
+/*
+  ==============================================================================
+
+    TraceReplayTest.cpp
+    Created: 17 Oct 2026 4:05:51pm
+    Author:  motzi
+
+    Steps a recorded hardware trace through GpioBackend (one input record per
+    poll) and the footswitch bypass mapping of the internal Fx, and checks
+    that the switches come out as recorded and the LEDs follow them as they
+    did on the pedal:
+
+        TraceReplayTest <trace.pfxt>
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "GpioBackend.h"
+#include "HardwareTrace.h"
+#include "Fx/GainBoost.h"
+
+#include <cstdio>
+
+namespace
+{
+    struct Step
+    {
+        uint32_t switchBits = 0;
+        uint32_t ledBits = 0;
+    };
+
+    // The LED records after an input record are what the pedal showed in response to it
+    std::vector<Step> getRecordedSteps (const HardwareTrace::Reader& trace)
+    {
+        std::vector<Step> steps;
+        uint32_t ledBits = 0;
+
+        for (const auto& record : trace.getRecords())
+        {
+            if (record.type == HardwareTrace::Record::Type::input)
+                steps.push_back ({ record.input.switchBits, ledBits });
+            else if (! steps.empty())
+                steps.back().ledBits = ledBits = record.ledBits;
+        }
+
+        return steps;
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::printf ("usage: TraceReplayTest <trace.pfxt>\n");
+        return 2;
+    }
+
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const auto traceFile = juce::File::getCurrentWorkingDirectory().getChildFile (argv[1]);
+    const HardwareTrace::Reader trace (traceFile);
+
+    if (! trace.loadedOk())
+    {
+        std::printf ("can't read %s\n", traceFile.getFullPathName().toRawUTF8());
+        return 1;
+    }
+
+    GpioBackend::Config config;
+    config.replayTraceFile = traceFile;
+    config.replaySpeed = 0.0;
+
+    GpioBackend backend (config);
+
+    if (! backend.initialise() || ! backend.isReplaying())
+    {
+        std::printf ("GpioBackend didn't start replaying %s\n", traceFile.getFullPathName().toRawUTF8());
+        return 1;
+    }
+
+    FxCommon::setHardwareLayout ({ backend.getNumAnalogInputs(), backend.getNumSwitches(), backend.getNumLeds() });
+
+    // one pedal per footswitch, its bypass mapped to the switch as in a session
+    std::vector<std::unique_ptr<GainBoostProcessor>> pedals;
+
+    for (int i = 0; i < backend.getNumSwitches(); ++i)
+    {
+        pedals.push_back (std::make_unique<GainBoostProcessor>());
+        FxCommon::setAssignmentFromDropdown (FxCommon::makeRuntimeNodeId (pedals.back().get()), "bypass",
+                                             FxCommon::toString (FxCommon::ModulationSource::footswitch (i)));
+    }
+
+    const auto steps = getRecordedSteps (trace);
+    int failures = 0;
+
+    auto expect = [&failures] (bool condition, size_t step, const char* what, uint32_t actual, uint32_t expected)
+    {
+        if (condition)
+            return;
+
+        std::printf ("step %d: %s 0x%x, expected 0x%x\n", (int) step, what, (unsigned) actual, (unsigned) expected);
+        ++failures;
+    };
+
+    for (size_t step = 0; step < steps.size(); ++step)
+    {
+        if (backend.hasReplayFinished())
+        {
+            std::printf ("step %d: replay finished early\n", (int) step);
+            ++failures;
+            break;
+        }
+
+        GpioBackend::InputState state;
+        backend.pollInputs (state);
+        FxCommon::setHardwareSwitchBits (state.switchBits, state.switchEdgeSeconds);
+
+        for (auto& pedal : pedals)
+            FxCommon::applyMappedBypassFromHardware (pedal.get(), dynamic_cast<juce::AudioParameterBool*> (pedal->getBypassParameter()));
+
+        backend.setLedStates (FxCommon::getRequestedHardwareLedBits());
+
+        expect (state.switchBits == steps[step].switchBits, step, "switches", state.switchBits, steps[step].switchBits);
+        expect (backend.getLedStates() == steps[step].ledBits, step, "LEDs", backend.getLedStates(), steps[step].ledBits);
+    }
+
+    // the poll after the last input record passes the trailing LED records and keeps the switches
+    GpioBackend::InputState state;
+    backend.pollInputs (state);
+
+    const auto lastSwitchBits = steps.empty() ? 0u : steps.back().switchBits;
+
+    if (! backend.hasReplayFinished())
+    {
+        std::printf ("replay not finished after %d steps\n", (int) steps.size());
+        ++failures;
+    }
+
+    expect (state.switchBits == lastSwitchBits, steps.size(), "switches after the end", state.switchBits, lastSwitchBits);
+
+    for (auto& pedal : pedals)
+        FxCommon::forgetRuntimeNode (pedal.get());
+
+    std::printf ("%s: %d steps, %d failures\n", traceFile.getFileName().toRawUTF8(), (int) steps.size(), failures);
+    return failures == 0 ? 0 : 1;
+}